@@ -26,24 +26,13 @@
 #include "PID.h"
 #include "serial.h"
 
-typedef struct {
-    PIDpar_t gain;      // PID gains
-    double prev_error;  // Previous error
-    double prev_tagpos; // previous target position
-    double integral;    // Integral term
-    double *pidIarray;  // array for Integral
-    struct timespec prevT; // time of previous correction
-    size_t pidIarrSize; // it's size
-    size_t curIidx;     // and index of current element
-} PIDController_t;
-
 typedef struct{
     axis_status_t state;
     coordval_t position;
     coordval_t speed;
 } axisdata_t;
 
-static PIDController_t *pid_create(const PIDpar_t *gain, size_t Iarrsz){
+PIDController_t *pid_create(const PIDpar_t *gain, size_t Iarrsz){
     if(!gain || Iarrsz < 3) return NULL;
     PIDController_t *pid = (PIDController_t*)calloc(1, sizeof(PIDController_t));
     pid->gain = *gain;
@@ -55,7 +44,7 @@ static PIDController_t *pid_create(const PIDpar_t *gain, size_t Iarrsz){
 }
 
 // don't clear lastT!
-static void pid_clear(PIDController_t *pid){
+void pid_clear(PIDController_t *pid){
     if(!pid) return;
     DBG("CLEAR PID PARAMETERS");
     bzero(pid->pidIarray, sizeof(double) * pid->pidIarrSize);
@@ -64,65 +53,123 @@ static void pid_clear(PIDController_t *pid){
     pid->curIidx = 0;
     curtime(&pid->prevT);
 }
-/*
-static void pid_delete(PIDController_t **pid){
+
+void pid_delete(PIDController_t **pid){
     if(!pid || !*pid) return;
     if((*pid)->pidIarray) free((*pid)->pidIarray);
     free(*pid);
     *pid = NULL;
-}*/
+}
+
+/**
+ * @brief pid_step - PID core (doesn't depend on time and configuration)
+ * @param pid - PID
+ * @param error - current error (target - position)
+ * @param dt - time from previous step
+ * @param tagspeed - target speed (feed-forward)
+ * @param vmax - max speed of axis: integral isn't collected while output is saturated (anti-windup)
+ * @return new speed
+ */
+double pid_step(PIDController_t *pid, double error, double dt, double tagspeed, double vmax){
+    double derivative = (error - pid->prev_error) / dt;
+    pid->prev_error = error;
+    // calculate flowing integral
+    double oldi = pid->pidIarray[pid->curIidx], newi = error * dt;
+    //DBG("oldi/new: %g, %g", oldi, newi);
+    double sum = pid->gain.P * error + pid->gain.I * (pid->integral + newi - oldi) + pid->gain.D * derivative + tagspeed;
+    // conditional integration: don't integrate error pushing saturated output further
+    if(fabs(sum) > vmax && error * sum > 0.){
+        //DBG("Output saturated: don't integrate");
+        sum -= pid->gain.I * newi;
+        newi = 0.;
+    }
+    pid->pidIarray[pid->curIidx++] = newi;
+    if(pid->curIidx >= pid->pidIarrSize) pid->curIidx = 0;
+    pid->integral += newi - oldi;
+    return sum;
+}
 
-// calculate new motor speed
-static double pid_calculate(PIDController_t *pid, double axispos, const coordval_t *target){
+/**
+ * @brief pid_endpoint - far enough point to move with given speed (to stop in case of hang):
+ *      allow 10s moving but not more than 10deg and not less than 1deg
+ * @param pos - current position
+ * @param speed - speed (its sign gives direction)
+ * @return endpoint
+ */
+double pid_endpoint(double pos, double speed){
+    double adder = fabs(speed) * 10.;
+    if(adder > 0.17453) adder = 0.17453;
+    else if(adder < 0.017453) adder = 0.017453;
+    return (speed < 0.) ? pos - adder : pos + adder;
+}
+
+/**
+ * @brief pid_calculate - calculate new motor speed
+ * @param pid - PID
+ * @param axispos - current axis position
+ * @param target - target position
+ * @param ff - target speed for feed-forward (or NAN to calculate it by subsequent target positions)
+ * @param vmax - max speed of axis: integral isn't collected while output is saturated (anti-windup)
+ * @return speed
+ */
+static double pid_calculate(PIDController_t *pid, double axispos, const coordval_t *target, double ff, double vmax){
     double dtpid = timediff(&target->t, &pid->prevT);
-    if(dtpid < 0 || dtpid > Conf.PIDMaxDt){
+    if(dtpid < 0 || dtpid > Inst->Conf.PIDMaxDt){
         DBG("time diff too big: clear PID");
         pid_clear(pid);
         pid->prev_tagpos = target->val;
-        return 0.;
+        return isnan(ff) ? 0. : ff;
     }
     double dt = timediff(&target->t, &pid->prevT);
     if(dt < FLT_EPSILON){
         DBG("Target time in past");
-        return 0.;
+        return isnan(ff) ? 0. : ff;
     }
     pid->prevT = target->t;
     double error = target->val - axispos;
-    double tagspeed = (target->val - pid->prev_tagpos) / dt;
+    double tagspeed = isnan(ff) ? (target->val - pid->prev_tagpos) / dt : ff;
     pid->prev_tagpos = target->val;
-    // calculate flowing integral
-    double oldi = pid->pidIarray[pid->curIidx], newi = error * dt;
-    //DBG("oldi/new: %g, %g", oldi, newi);
-    pid->pidIarray[pid->curIidx++] = newi;
-    if(pid->curIidx >= pid->pidIarrSize) pid->curIidx = 0;
-    pid->integral += newi - oldi;
-    double derivative = (error - pid->prev_error) / dt;
-    pid->prev_error = error;
     DBG("pid pars: P=%g, I=%g, D=%f", pid->gain.P, pid->gain.I, pid->gain.D);
-    double sum = pid->gain.P * error + pid->gain.I * pid->integral + pid->gain.D * derivative + tagspeed;
-    DBG("tagspeed=%g, P=%g, I=%g, D=%g; sum=%g", tagspeed, pid->gain.P * error,
-        pid->gain.I * pid->integral, pid->gain.D * derivative, sum);
+    double sum = pid_step(pid, error, dt, tagspeed, vmax);
+    DBG("tagspeed=%g, P=%g, I=%g; sum=%g", tagspeed, pid->gain.P * error, pid->gain.I * pid->integral, sum);
     return sum;
 }
 
 /**
  * @brief process - Process PID for given axis
- * @param tagpos - given coordinate of target position
- * @param endpoint - endpoint for this coordinate
+ * @param tag - target position (and speed/acceleration if known)
  * @param pid - pid itself
+ * @param axis - axis data
+ * @param vmax - max speed of axis
  * @return calculated NEW SPEED or NAN for max speed
  */
-static double getspeed(const coordval_t *tagpos, PIDController_t *pid, axisdata_t *axis){
-    double dt = timediff(&tagpos->t, &axis->position.t);
-    if(dt < 0 || dt > Conf.PIDMaxDt){
-        DBG("target time: %ld, axis time: %ld - too big! (tag-ax=%g)", tagpos->t.tv_sec, axis->position.t.tv_sec, dt);
-        return axis->speed.val; // data is too old or wrong
+static double getspeed(const targval_t *tag, PIDController_t *pid, axisdata_t *axis, double vmax){
+    coordval_t tagpos = {.val = tag->val, .t = tag->t};
+    double ff = NAN;
+    double dt = timediff(&tagpos.t, &axis->position.t);
+    if(isnan(tag->speed)){
+        if(dt < 0 || dt > Inst->Conf.PIDMaxDt){
+            DBG("target time: %ld, axis time: %ld - too big! (tag-ax=%g)", tagpos.t.tv_sec, axis->position.t.tv_sec, dt);
+            return axis->speed.val; // data is too old or wrong
+        }
+    }else{ // move target to time of axis measurement, feed-forward by target speed
+        if(fabs(dt) > Inst->Conf.PIDMaxDt){
+            DBG("target time: %ld, axis time: %ld - too big! (tag-ax=%g)", tagpos.t.tv_sec, axis->position.t.tv_sec, dt);
+            return axis->speed.val;
+        }
+        double a = isnan(tag->accel) ? 0. : tag->accel;
+        tagpos.val -= (tag->speed - a * dt / 2.) * dt;
+        tagpos.t = axis->position.t;
+        // speed at the middle of interval till next correction
+        struct timespec now;
+        curtime(&now);
+        ff = tag->speed + a * (timediff(&now, &tag->t) + Inst->Conf.PIDRefreshDt / 2.);
     }
-    double error = tagpos->val - axis->position.val, fe = fabs(error);
+    double error = tagpos.val - axis->position.val, fe = fabs(error);
     DBG("error: %g'', cur speed: %g (deg/s)", error * 180. * 3600. / M_PI, axis->speed.val*180./M_PI);
     switch(axis->state){
         case AXIS_SLEWING:
-            if(fe < Conf.MaxFinePointingErr){
+            if(fe < Inst->Conf.MaxFinePointingErr){
                 axis->state = AXIS_POINTING;
                 DBG("--> Pointing");
             }else{
@@ -131,20 +178,20 @@ static double getspeed(const coordval_t *tagpos, PIDController_t *pid, axisdata_
             }
             break;
         case AXIS_POINTING:
-            if(fe < Conf.MaxFinePointingErr){
+            if(fe < Inst->Conf.MaxFinePointingErr){
                 axis->state = AXIS_GUIDING;
                 DBG("--> Guiding");
-            }else if(fe > Conf.MaxPointingErr){
+            }else if(fe > Inst->Conf.MaxPointingErr){
                 DBG("--> Slewing");
                 axis->state = AXIS_SLEWING;
                 return NAN;
             }
             break;
         case AXIS_GUIDING:
-            if(fe > Conf.MaxFinePointingErr){
+            if(fe > Inst->Conf.MaxFinePointingErr){
                 DBG("--> Pointing");
                 axis->state = AXIS_POINTING;
-            }else if(fe < Conf.MaxGuidingErr){
+            }else if(fe < Inst->Conf.MaxGuidingErr){
                 DBG("At target");
                 // TODO: we can point somehow that we are at target or introduce new axis state
             }else DBG("Current abs error: %g", fe);
@@ -153,7 +200,7 @@ static double getspeed(const coordval_t *tagpos, PIDController_t *pid, axisdata_
         case AXIS_STOPPED: // start pointing to target; will change speed next time
             DBG("AXIS STOPPED!!!! --> Slewing");
             axis->state = AXIS_SLEWING;
-            return getspeed(tagpos, pid, axis);
+            return getspeed(tag, pid, axis, vmax);
         case AXIS_ERROR:
             DBG("Can't move from erroneous state");
             return 0.;
@@ -162,53 +209,57 @@ static double getspeed(const coordval_t *tagpos, PIDController_t *pid, axisdata_
         DBG("WTF? Where is a PID?");
         return axis->speed.val;
     }
-    return pid_calculate(pid, axis->position.val, tagpos);
+    return pid_calculate(pid, axis->position.val, &tagpos, ff, vmax);
 }
 
 /**
- * @brief correct2 - recalculate PID and move telescope to new point with new speed
- * @param target - target position (for error calculations)
- * @param endpoint - stop point (some far enough point to stop in case of hang)
+ * @brief correct2ff - recalculate PID and move telescope to new point with new speed; if target speed is known,
+ *      it is used as feed-forward and PID works only on residual
+ * @param target - target position, speed and acceleration
  * @return error code
  */
-mcc_errcodes_t correct2(const coordval_pair_t *target){
-    static PIDController_t *pidX = NULL, *pidY = NULL;
-    if(!pidX){
-        pidX = pid_create(&Conf.XPIDV, Conf.PIDCycleDt / Conf.PIDRefreshDt);
-        if(!pidX) return MCC_E_FATAL;
+mcc_errcodes_t correct2ff(const targval_pair_t *target){
+    if(!target) return MCC_E_BADFORMAT;
+    pid_state_t *P = &Inst->pid;
+    double tnow = timefromstart();
+    if(P->tprev >= 0.) hist_add(&Inst->Stats.pidPeriod, tnow - P->tprev);
+    P->tprev = tnow;
+    if(!P->X){
+        P->X = pid_create(&Inst->Conf.XPIDV, Inst->Conf.PIDCycleDt / Inst->Conf.PIDRefreshDt);
+        if(!P->X) return MCC_E_FATAL;
     }
-    if(!pidY){
-        pidY = pid_create(&Conf.YPIDV, Conf.PIDCycleDt / Conf.PIDRefreshDt);
-        if(!pidY) return MCC_E_FATAL;
+    if(!P->Y){
+        P->Y = pid_create(&Inst->Conf.YPIDV, Inst->Conf.PIDCycleDt / Inst->Conf.PIDRefreshDt);
+        if(!P->Y) return MCC_E_FATAL;
     }
     mountdata_t m;
     coordpair_t tagspeed; // absolute value of speed
     double Xsign = 1., Ysign = 1.; // signs of speed (for target calculation)
-    if(MCC_E_OK != Mount.getMountData(&m)) return MCC_E_FAILED;
+    if(MCC_E_OK != getMD(&m)) return MCC_E_FAILED;
     axisdata_t axis;
     DBG("state: %d/%d", m.Xstate, m.Ystate);
     axis.state = m.Xstate;
     axis.position = m.encXposition;
     axis.speed = m.encXspeed;
-    tagspeed.X = getspeed(&target->X, pidX, &axis);
+    tagspeed.X = getspeed(&target->X, P->X, &axis, Inst->Xlimits.max.speed);
     if(isnan(tagspeed.X)){ // max speed
         if(target->X.val < axis.position.val) Xsign = -1.;
-        tagspeed.X = Xlimits.max.speed;
+        tagspeed.X = Inst->Xlimits.max.speed;
     }else{
         if(tagspeed.X < 0.){ tagspeed.X = -tagspeed.X; Xsign = -1.; }
-        if(tagspeed.X > Xlimits.max.speed) tagspeed.X = Xlimits.max.speed;
+        if(tagspeed.X > Inst->Xlimits.max.speed) tagspeed.X = Inst->Xlimits.max.speed;
     }
     axis_status_t xstate = axis.state;
     axis.state = m.Ystate;
     axis.position = m.encYposition;
     axis.speed = m.encYspeed;
-    tagspeed.Y = getspeed(&target->Y, pidY, &axis);
+    tagspeed.Y = getspeed(&target->Y, P->Y, &axis, Inst->Ylimits.max.speed);
     if(isnan(tagspeed.Y)){ // max speed
         if(target->Y.val < axis.position.val) Ysign = -1.;
-        tagspeed.Y = Ylimits.max.speed;
+        tagspeed.Y = Inst->Ylimits.max.speed;
     }else{
         if(tagspeed.Y < 0.){ tagspeed.Y = -tagspeed.Y; Ysign = -1.; }
-        if(tagspeed.Y > Ylimits.max.speed) tagspeed.Y = Ylimits.max.speed;
+        if(tagspeed.Y > Inst->Ylimits.max.speed) tagspeed.Y = Inst->Ylimits.max.speed;
     }
     axis_status_t ystate = axis.state;
     if(m.Xstate != xstate || m.Ystate != ystate){
@@ -219,25 +270,39 @@ mcc_errcodes_t correct2(const coordval_pair_t *target){
 #if 0
     // allow at least PIDMaxDt moving with target speed
     double dv = fabs(tagspeed.X - m.encXspeed.val);
-    double adder = dv/Xlimits.max.accel * (m.encXspeed.val + dv / 2.) // distanse with changing speed
-                   + Conf.PIDMaxDt * tagspeed.X // PIDMaxDt const speed moving
-                   + tagspeed.X * tagspeed.X / Xlimits.max.accel / 2.; // stopping
+    double adder = dv/Inst->Xlimits.max.accel * (m.encXspeed.val + dv / 2.) // distanse with changing speed
+                   + Inst->Conf.PIDMaxDt * tagspeed.X // PIDMaxDt const speed moving
+                   + tagspeed.X * tagspeed.X / Inst->Xlimits.max.accel / 2.; // stopping
     endpoint.X = m.encXposition.val + Xsign * adder;
     dv = fabs(tagspeed.Y - m.encYspeed.val);
-    adder = dv/Ylimits.max.accel * (m.encYspeed.val + dv / 2.)
-            + Conf.PIDMaxDt * tagspeed.Y
-            + tagspeed.Y * tagspeed.Y / Ylimits.max.accel / 2.;
+    adder = dv/Inst->Ylimits.max.accel * (m.encYspeed.val + dv / 2.)
+            + Inst->Conf.PIDMaxDt * tagspeed.Y
+            + tagspeed.Y * tagspeed.Y / Inst->Ylimits.max.accel / 2.;
     endpoint.Y = m.encYposition.val + Ysign * adder;
 #endif
-    // allow 10s moving but not more than 10deg and not less than 1deg
-    double adder = fabs(tagspeed.X) * 10.;
-    if(adder > 0.17453) adder = 0.17453;
-    else if(adder < 0.017453) adder = 0.017453;
-    endpoint.X = m.encXposition.val + Xsign * adder;
-    adder = fabs(tagspeed.Y) * 10.;
-    if(adder > 0.17453) adder = 0.17453;
-    else if(adder < 0.017453) adder = 0.017453;
-    endpoint.Y = m.encYposition.val + Ysign * adder;
+    endpoint.X = pid_endpoint(m.encXposition.val, Xsign * tagspeed.X);
+    endpoint.Y = pid_endpoint(m.encYposition.val, Ysign * tagspeed.Y);
     DBG("TAG speeds: %g/%g (deg/s); TAG pos: %g/%g (deg)", tagspeed.X/M_PI*180., tagspeed.Y/M_PI*180., endpoint.X/M_PI*180., endpoint.Y/M_PI*180.);
-    return Mount.moveWspeed(&endpoint, &tagspeed);
+    mcc_errcodes_t ret = move2s(&endpoint, &tagspeed);
+    if(MCC_E_OK == ret){ // latency from the oldest of encoders' samples
+        struct timespec now;
+        curtime(&now);
+        double dtX = timediff(&now, &m.encXposition.t), dtY = timediff(&now, &m.encYposition.t);
+        hist_add(&Inst->Stats.enc2cmd, (dtX > dtY) ? dtX : dtY);
+    }
+    return ret;
+}
+
+/**
+ * @brief correct2 - recalculate PID and move telescope to new point with new speed
+ * @param target - target position (for error calculations)
+ * @return error code
+ */
+mcc_errcodes_t correct2(const coordval_pair_t *target){
+    if(!target) return MCC_E_BADFORMAT;
+    targval_pair_t tag = {
+        .X = {.val = target->X.val, .speed = NAN, .accel = NAN, .t = target->X.t},
+        .Y = {.val = target->Y.val, .speed = NAN, .accel = NAN, .t = target->Y.t}
+    };
+    return correct2ff(&tag);
 }
@@ -22,10 +22,27 @@
 
 #include "sidservo.h"
 
-/*
+typedef struct {
+    PIDpar_t gain;      // PID gains
+    double prev_error;  // Previous error
+    double prev_tagpos; // previous target position
+    double integral;    // Integral term
+    double *pidIarray;  // array for Integral
+    struct timespec prevT; // time of previous correction
+    size_t pidIarrSize; // it's size
+    size_t curIidx;     // and index of current element
+} PIDController_t;
+
+// PIDs of correctTo() (created by first call)
+typedef struct{
+    PIDController_t *X, *Y;
+    double tprev;       // time of previous call
+} pid_state_t;
+
 PIDController_t *pid_create(const PIDpar_t *gain, size_t Iarrsz);
 void pid_clear(PIDController_t *pid);
 void pid_delete(PIDController_t **pid);
-double pid_calculate(PIDController_t *pid, double error, double dt);
-*/
+double pid_step(PIDController_t *pid, double error, double dt, double tagspeed, double vmax);
+double pid_endpoint(double pos, double speed);
 mcc_errcodes_t  correct2(const coordval_pair_t *target);
+mcc_errcodes_t  correct2ff(const targval_pair_t *target);
@@ -22,8 +22,6 @@
 
 #include "sidservo.h"
 
-extern conf_t Conf;
-
 // unused arguments of functions
 #define _U_         __attribute__((__unused__))
 // break absent in `case`
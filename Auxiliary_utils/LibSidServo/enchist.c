@@ -0,0 +1,88 @@
+/*
+ * This file is part of the libsidservo project.
+ * Copyright 2026 Edward V. Emelianov <edward.emelianoff@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * History of encoders' samples: single producer (thread reading encoders) single consumer (user) ring buffers
+ */
+
+#include <stdatomic.h>
+#include <string.h>
+
+#include "enchist.h"
+#include "main.h"
+
+/**
+ * @brief enchist_push - add next sample (if buffer is full, sample is lost and counted)
+ * @param axis - 0 for X, 1 for Y
+ * @param s - sample
+ */
+void enchist_push(int axis, const encsample_t *s){
+    if(axis < 0 || axis > 1 || !s) return;
+    enchist_t *h = &Inst->hist[axis];
+    size_t head = atomic_load_explicit(&h->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&h->tail, memory_order_acquire);
+    if(head - tail >= ENCHIST_LEN){ // overflow: nobody reads us
+        atomic_fetch_add_explicit(&h->dropped, 1, memory_order_relaxed);
+        return;
+    }
+    h->buf[head & (ENCHIST_LEN - 1)] = *s;
+    atomic_store_explicit(&h->head, head + 1, memory_order_release);
+}
+
+/**
+ * @brief enchist_read - drain history
+ * @param axis - 0 for X, 1 for Y
+ * @param out (o) - output array
+ * @param maxn - its size
+ * @return amount of samples copied (the oldest first)
+ */
+size_t enchist_read(int axis, encsample_t *out, size_t maxn){
+    if(axis < 0 || axis > 1 || !out || !maxn) return 0;
+    enchist_t *h = &Inst->hist[axis];
+    size_t tail = atomic_load_explicit(&h->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&h->head, memory_order_acquire);
+    size_t n = head - tail;
+    if(n > maxn) n = maxn;
+    if(!n) return 0;
+    // copy by one or two continuous pieces
+    size_t start = tail & (ENCHIST_LEN - 1), n1 = ENCHIST_LEN - start;
+    if(n1 > n) n1 = n;
+    memcpy(out, &h->buf[start], n1 * sizeof(encsample_t));
+    if(n > n1) memcpy(out + n1, h->buf, (n - n1) * sizeof(encsample_t));
+    atomic_store_explicit(&h->tail, tail + n, memory_order_release);
+    return n;
+}
+
+// forget all old data and counters of lost samples (call from consumer's thread or when producer stopped)
+void enchist_clear(){
+    for(int i = 0; i < 2; ++i){
+        size_t head = atomic_load_explicit(&Inst->hist[i].head, memory_order_acquire);
+        atomic_store_explicit(&Inst->hist[i].tail, head, memory_order_release);
+    }
+    enchist_resetdropped();
+}
+
+// amount of samples of given axis lost by overflow
+uint64_t enchist_dropped(int axis){
+    if(axis < 0 || axis > 1) return 0;
+    return atomic_load_explicit(&Inst->hist[axis].dropped, memory_order_relaxed);
+}
+
+void enchist_resetdropped(){
+    for(int i = 0; i < 2; ++i) atomic_store_explicit(&Inst->hist[i].dropped, 0, memory_order_relaxed);
+}
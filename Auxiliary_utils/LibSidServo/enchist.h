@@ -0,0 +1,41 @@
+/*
+ * This file is part of the libsidservo project.
+ * Copyright 2026 Edward V. Emelianov <edward.emelianoff@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "sidservo.h"
+
+// amount of samples in each axis history (should be power of 2): 4s for 1kHz encoders
+#define ENCHIST_LEN     (4096)
+
+// lock-free ring of one axis samples (one producer, one consumer)
+typedef struct{
+    encsample_t buf[ENCHIST_LEN];
+    atomic_size_t head;     // index of next sample to write (changed only by producer)
+    atomic_size_t tail;     // index of next sample to read (changed only by consumer)
+    atomic_uint_fast64_t dropped; // samples lost when buffer was full
+} enchist_t;
+
+void enchist_push(int axis, const encsample_t *s);
+size_t enchist_read(int axis, encsample_t *out, size_t maxn);
+void enchist_clear();
+uint64_t enchist_dropped(int axis);
+void enchist_resetdropped();
@@ -50,6 +50,17 @@ static sl_option_t cmdlnopts[] = {
 static sl_option_t confopts[] = {
     {"Xaccel",      NEED_ARG,   NULL,   0,      arg_double, APTR(&HW.Xconf.accel),  "X Default Acceleration, rad/s^2"},
     {"Yaccel",      NEED_ARG,   NULL,   0,      arg_double, APTR(&HW.Yconf.accel),  "Y Default Acceleration, rad/s^2"},
+    {"Xerrlimit",   NEED_ARG,   NULL,   0,      arg_double, APTR(&HW.Xconf.errlimit),"X Error Limit, rad"},
+    {"Yerrlimit",   NEED_ARG,   NULL,   0,      arg_double, APTR(&HW.Yconf.errlimit),"Y Error Limit, rad"},
+    {"Xpropgain",   NEED_ARG,   NULL,   0,      arg_double, APTR(&HW.Xconf.propgain),"X Proportional Gain"},
+    {"Ypropgain",   NEED_ARG,   NULL,   0,      arg_double, APTR(&HW.Yconf.propgain),"Y Proportional Gain"},
+    {"Xintgain",    NEED_ARG,   NULL,   0,      arg_double, APTR(&HW.Xconf.intgain),"X Integral Gain"},
+    {"Yintgain",    NEED_ARG,   NULL,   0,      arg_double, APTR(&HW.Yconf.intgain),"Y Integral Gain"},
+    {"Xderivgain",  NEED_ARG,   NULL,   0,      arg_double, APTR(&HW.Xconf.derivgain),"X Derivative Gain"},
+    {"Yderivgain",  NEED_ARG,   NULL,   0,      arg_double, APTR(&HW.Yconf.derivgain),"Y Derivative Gain"},
+    {"Xslewrate",   NEED_ARG,   NULL,   0,      arg_double, APTR(&HW.Xslewrate),    "X Slew Rate, rad/s"},
+    {"Yslewrate",   NEED_ARG,   NULL,   0,      arg_double, APTR(&HW.Yslewrate),    "Y Slew Rate, rad/s"},
+    {"latitude",    NEED_ARG,   NULL,   0,      arg_double, APTR(&HW.latitude),     "Latitude, rad"},
     end_option
 };
 
@@ -154,10 +165,14 @@ int main(int argc, char** argv){
     FREE(c);
     */
     dumpHWconf();
-    /*
-    if(G.hwconffile && G.writeconf){
-        ;
-    }*/
+    if(G.hwconffile && G.writeconf){ // change only fields given in file
+        if(sl_conf_readopts(G.hwconffile, confopts) < 1) WARNX("No parameters in %s", G.hwconffile);
+        else if(MCC_E_OK != Mount.saveHWconfig(&HW)) WARNX("Can't write configuration");
+        else{
+            green("Configuration written\n");
+            if(MCC_E_OK == Mount.getHWconfig(&HW)) dumpHWconf();
+        }
+    }
     Mount.quit();
     return 0;
 }
@@ -50,6 +50,7 @@ static conf_t Config = {
     .MaxPointingErr = 0.13962634,
     .MaxFinePointingErr = 0.026179939,
     .MaxGuidingErr = 4.8481368e-7,
+    .SpeedDisagreement = 5e-5, // 10''/s
 };
 
 static sl_option_t opts[] = {
@@ -85,6 +86,17 @@ static sl_option_t opts[] = {
     {"MaxGuidingErr",   NEED_ARG,   NULL,   0,  arg_double, APTR(&Config.MaxGuidingErr),    "if error less than this value we suppose that target is captured and guiding is good (true guiding): 0.1''"},
     {"XEncZero",        NEED_ARG,   NULL,   0,  arg_int,    APTR(&Config.XEncZero),         "X axis encoder approximate zero position"},
     {"YEncZero",        NEED_ARG,   NULL,   0,  arg_int,    APTR(&Config.YEncZero),         "Y axis encoder approximate zero position"},
+    {"SpeedSource",     NEED_ARG,   NULL,   0,  arg_int,    APTR(&Config.SpeedSource),      "source of encoders' speed: 0 - less squares, 1 - Kalman, 2 - Kalman checked by less squares"},
+    {"SpeedDisagreement",NEED_ARG,  NULL,   0,  arg_double, APTR(&Config.SpeedDisagreement),"acceptable disagreement between Kalman and less squares speeds, rad/s"},
+    {"RTPriority",      NEED_ARG,   NULL,   0,  arg_int,    APTR(&Config.RTPriority),       "SCHED_FIFO priority of mount and encoders' threads (0 - don't change)"},
+    {"CPUMask",         NEED_ARG,   NULL,   0,  arg_int,    APTR(&Config.CPUMask),          "bitmask of CPUs for mount and encoders' threads (0 - don't change)"},
+    {"RecordPath",      NEED_ARG,   NULL,   0,  arg_string, APTR(&Config.RecordPath),       "binary log of telemetry and commands"},
+    {"ReplayPath",      NEED_ARG,   NULL,   0,  arg_string, APTR(&Config.ReplayPath),       "replay binary log instead of real devices"},
+    {"XWormTeeth",      NEED_ARG,   NULL,   0,  arg_int,    APTR(&Config.XWormTeeth),       "teeth of X worm wheel for periodic error correction (0 - no PEC)"},
+    {"YWormTeeth",      NEED_ARG,   NULL,   0,  arg_int,    APTR(&Config.YWormTeeth),       "teeth of Y worm wheel for periodic error correction (0 - no PEC)"},
+    {"PECBins",         NEED_ARG,   NULL,   0,  arg_int,    APTR(&Config.PECBins),          "bins of periodic error table by worm phase (default: 128)"},
+    {"PECPath",         NEED_ARG,   NULL,   0,  arg_string, APTR(&Config.PECPath),          "file of learned periodic error"},
+    {"HWConfPath",      NEED_ARG,   NULL,   0,  arg_string, APTR(&Config.HWConfPath),       "cache of hardware configuration"},
     // {"",NEED_ARG,   NULL,   0,  arg_double, APTR(&Config.), ""},
     end_option
 };
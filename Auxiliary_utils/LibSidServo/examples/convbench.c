@@ -0,0 +1,118 @@
+/*
+ * This file is part of the libsidservo project.
+ * Copyright 2026 Edward V. Emelianov <edward.emelianoff@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// speed and accuracy of conversion of counters (motors and encoders) into radians
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <usefull_macros.h>
+
+#include "main.h"
+
+typedef struct{
+    int help;
+    int nsamples;       // amount of GETSTAT records
+    int batch;          // records converted by one call
+    int repeat;         // repeat conversion of all samples
+} parameters;
+
+static parameters G = {
+    .nsamples = 100000,
+    .batch = 64,
+    .repeat = 20,
+};
+
+static sl_option_t cmdlnopts[] = {
+    {"help",    NO_ARGS,    NULL,   'h',    arg_int,    APTR(&G.help),      "show this help"},
+    {"samples", NEED_ARG,   NULL,   'n',    arg_int,    APTR(&G.nsamples),  "amount of status records (default: 100000)"},
+    {"batch",   NEED_ARG,   NULL,   'b',    arg_int,    APTR(&G.batch),     "records converted by one call (default: 64)"},
+    {"repeat",  NEED_ARG,   NULL,   'r',    arg_int,    APTR(&G.repeat),    "repeat conversion N times (default: 20)"},
+    end_option
+};
+
+// previous version of conversion: division by steps per revolution in each call
+static double oldang2half(double ang){
+    ang = fmod(ang, 2.*M_PI);
+    if(ang < -M_PI) ang += 2.*M_PI;
+    else if(ang > M_PI) ang -= 2.*M_PI;
+    return ang;
+}
+static void oldconv(const ssconst_t *c, const int32_t *cnt, double *rad){
+    rad[0] = oldang2half(2. * M_PI * ((double)cnt[0]) / c->Xmotsteps);
+    rad[1] = oldang2half(2. * M_PI * ((double)cnt[1]) / c->Ymotsteps);
+    rad[2] = oldang2half(2.*M_PI * ((double)(cnt[2] - c->Xenczero)) / c->Xencsteps);
+    rad[3] = oldang2half(2.*M_PI * ((double)(cnt[3] - c->Yenczero)) / c->Yencsteps);
+}
+
+static double nsper(double t0, size_t n){
+    return (sl_dtime() - t0) * 1e9 / (double)n;
+}
+
+int main(int argc, char **argv){
+    sl_init();
+    sl_parseargs(&argc, &argv, cmdlnopts);
+    if(G.help) sl_showhelp(-1, cmdlnopts);
+    if(G.nsamples < 1 || G.batch < 1 || G.repeat < 1) ERRX("All parameters should be positive");
+    ssconst_t c = SS_DEFCONST;
+    c.Xenczero = 61245239; c.Yenczero = 36999830;
+    c.Xencsteps = -c.Xencsteps;
+    SSsetconst(&c);
+    size_t N = (size_t)G.nsamples * SS_NCNT;
+    int32_t *cnt = malloc(N * sizeof(int32_t));
+    double *radold = malloc(N * sizeof(double)), *radnew = malloc(N * sizeof(double));
+    if(!cnt || !radold || !radnew) ERRX("Not enough memory");
+    // tracking-like sequence of counters
+    srand48(1);
+    for(size_t i = 0; i < N; i += SS_NCNT){
+        double t = (double)i / SS_NCNT * 1e-3;
+        cnt[i + SS_XMOT] = (int32_t)(c.Xmotsteps * (0.1 + 1.16e-5 * t)) + (int)(drand48() * 5.);
+        cnt[i + SS_YMOT] = (int32_t)(c.Ymotsteps * (0.2 - 1.16e-5 * t)) + (int)(drand48() * 5.);
+        cnt[i + SS_XENC] = (int32_t)(67108864. * drand48());
+        cnt[i + SS_YENC] = (int32_t)(67108864. * drand48());
+    }
+    size_t total = N * (size_t)G.repeat;
+    double t0 = sl_dtime();
+    for(int r = 0; r < G.repeat; ++r)
+        for(size_t i = 0; i < N; i += SS_NCNT) oldconv(&c, &cnt[i], &radold[i]);
+    double told = nsper(t0, total);
+    t0 = sl_dtime();
+    for(int r = 0; r < G.repeat; ++r)
+        for(size_t i = 0; i < N; i += SS_NCNT) SScnt2rad(&c, SS_XMOT, SS_NCNT, &cnt[i], &radnew[i], 1);
+    double tone = nsper(t0, total);
+    t0 = sl_dtime();
+    size_t b = (size_t)G.batch;
+    for(int r = 0; r < G.repeat; ++r)
+        for(size_t i = 0; i < (size_t)G.nsamples; i += b){
+            size_t n = (i + b > (size_t)G.nsamples) ? (size_t)G.nsamples - i : b;
+            SScnt2rad(&c, SS_XMOT, SS_NCNT, &cnt[i * SS_NCNT], &radnew[i * SS_NCNT], n);
+        }
+    double tbatch = nsper(t0, total);
+    double maxdiff = 0.;
+    for(size_t i = 0; i < N; ++i){
+        double d = fabs(radnew[i] - radold[i]);
+        if(d > M_PI) d = 2. * M_PI - d; // +-pi
+        if(d > maxdiff) maxdiff = d;
+    }
+    printf("%zu values: old %.2f ns/value, per record %.2f ns/value, batches of %d records %.2f ns/value\n",
+           total, told, tone, G.batch, tbatch);
+    printf("max difference: %.3g rad (%.3g'')\n", maxdiff, maxdiff * 180. / M_PI * 3600.);
+    free(cnt); free(radold); free(radnew);
+    return 0;
+}
@@ -18,6 +18,7 @@
 
 // logging of mount position
 
+#include <inttypes.h>
 #include <usefull_macros.h>
 
 #include "dump.h"
@@ -26,6 +27,10 @@
 // starting dump time (to conform different logs)
 static struct timespec dumpT0 = {0};
 
+// size of buffers for encoders' history
+#define HISTSZ  (1024)
+static encsample_t histX[HISTSZ], histY[HISTSZ];
+
 #if 0
 // amount of elements used for encoders' data filtering
 #define NFILT	(10)
@@ -89,6 +94,33 @@ void logmnt(FILE *fcoords, mountdata_t *m){
     fflush(fcoords);
 }
 
+/**
+ * @brief logenchist - log all encoders' samples got from history
+ * @param fcoords - file to dump
+ * @param m - last mount data (motors' positions etc)
+ * @return amount of samples logged
+ */
+static size_t logenchist(FILE *fcoords, const mountdata_t *m){
+    size_t nX = HISTSZ, nY = HISTSZ;
+    if(MCC_E_OK != Mount.readEncoderHistory(histX, &nX, histY, &nY)) return 0;
+    size_t n = (nX > nY) ? nX : nY;
+    mountdata_t d = *m;
+    for(size_t i = 0; i < n; ++i){
+        if(i < nX){
+            d.encXposition.val = histX[i].pos;
+            d.encXposition.t = histX[i].t;
+            d.encXspeed.val = histX[i].speed;
+        }
+        if(i < nY){
+            d.encYposition.val = histY[i].pos;
+            d.encYposition.t = histY[i].t;
+            d.encYspeed.val = histY[i].speed;
+        }
+        logmnt(fcoords, &d);
+    }
+    return n;
+}
+
 /**
  * @brief dumpmoving - dump conf while moving
  * @param fcoords - dump file
@@ -112,14 +144,19 @@ void dumpmoving(FILE *fcoords, double t, int N){
     int ctr = -1;
     double xlast = mdata.motXposition.val, ylast = mdata.motYposition.val;
     double t0 = Mount.timeFromStart();
+    // forget old history
+    size_t nX = HISTSZ, nY = HISTSZ;
+    while(MCC_E_OK == Mount.readEncoderHistory(histX, &nX, histY, &nY) && (nX || nY)){ nX = nY = HISTSZ; }
     while(Mount.timeFromStart() - t0 < t && ctr < N){
-        usleep(1000);
+        Mount.advanceClock(0.01); // sleep or move virtual clock
         if(MCC_E_OK != Mount.getMountData(&mdata)){ WARNX("Can't get data"); continue;}
-        //double tmsr = (mdata.encXposition.t + mdata.encYposition.t) / 2.;
-        struct timespec msrt = mdata.encXposition.t;
-        if(msrt.tv_nsec == encXt.tv_nsec) continue;
-        encXt = msrt;
-        if(fcoords) logmnt(fcoords, &mdata);
+        // all encoders' samples from history or just last if history is empty
+        if(0 == logenchist(fcoords, &mdata)){
+            struct timespec msrt = mdata.encXposition.t;
+            if(msrt.tv_nsec == encXt.tv_nsec) continue;
+            encXt = msrt;
+            logmnt(fcoords, &mdata);
+        }
         if(mdata.millis == mdmillis) continue;
         //DBG("ctr=%d, motpos=%g/%g", ctr, mdata.motXposition.val, mdata.motYposition.val);
         mdmillis = mdata.millis;
@@ -143,7 +180,7 @@ void waitmoving(int N){
     //double xlast = 0., ylast = 0.;
     DBG("Wait moving for %d stopped times", N);
     while(ctr < N){
-        usleep(10000);
+        Mount.advanceClock(0.01); // sleep or move virtual clock
         if(MCC_E_OK != Mount.getMountData(&mdata)){ WARNX("Can't get data"); continue;}
         if(mdata.millis == millis) continue;
         millis = mdata.millis;
@@ -195,3 +232,44 @@ void chk0(int ncycles){
         green("Now mount @ zero\n");
     }
 }
+
+/**
+ * @brief dumphist - print one histogram: amount, mean, max and nonzero bins (by upper limit in us)
+ * @param f - output file
+ * @param name - histogram name
+ * @param h - histogram
+ */
+static void dumphist(FILE *f, const char *name, const mcc_hist_t *h){
+    fprintf(f, "%-16s n=%-8" PRIu64 " mean=%10.1fus max=%10.1fus:", name, h->n, h->mean * 1e6, h->max * 1e6);
+    for(int i = 0; i < MCC_HIST_NBINS; ++i){
+        if(!h->bins[i]) continue;
+        if(i == MCC_HIST_NBINS - 1) fprintf(f, " >%u:%" PRIu64, 1u << (i - 1), h->bins[i]);
+        else fprintf(f, " <%u:%" PRIu64, 1u << i, h->bins[i]);
+    }
+    fprintf(f, "\n");
+}
+
+// dump all timing statistics of library
+void dumpstats(FILE *f){
+    static const char *clsnames[MCC_CMD_AMOUNT] = {"motion", "other", "status"};
+    mcc_stats_t s;
+    char buf[32];
+    if(!f || MCC_E_OK != Mount.getStats(&s)) return;
+    fprintf(f, "Timing statistics (histogram bins are upper limits in us):\n");
+    dumphist(f, "Loop jitter", &s.mountJitter);
+    dumphist(f, "Encoder period", &s.encInterval);
+    dumphist(f, "PID period", &s.pidPeriod);
+    dumphist(f, "Track period", &s.trackPeriod);
+    dumphist(f, "Encoder->cmd", &s.enc2cmd);
+    for(int i = 0; i < MCC_CMD_AMOUNT; ++i){
+        snprintf(buf, 31, "RTT %s", clsnames[i]);
+        dumphist(f, buf, &s.cmdRTT[i]);
+        snprintf(buf, 31, "Latency %s", clsnames[i]);
+        dumphist(f, buf, &s.cmdLatency[i]);
+    }
+    if(s.encHistDropped[0] || s.encHistDropped[1])
+        fprintf(f, "Encoders' history lost: X=%" PRIu64 ", Y=%" PRIu64 "\n", s.encHistDropped[0], s.encHistDropped[1]);
+    if(s.asyncRejected)
+        fprintf(f, "Asynchronous commands rejected by full queue: %" PRIu64 "\n", s.asyncRejected);
+    fflush(f);
+}
@@ -28,3 +28,4 @@ void waitmoving(int N);
 int getPos(coordval_pair_t *mot, coordval_pair_t *enc);
 void chk0(int ncycles);
 void dumpt0(struct timespec *t);
+void dumpstats(FILE *f);
@@ -59,6 +59,7 @@ void signals(int sig){
         DBG("Get signal %d, quit.\n", sig);
     }
     LOGERR("Exit with status %d", sig);
+    dumpstats(stderr);
     Mount.quit();
     exit(sig);
 }
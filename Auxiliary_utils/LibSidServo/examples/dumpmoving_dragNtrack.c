@@ -69,6 +69,7 @@ void signals(int sig){
     }
     return2zero();
     sleep(5);
+    dumpstats(stderr);
     Mount.quit();
     exit(sig);
 }
@@ -66,6 +66,7 @@ void signals(int sig){
         signal(sig, SIG_IGN);
         DBG("Get signal %d, quit.\n", sig);
     }
+    dumpstats(stderr);
     Mount.quit();
     exit(sig);
 }
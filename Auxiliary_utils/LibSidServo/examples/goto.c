@@ -33,16 +33,20 @@ typedef struct{
     int Ncycles;
     int wait;
     int relative;
+    int slew;
+    int flip;
     char *coordsoutput;
     char *conffile;
     double X;
     double Y;
+    double flipX;
 } parameters;
 
 static parameters G = {
     .Ncycles = 10,
     .X = NAN,
     .Y = NAN,
+    .flipX = 180.,
 };
 
 static sl_option_t cmdlnopts[] = {
@@ -53,6 +57,9 @@ static sl_option_t cmdlnopts[] = {
     {"output",      NEED_ARG,   NULL,   'o',    arg_string, APTR(&G.coordsoutput),"file to log coordinates"},
     {"wait",        NO_ARGS,    NULL,   'w',    arg_int,    APTR(&G.wait),      "wait until mowing stopped"},
     {"relative",    NO_ARGS,    NULL,   'r',    arg_int,    APTR(&G.relative),  "relative move"},
+    {"slew",        NO_ARGS,    NULL,   's',    arg_int,    APTR(&G.slew),      "slew by jerk-limited profiles (coordinates are axes' encoders)"},
+    {"flip",        NO_ARGS,    NULL,   'f',    arg_int,    APTR(&G.flip),      "slew: allow flip (X'=flipx-X, Y'=Y+180) if it's faster"},
+    {"flipx",       NEED_ARG,   NULL,   'F',    arg_double, APTR(&G.flipX),     "X of flip (default: 180 degrees)"},
     {"conffile",    NEED_ARG,   NULL,   'C',    arg_string, APTR(&G.conffile),  "configuration file name"},
     end_option
 };
@@ -69,6 +76,7 @@ void signals(int sig){
     Mount.stop();
     usleep(10000);
     DBG("Quit");
+    dumpstats(stderr);
     Mount.quit();
     usleep(10000);
     DBG("close");
@@ -109,6 +117,10 @@ int main(int _U_ argc, char _U_ **argv){
     printf("Mount position: X=%g, Y=%g; encoders: X=%g, Y=%g\n", M.X.val, M.Y.val,
            RAD2DEG(E.X.val), RAD2DEG(E.Y.val));
     if(isnan(G.X) && isnan(G.Y)) goto out;
+    if(G.slew){ // slew works by encoders
+        M.X.val = RAD2DEG(E.X.val);
+        M.Y.val = RAD2DEG(E.Y.val);
+    }
     coordpair_t tag;
     if(isnan(G.X)){
         if(G.relative) G.X = 0.;
@@ -124,7 +136,17 @@ int main(int _U_ argc, char _U_ **argv){
     }
     printf("Moving to X=%gdeg, Y=%gdeg\n", G.X, G.Y);
     tag.X = DEG2RAD(G.X); tag.Y = DEG2RAD(G.Y);
-    mcc_errcodes_t e = Mount.moveTo(&tag);
+    mcc_errcodes_t e;
+    if(G.slew){
+        mcc_slewplan_t plan = {.target = tag, .wrap = 1, .flip = G.flip, .flipX = DEG2RAD(G.flipX)};
+        mcc_slewplan_res_t res;
+        e = Mount.planSlew(&plan, &res);
+        if(MCC_E_OK == e){
+            printf("Fastest of %d positions: X=%gdeg, Y=%gdeg%s, planned slew time: %.2fs\n", res.ncand,
+                   RAD2DEG(res.target.X), RAD2DEG(res.target.Y), res.flipped ? " (flipped)" : "", res.duration);
+            e = Mount.slewTo(&res.target, NULL);
+        }
+    }else e = Mount.moveTo(&tag);
     if(MCC_E_OK != e){
         WARNX("Cant go to given coordinates: %s\n", EcodeStr(e));
         goto out;
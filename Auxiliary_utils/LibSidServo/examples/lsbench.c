@@ -0,0 +1,178 @@
+/*
+ * This file is part of the libsidservo project.
+ * Copyright 2026 Edward V. Emelianov <edward.emelianoff@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// accuracy and speed of sliding less squares speed estimator on long simulated tracking
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <usefull_macros.h>
+
+#include "main.h"
+
+typedef struct{
+    int help;
+    double hours;       // duration of simulated night
+    double dt;          // encoders' requests interval
+    double window;      // speed calculation interval
+    double speed;       // simulated speed, rad/s
+    double noise;       // encoder's quantum, rad
+    int check;          // compare with exact solution each `check` samples
+} parameters;
+
+static parameters G = {
+    .hours = 12.,
+    .dt = 0.001,
+    .window = 0.05,
+    .speed = 7.2921159e-5, // sidereal
+    .noise = 9.36e-8, // 2pi/2^26
+    .check = 997,
+};
+
+static sl_option_t cmdlnopts[] = {
+    {"help",    NO_ARGS,    NULL,   'h',    arg_int,    APTR(&G.help),      "show this help"},
+    {"hours",   NEED_ARG,   NULL,   'H',    arg_double, APTR(&G.hours),     "duration of simulation, hours (default: 12)"},
+    {"dt",      NEED_ARG,   NULL,   'd',    arg_double, APTR(&G.dt),        "encoders' requests interval, s (default: 0.001)"},
+    {"window",  NEED_ARG,   NULL,   'w',    arg_double, APTR(&G.window),    "speed calculation interval, s (default: 0.05)"},
+    {"speed",   NEED_ARG,   NULL,   's',    arg_double, APTR(&G.speed),     "simulated speed, rad/s (default: sidereal)"},
+    {"noise",   NEED_ARG,   NULL,   'n',    arg_double, APTR(&G.noise),     "encoder's quantum, rad (default: 2pi/2^26)"},
+    {"check",   NEED_ARG,   NULL,   'c',    arg_int,    APTR(&G.check),     "compare with exact solution each N samples (default: 997)"},
+    end_option
+};
+
+// previous version of estimator: absolute times and running sums of t, t^2 and x*t
+typedef struct{
+    double *x, *t, *t2, *xt;
+    double xsum, tsum, t2sum, xtsum;
+    size_t idx, arraysz;
+} oldls_t;
+
+static double oldls_slope(oldls_t *l, double x, double t){
+    size_t idx = l->idx;
+    double oldx = l->x[idx], oldt = l->t[idx], oldt2 = l->t2[idx], oldxt = l->xt[idx];
+    double t2 = t * t, xt = x * t;
+    l->x[idx] = x; l->t2[idx] = t2;
+    l->t[idx] = t; l->xt[idx] = xt;
+    ++idx;
+    l->idx = (idx >= l->arraysz) ? 0 : idx;
+    l->xsum += x - oldx;
+    l->t2sum += t2 - oldt2;
+    l->tsum += t - oldt;
+    l->xtsum += xt - oldxt;
+    double n = (double)l->arraysz;
+    double denominator = n * l->t2sum - l->tsum * l->tsum;
+    if(fabs(denominator) < 1e-7) return 0.;
+    return (n * l->xtsum - l->xsum * l->tsum) / denominator;
+}
+
+// exact slope by data in ring buffer of `l`
+static double exactslope(const less_square_t *l){
+    long double xm = 0., tm = 0., n = (long double)l->ndata;
+    for(size_t i = 0; i < l->ndata; ++i){ xm += l->x[i]; tm += l->t[i]; }
+    xm /= n; tm /= n;
+    long double num = 0., den = 0.;
+    for(size_t i = 0; i < l->ndata; ++i){
+        long double dt = l->t[i] - tm;
+        num += (l->x[i] - xm) * dt;
+        den += dt * dt;
+    }
+    return (double)(num / den);
+}
+
+static double nsnow(){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+typedef struct{
+    double sum2, max; // sum of squared errors and max abs error
+    size_t n, zeros;  // amount of checks and zero results
+} errstat_t;
+
+static void adderr(errstat_t *e, double val, double exact){
+    if(val == 0.) ++e->zeros;
+    double d = fabs(val - exact);
+    e->sum2 += d*d;
+    if(d > e->max) e->max = d;
+    ++e->n;
+}
+
+static void prerr(const char *name, const errstat_t *e, double ns, size_t N){
+    printf("%-8s RMS err: %.3g rad/s, max err: %.3g rad/s, zero results: %zd of %zd; %.1f ns/sample\n",
+           name, sqrt(e->sum2 / (double)e->n), e->max, e->zeros, e->n, ns / (double)N);
+}
+
+int main(int argc, char **argv){
+    sl_init();
+    sl_parseargs(&argc, &argv, cmdlnopts);
+    if(G.help) sl_showhelp(-1, cmdlnopts);
+    if(G.dt <= 0. || G.window < 5. * G.dt || G.hours <= 0. || G.check < 1) ERRX("Wrong parameters");
+    size_t N = (size_t)(G.hours * 3600. / G.dt), W = (size_t)(G.window / G.dt);
+    printf("Simulate %zd samples, window of %zd samples\n", N, W);
+    // prepare data: sampling with small jitter and quantization noise
+    double *X = malloc(N * sizeof(double)), *T = malloc(N * sizeof(double));
+    if(!X || !T) ERRX("Not enough memory");
+    srand48(1);
+    for(size_t i = 0; i < N; ++i){
+        T[i] = (double)i * G.dt + (drand48() - 0.5) * G.dt * 0.05;
+        double x = -1. + G.speed * T[i];
+        X[i] = floor(x / G.noise) * G.noise;
+    }
+    less_square_t *l = LS_init(W);
+    oldls_t o = {.arraysz = W};
+    o.x = calloc(W, sizeof(double)); o.t = calloc(W, sizeof(double));
+    o.t2 = calloc(W, sizeof(double)); o.xt = calloc(W, sizeof(double));
+    if(!l || !o.x || !o.t || !o.t2 || !o.xt) ERRX("Can't init estimators");
+    // speed of both
+    double t0 = nsnow();
+    volatile double s;
+    for(size_t i = 0; i < N; ++i) s = oldls_slope(&o, X[i], T[i]);
+    double nsold = nsnow() - t0;
+    t0 = nsnow();
+    for(size_t i = 0; i < N; ++i) s = LS_calc_slope(l, X[i], T[i]);
+    double nsnew = nsnow() - t0;
+    (void) s;
+    // accuracy relative to exact solution on the same window
+    LS_delete(&l);
+    l = LS_init(W);
+    o.idx = 0; o.xsum = o.tsum = o.t2sum = o.xtsum = 0.;
+    for(size_t i = 0; i < W; ++i) o.x[i] = o.t[i] = o.t2[i] = o.xt[i] = 0.;
+    errstat_t eold = {0}, enew = {0};
+    errstat_t hold[4] = {0}, hnew[4] = {0}; // by quarters of night
+    for(size_t i = 0; i < N; ++i){
+        double so = oldls_slope(&o, X[i], T[i]);
+        double sn = LS_calc_slope(l, X[i], T[i]);
+        if(i < W || i % G.check) continue;
+        double ex = exactslope(l);
+        adderr(&eold, so, ex); adderr(&enew, sn, ex);
+        int q = (int)(4 * i / N);
+        adderr(&hold[q], so, ex); adderr(&hnew[q], sn, ex);
+    }
+    printf("Relative to exact LS solution on the same window:\n");
+    prerr("old", &eold, nsold, N);
+    prerr("new", &enew, nsnew, N);
+    printf("\nBy quarters of night (RMS error, rad/s):\n  quarter       old         new\n");
+    for(int q = 0; q < 4; ++q)
+        printf("  %d        %10.3g  %10.3g\n", q + 1, sqrt(hold[q].sum2 / (double)hold[q].n), sqrt(hnew[q].sum2 / (double)hnew[q].n));
+    LS_delete(&l);
+    free(o.x); free(o.t); free(o.t2); free(o.xt);
+    free(X); free(T);
+    return 0;
+}
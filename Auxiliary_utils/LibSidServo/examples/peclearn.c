@@ -0,0 +1,183 @@
+/*
+ * This file is part of the libsidservo project.
+ * Copyright 2026 Edward V. Emelianov <edward.emelianoff@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// learn periodic error of worms while tracking with constant speed by both axes, then track with correction
+// and compare errors; learned tables are saved into PECPath of configuration (or given file)
+
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <usefull_macros.h>
+
+#include "conf.h"
+#include "dump.h"
+#include "sidservo.h"
+#include "simpleconv.h"
+
+// sidereal speed, rad/s
+#define SIDEREAL    (7.2921159e-5)
+
+typedef struct{
+    int help;
+    int reset;          // forget previous tables
+    int table;          // print tables
+    int Ncycles;        // n cycles to wait stop
+    double nperiods;    // worm periods of each test
+    double speed;       // speed of axes, sidereal units
+    double settle;      // time from test start excluded from statistics
+    double X0;          // starting point, degrees
+    double Y0;
+    char *outfile;      // file for tables
+    char *conffile;
+} parameters;
+
+static conf_t *Config = NULL;
+static parameters G = {
+    .Ncycles = 40,
+    .nperiods = 3.,
+    .speed = 1.,
+    .settle = 5.,
+    .X0 = 10.,
+    .Y0 = 10.,
+};
+
+static sl_option_t cmdlnopts[] = {
+    {"help",        NO_ARGS,    NULL,   'h',    arg_int,    APTR(&G.help),      "show this help"},
+    {"reset",       NO_ARGS,    NULL,   'R',    arg_int,    APTR(&G.reset),     "forget tables loaded from PECPath"},
+    {"table",       NO_ARGS,    NULL,   't',    arg_int,    APTR(&G.table),     "print learned tables"},
+    {"ncycles",     NEED_ARG,   NULL,   'n',    arg_int,    APTR(&G.Ncycles),   "N cycles in stopped state (default: 40)"},
+    {"periods",     NEED_ARG,   NULL,   'p',    arg_double, APTR(&G.nperiods),  "duration of each test in worm periods (default: 3)"},
+    {"speed",       NEED_ARG,   NULL,   's',    arg_double, APTR(&G.speed),     "speed of axes in sidereal units (default: 1)"},
+    {"x0",          NEED_ARG,   NULL,   '0',    arg_double, APTR(&G.X0),        "starting X-coordinate (default: 10 degrees)"},
+    {"y0",          NEED_ARG,   NULL,   '1',    arg_double, APTR(&G.Y0),        "starting Y-coordinate (default: 10 degrees)"},
+    {"output",      NEED_ARG,   NULL,   'o',    arg_string, APTR(&G.outfile),   "save tables into this file (default: PECPath)"},
+    {"conffile",    NEED_ARG,   NULL,   'C',    arg_string, APTR(&G.conffile),  "configuration file name"},
+    end_option
+};
+
+void signals(int sig){
+    if(sig){
+        signal(sig, SIG_IGN);
+        DBG("Get signal %d, quit.\n", sig);
+    }
+    Mount.stop();
+    Mount.quit();
+    exit(sig);
+}
+
+static coordpair_t Start;   // starting point of trajectory
+static double Tstart;       // and its time
+
+// constant speed by both axes
+static int trackfn(double t, coordpair_t *pos, void _U_ *arg){
+    double v = G.speed * SIDEREAL * (t - Tstart);
+    pos->X = Start.X + v;
+    pos->Y = Start.Y + v;
+    return TRUE;
+}
+
+/**
+ * @brief runtest - track for `tmax` seconds and get RMS of error (target - encoders) by all encoders' samples
+ * @param tmax - duration
+ * @return RMS, ''
+ */
+static double runtest(double tmax){
+    double t0 = Mount.timeFromStart(), t, sum2 = 0.;
+    size_t N = 0;
+    struct timespec tprev = {0};
+    while((t = Mount.timeFromStart()) - t0 < tmax){
+        mountdata_t m;
+        if(MCC_E_OK != Mount.getMountData(&m)) break;
+        if(m.encXposition.t.tv_sec != tprev.tv_sec || m.encXposition.t.tv_nsec != tprev.tv_nsec){
+            tprev = m.encXposition.t;
+            coordpair_t pt;
+            if(t - t0 > G.settle && trackfn(Mount.timeDiff0(&m.encXposition.t), &pt, NULL)){
+                double dX = RAD2ASEC(pt.X - m.encXposition.val), dY = RAD2ASEC(pt.Y - m.encYposition.val);
+                sum2 += dX*dX + dY*dY;
+                ++N;
+            }
+        }
+        usleep(500);
+    }
+    return N ? sqrt(sum2 / N) : 0.;
+}
+
+static void printaxis(char name, const mcc_pecaxis_t *a){
+    if(!a->teeth) return;
+    printf("%c: teeth=%d, bins=%d, coverage=%.2f, samples=%llu, peak-to-peak=%.3f'', RMS=%.3f''\n", name, a->teeth,
+           a->nbins, a->coverage, (unsigned long long)a->nsamples, RAD2ASEC(a->ptp), RAD2ASEC(a->rms));
+}
+
+int main(int argc, char **argv){
+    sl_init();
+    sl_parseargs(&argc, &argv, cmdlnopts);
+    if(G.help) sl_showhelp(-1, cmdlnopts);
+    if(G.nperiods <= 0. || G.speed <= 0.) ERRX("periods and speed should be positive");
+    Config = readServoConf(G.conffile);
+    if(!Config){
+        dumpConf();
+        return 1;
+    }
+    if(Config->XWormTeeth < 1 && Config->YWormTeeth < 1) ERRX("Set XWormTeeth and/or YWormTeeth in configuration");
+    if(!G.outfile && !Config->PECPath) WARNX("No PECPath in configuration and no output file: tables won't be saved");
+    int teeth = Config->XWormTeeth;
+    if(teeth < 1 || (Config->YWormTeeth > 0 && Config->YWormTeeth < teeth)) teeth = Config->YWormTeeth;
+    double tmax = G.nperiods * 2. * M_PI / teeth / (G.speed * SIDEREAL) + G.settle;
+    mcc_errcodes_t e = Mount.init(Config);
+    if(e != MCC_E_OK) ERRX("Can't init devices");
+    signal(SIGTERM, signals); // kill (-15) - quit
+    signal(SIGHUP, SIG_IGN);  // hup - ignore
+    signal(SIGINT, signals);  // ctrl+C - quit
+    signal(SIGQUIT, signals); // ctrl+\ - quit
+    signal(SIGTSTP, SIG_IGN); // ignore ctrl+Z
+    mcc_pecmode_t mode = {.reset = G.reset};
+    if(MCC_E_OK != Mount.setPEC(&mode)) ERRX("Can't set PEC mode");
+    Start.X = DEG2RAD(G.X0); Start.Y = DEG2RAD(G.Y0);
+    if(MCC_E_OK != Mount.moveTo(&Start)) ERRX("Can't move to starting point");
+    waitmoving(G.Ncycles);
+    Tstart = Mount.timeFromStart();
+    mcc_track_t tr = {.traject = trackfn};
+    if(MCC_E_OK != Mount.track(&tr)) ERRX("Can't start tracking");
+    green("Learning for %.1f s\n", tmax);
+    mode = (mcc_pecmode_t){.learn = 1};
+    Mount.setPEC(&mode);
+    double rms0 = runtest(tmax);
+    green("Tracking with correction for %.1f s\n", tmax);
+    mode = (mcc_pecmode_t){.apply = 1};
+    Mount.setPEC(&mode);
+    double rms1 = runtest(tmax);
+    Mount.stop();
+    mcc_pec_t s;
+    if(MCC_E_OK != Mount.getPEC(&s)) ERRX("Can't get PEC state");
+    printaxis('X', &s.X);
+    printaxis('Y', &s.Y);
+    printf("RMS of tracking error: %.3f'' without PEC, %.3f'' with PEC\n", rms0, rms1);
+    if(G.table){
+        int n = s.X.teeth ? s.X.nbins : s.Y.nbins;
+        printf("# phase  X('')  Y('')\n");
+        for(int i = 0; i < n; ++i)
+            printf("%.4f %8.3f %8.3f\n", (i + 0.5) / n, RAD2ASEC(s.X.table[i]), RAD2ASEC(s.Y.table[i]));
+    }
+    if(G.outfile || Config->PECPath){
+        if(MCC_E_OK != Mount.savePEC(G.outfile)) WARNX("Can't save tables");
+        else green("Tables saved\n");
+    }
+    signals(0);
+    return 0;
+}
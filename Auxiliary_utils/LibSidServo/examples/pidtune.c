@@ -0,0 +1,109 @@
+/*
+ * This file is part of the libsidservo project.
+ * Copyright 2026 Edward V. Emelianov <edward.emelianoff@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// offline search of PID gains (for correctTo or correctToFF) by model; prints lines for configuration file
+
+#include <math.h>
+#include <stdio.h>
+#include <usefull_macros.h>
+
+#include "conf.h"
+#include "sidservo.h"
+#include "simpleconv.h"
+
+typedef struct{
+    int help;
+    int ff;             // tune correctToFF()
+    int gridN;          // grid size
+    int NMiter;         // Nelder-Mead iterations
+    int nthreads;       // amount of threads
+    int seed;           // noise seed
+    double duration;    // duration of each simulation
+    double latency;     // measurement->command latency
+    double noise;       // encoders' noise, ''
+    double offset;      // initial offset, ''
+    double Pmax;        // max gains
+    double Imax;
+    double Dmax;
+    char *conffile;
+} parameters;
+
+static parameters G = {
+    .Pmax = 10.,
+    .Imax = 5.,
+    .Dmax = 1.,
+};
+
+static sl_option_t cmdlnopts[] = {
+    {"help",        NO_ARGS,    NULL,   'h',    arg_int,    APTR(&G.help),      "show this help"},
+    {"ff",          NO_ARGS,    NULL,   'f',    arg_int,    APTR(&G.ff),        "tune PID with feed-forward of target speed (correctToFF)"},
+    {"grid",        NEED_ARG,   NULL,   'g',    arg_int,    APTR(&G.gridN),     "amount of grid points by each gain (default: 5)"},
+    {"nmiter",      NEED_ARG,   NULL,   'n',    arg_int,    APTR(&G.NMiter),    "max amount of Nelder-Mead iterations (default: 200)"},
+    {"threads",     NEED_ARG,   NULL,   'j',    arg_int,    APTR(&G.nthreads),  "amount of threads (default: all CPUs)"},
+    {"seed",        NEED_ARG,   NULL,   's',    arg_int,    APTR(&G.seed),      "seed of noise generator"},
+    {"duration",    NEED_ARG,   NULL,   'T',    arg_double, APTR(&G.duration),  "duration of each simulation (default: 120 seconds)"},
+    {"latency",     NEED_ARG,   NULL,   'l',    arg_double, APTR(&G.latency),   "latency between measurement and command (seconds, default: 0)"},
+    {"noise",       NEED_ARG,   NULL,   'N',    arg_double, APTR(&G.noise),     "RMS of encoders' noise (arcseconds, default: 0)"},
+    {"offset",      NEED_ARG,   NULL,   'o',    arg_double, APTR(&G.offset),    "initial offset from trajectory (arcseconds, default: 0)"},
+    {"pmax",        NEED_ARG,   NULL,   'P',    arg_double, APTR(&G.Pmax),      "max value of P (default: 10)"},
+    {"imax",        NEED_ARG,   NULL,   'I',    arg_double, APTR(&G.Imax),      "max value of I (default: 5)"},
+    {"dmax",        NEED_ARG,   NULL,   'D',    arg_double, APTR(&G.Dmax),      "max value of D (default: 1)"},
+    {"conffile",    NEED_ARG,   NULL,   'C',    arg_string, APTR(&G.conffile),  "configuration file name"},
+    end_option
+};
+
+int main(int argc, char **argv){
+    sl_init();
+    sl_parseargs(&argc, &argv, cmdlnopts);
+    if(G.help) sl_showhelp(-1, cmdlnopts);
+    conf_t *Config = readServoConf(G.conffile);
+    if(!Config){
+        dumpConf();
+        return 1;
+    }
+    Config->RunModel = 1; // don't touch real mount
+    if(MCC_E_OK != Mount.init(Config)) ERRX("Can't init library");
+    mcc_pidtune_t par = {
+        .feedforward = G.ff,
+        .duration = G.duration,
+        .latency = G.latency,
+        .noise = ASEC2RAD(G.noise),
+        .offset = ASEC2RAD(G.offset),
+        .max = {.P = G.Pmax, .I = G.Imax, .D = G.Dmax},
+        .gridN = G.gridN,
+        .NMiter = G.NMiter,
+        .nthreads = G.nthreads,
+        .seed = (unsigned short)G.seed,
+    };
+    mcc_pidtune_res_t res[2];
+    for(int axis = 0; axis < 2; ++axis){
+        par.axis = axis;
+        double t0 = Mount.timeFromStart();
+        if(MCC_E_OK != Mount.tunePID(&par, &res[axis])) ERRX("Can't tune PID of %c axis", 'X' + axis);
+        green("%c: P=%g, I=%g, D=%g\n", 'X' + axis, res[axis].gain.P, res[axis].gain.I, res[axis].gain.D);
+        printf("\tRMS=%.3f'', peak=%.3f'', settling time=%.2fs (%zd simulations for %.1fs)\n", RAD2ASEC(res[axis].rms),
+               RAD2ASEC(res[axis].peak), res[axis].settle, res[axis].nsim, Mount.timeFromStart() - t0);
+    }
+    printf("\n# lines for configuration file\n");
+    for(int axis = 0; axis < 2; ++axis){
+        printf("%cPIDVP = %g\n%cPIDVI = %g\n%cPIDVD = %g\n", 'X' + axis, res[axis].gain.P,
+               'X' + axis, res[axis].gain.I, 'X' + axis, res[axis].gain.D);
+    }
+    Mount.quit();
+    return 0;
+}
@@ -0,0 +1,149 @@
+/*
+ * This file is part of the libsidservo project.
+ * Copyright 2026 Edward V. Emelianov <edward.emelianoff@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// plot ramps of moving model (dumb, trapezium or s-shaped) and check speed of its batch evaluation
+// output: "time coordinate speed acceleration", plot it e.g. by gnuplot:
+// plot for [col=2:4] 'coordlog' using 1:col with lines title columnheader
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <usefull_macros.h>
+
+#include "movingmodel.h"
+
+typedef struct{
+    int help;
+    int Nbench;         // amount of points for benchmark
+    double X;           // first target
+    double V;           // its max speed
+    double X2;          // second target (change target while moving)
+    double V2;          // -//- speed
+    double T2;          // time of second command
+    double dt;          // time step of output
+    double amax;        // max acceleration
+    double jerk;        // max jerk
+    char *ramptype;
+    char *xlog;
+} parameters;
+
+static parameters G = {
+    .ramptype = "t",
+    .X = 10.,
+    .V = 5.,
+    .T2 = -1.,
+    .dt = 0.01,
+    .amax = 9.53523,
+    .jerk = 10.,
+};
+
+static sl_option_t cmdlnopts[] = {
+    {"help",    NO_ARGS,    NULL,   'h',    arg_int,    APTR(&G.help),      "show this help"},
+    {"ramp",    NEED_ARG,   NULL,   'r',    arg_string, APTR(&G.ramptype),  "ramp type: \"d\", \"t\" or \"s\" - dumb, trapezoid, s-type (default: t)"},
+    {"coord",   NEED_ARG,   NULL,   'x',    arg_double, APTR(&G.X),         "target coordinate (default: 10)"},
+    {"speed",   NEED_ARG,   NULL,   'v',    arg_double, APTR(&G.V),         "max speed of moving (default: 5)"},
+    {"coord2",  NEED_ARG,   NULL,   'X',    arg_double, APTR(&G.X2),        "second target coordinate"},
+    {"speed2",  NEED_ARG,   NULL,   'V',    arg_double, APTR(&G.V2),        "max speed of moving to second target (default: as first)"},
+    {"time2",   NEED_ARG,   NULL,   'T',    arg_double, APTR(&G.T2),        "time of second command (seconds, >0)"},
+    {"accel",   NEED_ARG,   NULL,   'a',    arg_double, APTR(&G.amax),      "max acceleration (default: 9.53523)"},
+    {"jerk",    NEED_ARG,   NULL,   'j',    arg_double, APTR(&G.jerk),      "max jerk of s-type ramp (default: 10)"},
+    {"deltat",  NEED_ARG,   NULL,   't',    arg_double, APTR(&G.dt),        "time interval of output (seconds, default: 0.01)"},
+    {"xlog",    NEED_ARG,   NULL,   'l',    arg_string, APTR(&G.xlog),      "log file name for coordinates logging (default: stdout)"},
+    {"bench",   NEED_ARG,   NULL,   'b',    arg_int,    APTR(&G.Nbench),    "amount of points to check speed of evaluation"},
+    end_option
+};
+
+/**
+ * @brief dumpramp - evaluate model at times [t0, t1) with step G.dt and dump points to file
+ * @return amount of points
+ */
+static size_t dumpramp(FILE *f, movemodel_t *m, double t0, double t1){
+    size_t N = (size_t)ceil((t1 - t0) / G.dt);
+    if(N == 0) return 0;
+    double *t = calloc(N, sizeof(double));
+    moveparam_t *p = calloc(N, sizeof(moveparam_t));
+    for(size_t i = 0; i < N; ++i) t[i] = t0 + i * G.dt;
+    N = m->eval(m, t, N, p);
+    for(size_t i = 0; i < N; ++i)
+        fprintf(f, "%-9.4f\t%-10.4f\t%-10.4f\t%-10.4f\n", t[i], p[i].coord, p[i].speed, p[i].accel);
+    FREE(t); FREE(p);
+    return N;
+}
+
+// time of batch evaluation and of step-by-step proc_move() for G.Nbench points of current traectory
+static void bench(movemodel_t *m, double tend){
+    size_t N = (size_t)G.Nbench;
+    double *t = calloc(N, sizeof(double));
+    moveparam_t *p = calloc(N, sizeof(moveparam_t));
+    for(size_t i = 0; i < N; ++i) t[i] = tend * i / N;
+    double t0 = sl_dtime();
+    m->eval(m, t, N, p);
+    double tev = sl_dtime() - t0;
+    movemodel_t copy = *m; // proc_move() changes state
+    pthread_mutex_init(&copy.mutex, NULL);
+    t0 = sl_dtime();
+    for(size_t i = 0; i < N; ++i) copy.proc_move(&copy, &p[i], t[i]);
+    double tproc = sl_dtime() - t0;
+    model_free(&copy);
+    green("%zd points: eval() %.1fns/point, proc_move() %.1fns/point\n", N, tev * 1e9 / N, tproc * 1e9 / N);
+    FREE(t); FREE(p);
+}
+
+int main(int argc, char **argv){
+    sl_init();
+    sl_parseargs(&argc, &argv, cmdlnopts);
+    if(G.help) sl_showhelp(-1, cmdlnopts);
+    if(G.dt <= 0.) ERRX("deltat should be > 0");
+    ramptype_t type = RAMP_AMOUNT;
+    switch(*G.ramptype){
+        case 'd': type = RAMP_DUMB; break;
+        case 't': type = RAMP_TRAPEZIUM; break;
+        case 's': type = RAMP_S; break;
+        default: ERRX("Wrong ramp type: %s", G.ramptype);
+    }
+    limits_t lim = {
+        .min = {.coord = -1e6, .speed = 0.01, .accel = 0.1},
+        .max = {.coord = 1e6, .speed = 20., .accel = G.amax},
+        .jerk = G.jerk
+    };
+    movemodel_t model;
+    if(!model_init(&model, type, &lim)) ERRX("Can't init model");
+    FILE *f = stdout;
+    if(G.xlog){
+        f = fopen(G.xlog, "w");
+        if(!f) ERR("Can't open %s", G.xlog);
+    }
+    fprintf(f, "time\tcoordinate\tspeed\tacceleration\n");
+    moveparam_t tag = {.coord = G.X, .speed = G.V};
+    if(!model_move2(&model, &tag, 0.)) ERRX("Can't move to %g with speed %g", G.X, G.V);
+    double tstart = 0.;
+    if(G.T2 > 0.){ // dump part before second command
+        dumpramp(f, &model, 0., G.T2);
+        tag.coord = G.X2;
+        tag.speed = (G.V2 > 0.) ? G.V2 : G.V;
+        if(!model_move2(&model, &tag, G.T2)) ERRX("Can't move to %g with speed %g", tag.coord, tag.speed);
+        tstart = G.T2;
+    }
+    double tend = model.stoppedtime(&model);
+    if(tend < tstart) tend = tstart;
+    dumpramp(f, &model, tstart, tend + G.dt);
+    if(f != stdout) fclose(f);
+    if(G.Nbench > 0) bench(&model, tend);
+    model_free(&model);
+    return 0;
+}
@@ -82,6 +82,7 @@ void signals(int sig){
     }
     Mount.stop();
     sleep(1);
+    dumpstats(stderr);
     Mount.quit();
     if(fcoords) fclose(fcoords);
     exit(sig);
@@ -0,0 +1,253 @@
+/*
+ * This file is part of the libsidservo project.
+ * Copyright 2026 Edward V. Emelianov <edward.emelianoff@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// throughput and latency of the whole serial stack (I/O queue, transactions, parsing of answers) on real mount or
+// on emulator (ssiiemu): status requests and encoders' data, synchronous short/long commands, stream of
+// asynchronous long commands and text commands; allocations of memory in each test are counted, program returns 1
+// if any allocation was made by short, long or asynchronous long commands (they should use no heap)
+
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <usefull_macros.h>
+
+#include "conf.h"
+#include "sidservo.h"
+
+typedef struct{
+    int help;
+    int Ncmd;           // amount of commands in each test
+    double tpassive;    // duration of passive test
+    char *conffile;
+} parameters;
+
+static conf_t *Config = NULL;
+static parameters G = {
+    .Ncmd = 200,
+    .tpassive = 5.,
+};
+
+static sl_option_t cmdlnopts[] = {
+    {"help",        NO_ARGS,    NULL,   'h',    arg_int,    APTR(&G.help),      "show this help"},
+    {"ncmd",        NEED_ARG,   NULL,   'n',    arg_int,    APTR(&G.Ncmd),      "amount of commands in each test (default: 200)"},
+    {"tpassive",    NEED_ARG,   NULL,   't',    arg_double, APTR(&G.tpassive),  "duration of status/encoders test (default: 5 seconds)"},
+    {"conffile",    NEED_ARG,   NULL,   'C',    arg_string, APTR(&G.conffile),  "configuration file name"},
+    end_option
+};
+
+// counting allocator: calls of malloc/calloc/realloc (by library and by program) while `counting` is set
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+static atomic_int counting = 0;
+static atomic_long nallocs = 0;
+static inline void countalloc(){
+    if(atomic_load_explicit(&counting, memory_order_relaxed)) atomic_fetch_add_explicit(&nallocs, 1, memory_order_relaxed);
+}
+void *malloc(size_t size){
+    countalloc();
+    return __libc_malloc(size);
+}
+void *calloc(size_t n, size_t size){
+    countalloc();
+    return __libc_calloc(n, size);
+}
+void *realloc(void *ptr, size_t size){
+    countalloc();
+    return __libc_realloc(ptr, size);
+}
+static void allocs_start(){
+    atomic_store(&nallocs, 0);
+    atomic_store(&counting, 1);
+}
+static long allocs_stop(){
+    atomic_store(&counting, 0);
+    return atomic_load(&nallocs);
+}
+
+void signals(int sig){
+    if(sig){
+        signal(sig, SIG_IGN);
+        DBG("Get signal %d, quit.\n", sig);
+    }
+    Mount.stop();
+    Mount.quit();
+    exit(sig);
+}
+
+static int cmpdbl(const void *a, const void *b){
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// print line of results: times of `n` commands (sorted inside), total time of test and amount of allocations
+static void printres(const char *name, double *t, int n, double ttotal, long nalloc){
+    if(n < 1){
+        printf("%-12s no successful commands\n", name);
+        return;
+    }
+    qsort(t, n, sizeof(double), cmpdbl);
+    double sum = 0.;
+    for(int i = 0; i < n; ++i) sum += t[i];
+    printf("%-12s %6d %10.2f %9.3f %9.3f %9.3f %9.3f %7ld\n", name, n, n / ttotal, sum / n * 1e3,
+           t[n / 2] * 1e3, t[(n * 99) / 100] * 1e3, t[n - 1] * 1e3, nalloc);
+}
+
+// upper border of histogram bin containing `q` quantile, s
+static double histq(const mcc_hist_t *h, double q){
+    uint64_t thres = (uint64_t)(q * h->n), sum = 0;
+    for(int i = 0; i < MCC_HIST_NBINS - 1; ++i){
+        sum += h->bins[i];
+        if(sum > thres) return (double)(1 << i) * 1e-6;
+    }
+    return h->max;
+}
+
+// print histogram as line of results (percentiles are upper borders of bins)
+static void printhist(const char *name, const mcc_hist_t *h, double ttotal, long nalloc){
+    if(h->n == 0){
+        printf("%-12s no data\n", name);
+        return;
+    }
+    printf("%-12s %6llu %10.2f %9.3f <%8.3f <%8.3f %9.3f %7ld\n", name, (unsigned long long)h->n, h->n / ttotal,
+           h->mean * 1e3, histq(h, 0.5) * 1e3, histq(h, 0.99) * 1e3, h->max * 1e3, nalloc);
+}
+
+// current position of axes (encoders)
+static void curpos(coordpair_t *c){
+    mountdata_t d;
+    if(MCC_E_OK != Mount.getMountData(&d)) ERRX("Can't get mount data");
+    c->X = d.encXposition.val;
+    c->Y = d.encYposition.val;
+}
+
+// synchronous commands: type 0 - short, 1 - long, 2 - text (setSpeed: two text commands); @return amount of allocations
+static long synctest(int type, double *t){
+    static const char *names[3] = {"short", "long", "text"};
+    coordpair_t c, speed;
+    curpos(&c);
+    if(MCC_E_OK != Mount.getMaxSpeed(&speed)) ERRX("Can't get max speed");
+    short_command_t s = {.Xmot = c.X, .Ymot = c.Y, .Xspeed = speed.X, .Yspeed = speed.Y};
+    long_command_t l = {.Xmot = c.X, .Ymot = c.Y, .Xspeed = speed.X, .Yspeed = speed.Y};
+    int n = 0;
+    allocs_start();
+    double t0 = sl_dtime();
+    for(int i = 0; i < G.Ncmd; ++i){
+        double tc = sl_dtime();
+        mcc_errcodes_t e = MCC_E_FAILED;
+        switch(type){
+            case 0: e = Mount.shortCmd(&s); break;
+            case 1: e = Mount.longCmd(&l); break;
+            default: e = Mount.setSpeed(&speed);
+        }
+        if(e == MCC_E_OK) t[n++] = sl_dtime() - tc;
+    }
+    double tt = sl_dtime() - t0;
+    long nalloc = allocs_stop();
+    printres(names[type], t, n, tt, nalloc);
+    return nalloc;
+}
+
+static atomic_int ndone = 0, nfailed = 0;
+static void asynccb(mcc_errcodes_t ret, void _U_ *arg){
+    if(ret != MCC_E_OK) atomic_fetch_add(&nfailed, 1);
+    atomic_fetch_add(&ndone, 1);
+}
+
+// stream of asynchronous long commands: throughput by time of all, latency by statistics of library;
+// when queue is full, command is repeated after a while; @return amount of allocations
+static long asynctest(){
+    coordpair_t c, speed;
+    curpos(&c);
+    if(MCC_E_OK != Mount.getMaxSpeed(&speed)) ERRX("Can't get max speed");
+    long_command_t l = {.Xmot = c.X, .Ymot = c.Y, .Xspeed = speed.X, .Yspeed = speed.Y};
+    atomic_store(&ndone, 0);
+    atomic_store(&nfailed, 0);
+    Mount.resetStats();
+    allocs_start();
+    double t0 = sl_dtime();
+    for(int i = 0; i < G.Ncmd; ++i){
+        while(MCC_E_OK != Mount.longCmdAsync(&l, asynccb, NULL)){
+            if(sl_dtime() - t0 > 60.){ // I/O thread is dead
+                atomic_fetch_add(&nfailed, 1);
+                atomic_fetch_add(&ndone, 1);
+                break;
+            }
+            usleep(100);
+        }
+    }
+    while(atomic_load(&ndone) < G.Ncmd && sl_dtime() - t0 < 60.) usleep(1000);
+    double tt = sl_dtime() - t0;
+    long nalloc = allocs_stop();
+    mcc_hist_t h;
+    if(MCC_E_OK == Mount.getCmdLatency(MCC_CMD_MOTION, &h)) printhist("long async", &h, tt, nalloc);
+    if(atomic_load(&nfailed)) printf("%d async commands failed\n", atomic_load(&nfailed));
+    mcc_stats_t s;
+    if(MCC_E_OK == Mount.getStats(&s) && s.asyncRejected)
+        printf("%llu times queue was full\n", (unsigned long long)s.asyncRejected);
+    return nalloc;
+}
+
+int main(int argc, char **argv){
+    sl_init();
+    sl_parseargs(&argc, &argv, cmdlnopts);
+    if(G.help) sl_showhelp(-1, cmdlnopts);
+    if(G.Ncmd < 1) ERRX("ncmd should be > 0");
+    if(G.tpassive <= 0.) ERRX("tpassive should be > 0");
+    Config = readServoConf(G.conffile);
+    if(!Config){
+        dumpConf();
+        return 1;
+    }
+    if(Config->RunModel) ERRX("Model doesn't use serial devices: run ssiiemu and point its devices in configuration");
+    double *t = calloc(G.Ncmd, sizeof(double));
+    if(!t) ERR("calloc()");
+    double t0 = sl_dtime();
+    mcc_errcodes_t e = Mount.init(Config);
+    if(e != MCC_E_OK) ERRX("Can't init devices: %s", EcodeStr(e));
+    green("init() takes %.3f s\n", sl_dtime() - t0);
+    signal(SIGTERM, signals); // kill (-15) - quit
+    signal(SIGHUP, SIG_IGN);  // hup - ignore
+    signal(SIGINT, signals);  // ctrl+C - quit
+    signal(SIGQUIT, signals); // ctrl+\ - quit
+    signal(SIGTSTP, SIG_IGN); // ignore ctrl+Z
+    printf("test              N   rate(1/s)  mean(ms)   p50(ms)   p99(ms)   max(ms)  allocs\n");
+    // passive: only status requests and encoders
+    Mount.resetStats();
+    allocs_start();
+    usleep((useconds_t)(G.tpassive * 1e6));
+    long nalloc = allocs_stop();
+    mcc_stats_t s;
+    if(MCC_E_OK == Mount.getStats(&s)){
+        printhist("status", &s.cmdRTT[MCC_CMD_STATUS], G.tpassive, nalloc);
+        printhist("encoders", &s.encInterval, G.tpassive, nalloc);
+    }
+    long hotallocs = synctest(0, t) + synctest(1, t);
+    synctest(2, t); // text commands use stdio, don't count them
+    hotallocs += asynctest();
+    free(t);
+    Mount.stop();
+    Mount.quit();
+    if(hotallocs){
+        WARNX("%ld allocations in hot path of short/long commands", hotallocs);
+        return 1;
+    }
+    return 0;
+}
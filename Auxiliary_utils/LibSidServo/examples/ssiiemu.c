@@ -0,0 +1,744 @@
+/*
+ * This file is part of the libsidservo project.
+ * Copyright 2026 Edward V. Emelianov <edward.emelianoff@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// emulator of SiTech SSII controller and encoders on pseudo-terminals: mount answers to status requests, short/long
+// binary commands, configuration and text commands; encoders give data by SSII encoder protocol (one device) or
+// by requests (two devices); axes are moved by moving model of library; answers are given with latency, jitter and
+// transmission time by given baudrate, encoders have gaussian noise
+
+// for posix_openpt() and so on
+#define _GNU_SOURCE
+#include <byteswap.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <usefull_macros.h>
+
+#include "movingmodel.h"
+#include "serial.h"
+#include "ssii.h"
+
+// motor and axis encoders' steps per revolution (library defaults)
+#define EMU_XMOTSTEPS   (13312000.)
+#define EMU_YMOTSTEPS   (17578668.)
+#define EMU_ENCSTEPS    (67108864.)
+// size of mount input buffer
+#define EMU_BUFSZ       (256)
+// max waiting of space in PTY for next packet, ms
+#define EMU_WRTMOUT     (100)
+// firmware version *10 and serial number
+#define EMU_FIRMVER     (384)
+#define EMU_SERIAL      (20260001)
+
+typedef struct{
+    int help;
+    int enctype;        // 0 - encoders in SSII status, 1 - one encoder device, 2 - two devices
+    int verbose;
+    int seed;
+    int mntspeed;       // emulated baudrate of mount (0 - no transmission time)
+    int encspeed;       // -//- of encoders
+    double latency;     // answer latency of mount, ms
+    double jitter;      // its RMS, ms
+    double enclatency;  // answer latency of encoders, ms
+    double encrate;     // rate of encoder's packets for enctype==1, Hz
+    double noise;       // RMS of encoders' noise, ticks
+    double pe;          // amplitude of periodic error of worms, arcsec
+    int teeth;          // teeth of worm wheels
+    double dt;          // model step, s
+    double X0;          // starting position, degrees
+    double Y0;
+    char *mntpath;      // symlinks to slave PTYs
+    char *encpath;
+    char *encXpath;
+    char *encYpath;
+} parameters;
+
+static parameters G = {
+    .enctype = 2,
+    .seed = 1,
+    .mntspeed = 19200,
+    .encspeed = 153000,
+    .latency = 1.,
+    .jitter = 0.2,
+    .enclatency = 0.1,
+    .encrate = 500.,
+    .noise = 1.,
+    .teeth = 360,
+    .dt = 0.001,
+};
+
+static sl_option_t cmdlnopts[] = {
+    {"help",        NO_ARGS,    NULL,   'h',    arg_int,    APTR(&G.help),      "show this help"},
+    {"enctype",     NEED_ARG,   NULL,   'e',    arg_int,    APTR(&G.enctype),   "encoders: 0 - in SSII status, 1 - one device, 2 - two devices (default: 2)"},
+    {"verbose",     NO_ARGS,    NULL,   'v',    arg_int,    APTR(&G.verbose),   "show all commands got"},
+    {"seed",        NEED_ARG,   NULL,   's',    arg_int,    APTR(&G.seed),      "seed of random generator (default: 1)"},
+    {"mntspeed",    NEED_ARG,   NULL,   'b',    arg_int,    APTR(&G.mntspeed),  "baudrate of mount for transmission time (default: 19200, 0 - no delays)"},
+    {"encspeed",    NEED_ARG,   NULL,   'B',    arg_int,    APTR(&G.encspeed),  "baudrate of encoders (default: 153000, 0 - no delays)"},
+    {"latency",     NEED_ARG,   NULL,   'l',    arg_double, APTR(&G.latency),   "latency of mount answers, ms (default: 1)"},
+    {"jitter",      NEED_ARG,   NULL,   'j',    arg_double, APTR(&G.jitter),    "RMS of mount latency, ms (default: 0.2)"},
+    {"enclatency",  NEED_ARG,   NULL,   'L',    arg_double, APTR(&G.enclatency),"latency of encoders, ms (default: 0.1)"},
+    {"encrate",     NEED_ARG,   NULL,   'r',    arg_double, APTR(&G.encrate),   "rate of encoder packets for enctype=1, Hz (default: 500)"},
+    {"noise",       NEED_ARG,   NULL,   'n',    arg_double, APTR(&G.noise),     "RMS of encoders' noise, ticks (default: 1)"},
+    {"pe",          NEED_ARG,   NULL,   'p',    arg_double, APTR(&G.pe),        "amplitude of worms' periodic error, arcsec (default: 0)"},
+    {"teeth",       NEED_ARG,   NULL,   'T',    arg_int,    APTR(&G.teeth),     "teeth of worm wheels (default: 360)"},
+    {"dt",          NEED_ARG,   NULL,   't',    arg_double, APTR(&G.dt),        "step of model, s (default: 0.001)"},
+    {"x0",          NEED_ARG,   NULL,   '0',    arg_double, APTR(&G.X0),        "starting X position, degrees"},
+    {"y0",          NEED_ARG,   NULL,   '1',    arg_double, APTR(&G.Y0),        "starting Y position, degrees"},
+    {"mntpath",     NEED_ARG,   NULL,   'm',    arg_string, APTR(&G.mntpath),   "make symlink to mount PTY with this name"},
+    {"encpath",     NEED_ARG,   NULL,   'E',    arg_string, APTR(&G.encpath),   "-//- to encoder PTY (enctype=1)"},
+    {"encXpath",    NEED_ARG,   NULL,   'x',    arg_string, APTR(&G.encXpath),  "-//- to X encoder PTY (enctype=2)"},
+    {"encYpath",    NEED_ARG,   NULL,   'y',    arg_string, APTR(&G.encYpath),  "-//- to Y encoder PTY (enctype=2)"},
+    end_option
+};
+
+// emulated axis
+typedef struct{
+    movemodel_t model;
+    moveparam_t cur;        // current position/speed, rad
+    double motsteps;        // motor steps per revolution
+    double motoffset;       // motor position minus axis position (changed by "XF"), rad
+    double encoffset;       // encoder offset (changed by "XZ"), ticks
+    double speed;           // speed of text moving commands, rad/s
+    // adder of long command (moves target by itself)
+    int adder;
+    double acoord, aspeed, arate, at0, atend;
+} axis_t;
+
+// the same limits as library has
+static const limits_t
+    Xlim = {
+        .min = {.coord = -3.1241, .speed = 1e-10, .accel = 1e-6},
+        .max = {.coord = 3.1241, .speed = 0.174533, .accel = 0.219911}},
+    Ylim = {
+        .min = {.coord = -3.1241, .speed = 1e-10, .accel = 1e-6},
+        .max = {.coord = 3.1241, .speed = 0.139626, .accel = 0.165806}};
+
+static axis_t axes[2];
+static SSconfig Config; // configuration in "flash" (changed by "FC" and setters)
+static pthread_mutex_t emumutex = PTHREAD_MUTEX_INITIALIZER;
+static double T0 = 0.; // monotonic time of start
+static volatile int stopflag = 0;
+
+// statistics
+typedef enum{
+    EMU_STAT,       // status requests
+    EMU_SHORT,      // short binary commands
+    EMU_LONG,       // long binary commands
+    EMU_CONF,       // configuration requests
+    EMU_TEXT,       // other text commands
+    EMU_BADSUM,     // binary commands with bad checksum
+    EMU_UNKNOWN,    // unknown commands
+    EMU_ENC,        // encoders' answers/packets
+    EMU_ENCDROP,    // encoders' packets dropped (nobody reads)
+    EMU_AMOUNT
+} emustat_t;
+static unsigned long long emustat[EMU_AMOUNT] = {0};
+static pthread_mutex_t statmutex = PTHREAD_MUTEX_INITIALIZER;
+static void statinc(emustat_t s){
+    pthread_mutex_lock(&statmutex);
+    ++emustat[s];
+    pthread_mutex_unlock(&statmutex);
+}
+
+// time from start (by monotonic clock), s
+static double tnow(){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec + (double)t.tv_nsec / 1e9 - T0;
+}
+// sleep until time `t` from start
+static void sleepuntil(double t){
+    t += T0;
+    struct timespec ts = {.tv_sec = (time_t)t, .tv_nsec = (long)((t - floor(t)) * 1e9)};
+    while(EINTR == clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL));
+}
+
+// gaussian random value with zero mean and unit RMS
+static double gauss(unsigned short xsubi[3]){
+    double u1 = erand48(xsubi), u2 = erand48(xsubi);
+    if(u1 < 1e-300) u1 = 1e-300;
+    return sqrt(-2. * log(u1)) * cos(2. * M_PI * u2);
+}
+
+// conversion of motor units (steps; speed - steps per loop * 65536) to radians
+static double mot2rad(const axis_t *a, double n){ return 2. * M_PI * n / a->motsteps; }
+static int32_t rad2mot(const axis_t *a, double r){ return (int32_t)lround(r / (2. * M_PI) * a->motsteps); }
+static double motspd2rs(const axis_t *a, double n){ return mot2rad(a, n) / 65536. * SITECH_LOOP_FREQUENCY; }
+static int32_t rs2motspd(const axis_t *a, double r){
+    return (int32_t)lround(r / (2. * M_PI) * a->motsteps * 65536. / SITECH_LOOP_FREQUENCY);
+}
+
+// motor position of axis, steps (should be run under emumutex)
+static int32_t motpos(const axis_t *a){ return rad2mot(a, a->cur.coord + a->motoffset); }
+// periodic error of worm (with second harmonic) by motor's position, rad
+static double perr(const axis_t *a){
+    if(G.pe == 0. || G.teeth < 1) return 0.;
+    double ph = G.teeth * (a->cur.coord + a->motoffset);
+    return G.pe * (sin(ph) + 0.3 * sin(2. * ph + 1.)) * M_PI / (180. * 3600.);
+}
+// encoder position of axis with noise and worm's error, ticks (-//-)
+static int32_t encpos(const axis_t *a, unsigned short xsubi[3]){
+    double n = (a->cur.coord + perr(a)) / (2. * M_PI) * EMU_ENCSTEPS + a->encoffset;
+    if(G.noise > 0.) n += G.noise * gauss(xsubi);
+    return (int32_t)lround(n);
+}
+
+// move axis to `coord` (rad) with max speed `speed` (adder is cancelled), should be run under emumutex
+static void axis_move(axis_t *a, double coord, double speed, double t){
+    a->adder = 0;
+    moveparam_t p = {.coord = coord, .speed = speed};
+    if(coord > a->model.Max.coord || coord < a->model.Min.coord){
+        if(G.verbose) WARNX("Target %g is out of limits", coord);
+        return;
+    }
+    if(!model_move2(&a->model, &p, t) && G.verbose) WARNX("Can't move to %g", coord);
+}
+
+// change model state for time `t` (under emumutex)
+static void axes_update(double t){
+    for(int i = 0; i < 2; ++i){
+        axis_t *a = &axes[i];
+        moveparam_t p;
+        if(ST_MOVE == a->model.get_state(&a->model, &p)) a->model.proc_move(&a->model, &p, t);
+        a->cur = p;
+        if(!a->adder) continue;
+        // target of long command moves by adder
+        double ta = t;
+        if(ta >= a->atend){
+            ta = a->atend;
+            a->adder = 0;
+        }
+        moveparam_t tag = {.coord = a->acoord + a->arate * (ta - a->at0), .speed = a->aspeed};
+        model_move2(&a->model, &tag, t);
+    }
+}
+
+// model thread: change axes' state each G.dt
+static void *modelthread(void _U_ *u){
+    double t = tnow();
+    while(!stopflag){
+        pthread_mutex_lock(&emumutex);
+        axes_update(t);
+        pthread_mutex_unlock(&emumutex);
+        t += G.dt;
+        sleepuntil(t);
+    }
+    return NULL;
+}
+
+/**
+ * @brief newpty - open new pseudo-terminal in raw mode
+ * @param link - name of symlink to its slave (or NULL)
+ * @param slave (o) - fd of slave (kept opened so PTY stays alive when clients close it)
+ * @return fd of master or -1
+ */
+static int newpty(const char *link, int *slave){
+    int m = posix_openpt(O_RDWR | O_NOCTTY);
+    if(m < 0){
+        WARN("posix_openpt()");
+        return -1;
+    }
+    char *name = NULL;
+    if(grantpt(m) || unlockpt(m) || !(name = ptsname(m))){
+        WARN("Can't unlock PTY");
+        close(m);
+        return -1;
+    }
+    int s = open(name, O_RDWR | O_NOCTTY);
+    struct termios tty;
+    if(s < 0 || tcgetattr(s, &tty)){
+        WARN("Can't open %s", name);
+        if(s > -1) close(s);
+        close(m);
+        return -1;
+    }
+    cfmakeraw(&tty);
+    tcsetattr(s, TCSANOW, &tty);
+    *slave = s;
+    if(link){
+        struct stat st;
+        if(0 == lstat(link, &st)){
+            if(!S_ISLNK(st.st_mode)) ERRX("%s exists and it isn't symlink", link);
+            unlink(link);
+        }
+        if(symlink(name, link)) ERR("Can't make symlink %s", link);
+    }
+    return m;
+}
+
+// write all data to `fd`; non-blocking fd: wait until PTY can take more, but drop whole packet if nobody
+// reads it for EMU_WRTMOUT ms (packet once started is never truncated); @return FALSE if failed or dropped
+static int writeall(int fd, const uint8_t *buf, size_t len){
+    size_t total = len;
+    while(len){
+        ssize_t l = write(fd, buf, len);
+        if(l < 0){
+            if(errno == EINTR) continue;
+            if(errno != EAGAIN && errno != EWOULDBLOCK) return FALSE;
+            struct pollfd pfd = {.fd = fd, .events = POLLOUT};
+            int p = poll(&pfd, 1, EMU_WRTMOUT);
+            if(p < 0 && errno != EINTR) return FALSE;
+            if(p == 0 && len == total) return FALSE; // nothing written yet: drop
+            if(stopflag) return FALSE;
+            continue;
+        }
+        buf += l;
+        len -= (size_t)l;
+    }
+    return TRUE;
+}
+
+/**
+ * @brief delay - sleep for answer latency and transmission time
+ * @param latency - mean latency, s
+ * @param jitter - its RMS, s
+ * @param len - amount of bytes
+ * @param baud - baudrate (0 - no transmission time)
+ */
+static void delay(double latency, double jitter, size_t len, int baud, unsigned short xsubi[3]){
+    double d = latency;
+    if(jitter > 0.) d += jitter * gauss(xsubi);
+    if(baud > 0) d += 10. * (double)len / (double)baud; // start + 8 data + stop bits
+    if(d > 0.) sleepuntil(tnow() + d);
+}
+
+// fill status (under emumutex)
+static void fillstat(SSstat *s, unsigned short xsubi[3]){
+    bzero(s, sizeof(SSstat));
+    s->ctrlAddr = 0xa8;
+    s->Xmot = motpos(&axes[0]);
+    s->Ymot = motpos(&axes[1]);
+    s->Xenc = encpos(&axes[0], xsubi);
+    s->Yenc = encpos(&axes[1], xsubi);
+    s->millis = (uint32_t)(tnow() * 1e3);
+    s->tF = 50;
+    s->voltage = 120;
+    s->XLast = (uint32_t)s->Xmot;
+    s->YLast = (uint32_t)s->Ymot;
+    s->checksum = SScalcChecksum((uint8_t*)s, sizeof(SSstat) - 2);
+}
+
+// simplest checksum of configuration
+static uint16_t confsum(const SSconfig *c){
+    uint16_t sum = 0;
+    const uint8_t *b = (const uint8_t*)c;
+    for(size_t i = 0; i < sizeof(SSconfig) - 2; ++i) sum += b[i];
+    return sum;
+}
+
+// fill hardware configuration
+static void fillconf(SSconfig *c){
+    bzero(c, sizeof(SSconfig));
+    AxeConfig *ac[2] = {&c->Xconf, &c->Yconf};
+    const limits_t *l[2] = {&Xlim, &Ylim};
+    for(int i = 0; i < 2; ++i){
+        ac[i]->accel = (uint32_t)rs2motspd(&axes[i], l[i]->max.accel / SITECH_LOOP_FREQUENCY);
+        ac[i]->errlimit = 32000;
+        ac[i]->propgain = 300;
+        ac[i]->intgain = 10;
+        ac[i]->derivgain = 1000;
+        ac[i]->outplimit = 255;
+        ac[i]->currlimit = 200;
+        ac[i]->intlimit = 24000;
+    }
+    c->latitude = bswap_16(4367);
+    c->Xsetpr = c->Ysetpr = bswap_32((uint32_t)EMU_ENCSTEPS);
+    c->Xmetpr = bswap_32((uint32_t)axes[0].motsteps);
+    c->Ymetpr = bswap_32((uint32_t)axes[1].motsteps);
+    c->Xslewrate = rs2motspd(&axes[0], Xlim.max.speed);
+    c->Yslewrate = rs2motspd(&axes[1], Ylim.max.speed);
+    c->Xpanrate = c->Xslewrate / 10;
+    c->Ypanrate = c->Yslewrate / 10;
+    c->Xguiderate = c->Xslewrate / 100;
+    c->Yguiderate = c->Yslewrate / 100;
+    c->checksum = confsum(c);
+}
+
+// fields of configuration changed by text commands
+typedef struct{
+    const char *cmd;
+    size_t off;     // offset in SSconfig
+    size_t len;     // size, bytes
+    int msb;        // ==1 if stored MSB first
+} conffield_t;
+#define CF(cmd, fld, msb)  {cmd, offsetof(SSconfig, fld), sizeof(((SSconfig*)0)->fld), msb}
+static const conffield_t conffields[] = {
+    CF(CMD_MOTXACCEL, Xconf.accel, 0),      CF(CMD_MOTYACCEL, Yconf.accel, 0),
+    CF(CMD_POSERRLIMX, Xconf.errlimit, 0),  CF(CMD_POSERRLIMY, Yconf.errlimit, 0),
+    CF(CMD_PIDPX, Xconf.propgain, 0),       CF(CMD_PIDPY, Yconf.propgain, 0),
+    CF(CMD_PIDIX, Xconf.intgain, 0),        CF(CMD_PIDIY, Yconf.intgain, 0),
+    CF(CMD_PIDDX, Xconf.derivgain, 0),      CF(CMD_PIDDY, Yconf.derivgain, 0),
+    CF(CMD_PWMOUTX, Xconf.outplimit, 0),    CF(CMD_PWMOUTY, Yconf.outplimit, 0),
+    CF(CMD_MOTCURNTX, Xconf.currlimit, 0),  CF(CMD_MOTCURNTY, Yconf.currlimit, 0),
+    CF(CMD_PIDILX, Xconf.intlimit, 0),      CF(CMD_PIDILY, Yconf.intlimit, 0),
+    CF(CMD_BITSX, xbits, 0),                CF(CMD_BITSY, ybits, 0),
+    CF(CMD_LATITUDE, latitude, 1),
+    CF(CMD_SLEWRATEX, Xslewrate, 0),        CF(CMD_SLEWRATEY, Yslewrate, 0),
+    CF(CMD_PANRATEX, Xpanrate, 0),          CF(CMD_PANRATEY, Ypanrate, 0),
+    CF(CMD_GUIDERATEX, Xguiderate, 0),      CF(CMD_GUIDERATEY, Yguiderate, 0),
+};
+
+/**
+ * @brief conffield - get or set field of configuration by text command (should be run under emumutex)
+ * @param cmd - command
+ * @param set - ==1 to set value
+ * @param val (io) - value
+ * @return FALSE if there's no such field
+ */
+static int conffield(const char *cmd, int set, int64_t *val){
+    for(size_t i = 0; i < sizeof(conffields) / sizeof(conffield_t); ++i){
+        const conffield_t *f = &conffields[i];
+        if(strcmp(cmd, f->cmd)) continue;
+        uint8_t *p = (uint8_t*)&Config + f->off;
+        if(set){
+            uint64_t u = (uint64_t)*val;
+            for(size_t b = 0; b < f->len; ++b, u >>= 8) p[f->msb ? f->len - 1 - b : b] = (uint8_t)u;
+            Config.checksum = confsum(&Config);
+        }else{
+            uint64_t u = 0;
+            for(size_t b = 0; b < f->len; ++b) u = (u << 8) | p[f->msb ? b : f->len - 1 - b];
+            *val = (int64_t)u;
+        }
+        return TRUE;
+    }
+    return FALSE;
+}
+
+// write configuration got by "FC"
+static void progconf(const uint8_t *buf){
+    const SSconfig *c = (const SSconfig*)buf;
+    if(c->checksum != confsum(c)){
+        statinc(EMU_BADSUM);
+        if(G.verbose) WARNX("Bad checksum of configuration");
+        return;
+    }
+    statinc(EMU_CONF);
+    pthread_mutex_lock(&emumutex);
+    Config = *c;
+    pthread_mutex_unlock(&emumutex);
+    if(G.verbose) printf("%.4f: configuration written\n", tnow());
+}
+
+/**
+ * @brief bincmd - run short or long binary command
+ * @param buf - command
+ * @param len - its length
+ * @param ans (o) - status after command
+ * @return FALSE if checksum is wrong
+ */
+static int bincmd(uint8_t *buf, size_t len, SSstat *ans, unsigned short xsubi[3]){
+    SSscmd *s = (SSscmd*)buf;
+    SSlcmd *l = (SSlcmd*)buf;
+    uint16_t sum = (len == sizeof(SSscmd)) ? s->checksum : l->checksum;
+    if(sum != SScalcChecksum(buf, (int)len - 2)){
+        statinc(EMU_BADSUM);
+        return FALSE;
+    }
+    statinc((len == sizeof(SSscmd)) ? EMU_SHORT : EMU_LONG);
+    int32_t mot[2] = {s->Xmot, s->Ymot}, spd[2] = {s->Xspeed, s->Yspeed};
+    pthread_mutex_lock(&emumutex);
+    double t = tnow();
+    for(int i = 0; i < 2; ++i){
+        axis_t *a = &axes[i];
+        double coord = mot2rad(a, mot[i]) - a->motoffset, speed = fabs(motspd2rs(a, spd[i]));
+        axis_move(a, coord, speed, t);
+        if(len != sizeof(SSlcmd)) continue;
+        double rate = motspd2rs(a, i ? l->Yadder : l->Xadder), atime = ADDER2S(i ? l->Yatime : l->Xatime);
+        if(rate != 0. && atime > 0.){
+            a->adder = 1;
+            a->acoord = coord;
+            a->aspeed = speed;
+            a->arate = rate;
+            a->at0 = t;
+            a->atend = t + atime;
+        }
+    }
+    fillstat(ans, xsubi);
+    pthread_mutex_unlock(&emumutex);
+    if(G.verbose) printf("%.4f: %s X=%d Y=%d\n", tnow(), (len == sizeof(SSscmd)) ? "short" : "long", mot[0], mot[1]);
+    return TRUE;
+}
+
+/**
+ * @brief textcmd - run text command
+ * @param cmd - command (without EOL)
+ * @param ans (o) - answer
+ * @param maxlen - size of `ans`
+ * @param binlen (o) - length of binary data waited after this command (or unchanged)
+ * @return length of answer
+ */
+static size_t textcmd(char *cmd, uint8_t *ans, size_t maxlen, size_t *binlen, unsigned short xsubi[3]){
+    // skip trash (e.g. last byte of CMD_EXITACM)
+    while(*cmd && !(*cmd >= 'A' && *cmd <= 'Z')) ++cmd;
+    if(!*cmd) return 0;
+    if(G.verbose) printf("%.4f: %s\n", tnow(), cmd);
+    if(0 == strcmp(cmd, CMD_GETSTAT)){
+        statinc(EMU_STAT);
+        pthread_mutex_lock(&emumutex);
+        fillstat((SSstat*)ans, xsubi);
+        pthread_mutex_unlock(&emumutex);
+        return sizeof(SSstat);
+    }
+    if(0 == strcmp(cmd, CMD_SHORTCMD)){ *binlen = sizeof(SSscmd); return 0; }
+    if(0 == strcmp(cmd, CMD_LONGCMD)){ *binlen = sizeof(SSlcmd); return 0; }
+    if(0 == strcmp(cmd, CMD_DUMPFLASH)){
+        statinc(EMU_CONF);
+        pthread_mutex_lock(&emumutex);
+        memcpy(ans, &Config, sizeof(SSconfig));
+        pthread_mutex_unlock(&emumutex);
+        return sizeof(SSconfig);
+    }
+    if(0 == strcmp(cmd, CMD_PROGFLASH)){ *binlen = sizeof(SSconfig); return 0; }
+    statinc(EMU_TEXT);
+    // split command to name and optional integer argument
+    char *p = cmd;
+    while(*p >= 'A' && *p <= 'Z') ++p;
+    int hasarg = (*p != 0);
+    long arg = hasarg ? strtol(p, NULL, 10) : 0;
+    *p = 0;
+    int64_t val = 0;
+    int isget = !hasarg, known = TRUE;
+    int ax = (cmd[0] == 'Y') ? 1 : 0;
+    axis_t *a = &axes[ax];
+    pthread_mutex_lock(&emumutex);
+    double t = tnow();
+    if(0 == strcmp(cmd, "X") || 0 == strcmp(cmd, "Y")){
+        if(isget) val = motpos(a);
+        else axis_move(a, mot2rad(a, arg) - a->motoffset, a->speed, t);
+    }else if(0 == strcmp(cmd, CMD_SPEEDX) || 0 == strcmp(cmd, CMD_SPEEDY)){
+        if(isget) val = rs2motspd(a, a->speed);
+        else a->speed = fabs(motspd2rs(a, arg));
+    }else if(0 == strcmp(cmd, CMD_MOTXSET) || 0 == strcmp(cmd, CMD_MOTYSET)){
+        a->model.emergency_stop(&a->model, t);
+        a->adder = 0;
+        a->motoffset = mot2rad(a, arg) - a->cur.coord;
+    }else if(0 == strcmp(cmd, CMD_ENCX) || 0 == strcmp(cmd, CMD_ENCY)){
+        if(isget) val = encpos(a, xsubi);
+        else a->encoffset = (double)arg - a->cur.coord / (2. * M_PI) * EMU_ENCSTEPS;
+    }else if(0 == strcmp(cmd, CMD_STOPX) || 0 == strcmp(cmd, CMD_STOPY) ||
+             0 == strcmp(cmd, CMD_STOPTRACKX) || 0 == strcmp(cmd, CMD_STOPTRACKY)){
+        a->adder = 0;
+        a->model.stop(&a->model, t);
+    }else if(0 == strcmp(cmd, CMD_EMSTOPX) || 0 == strcmp(cmd, CMD_EMSTOPY)){
+        a->adder = 0;
+        a->model.emergency_stop(&a->model, t);
+    }else if(0 == strcmp(cmd, CMD_MEPRX) || 0 == strcmp(cmd, CMD_MEPRY)){
+        ax = (0 == strcmp(cmd, CMD_MEPRY));
+        val = (int64_t)axes[ax].motsteps;
+    }else if(0 == strcmp(cmd, CMD_AEPRX) || 0 == strcmp(cmd, CMD_AEPRY)) val = (int64_t)EMU_ENCSTEPS;
+    else if(0 == strcmp(cmd, CMD_FIRMVER)) val = EMU_FIRMVER;
+    else if(0 == strcmp(cmd, CMD_SERIAL)) val = EMU_SERIAL;
+    else if(0 == strcmp(cmd, CMD_MILLIS)) val = (int64_t)(t * 1e3);
+    else if(0 == strcmp(cmd, CMD_TCPU)) val = 50;
+    else if(0 == strcmp(cmd, CMD_MOTVOLTAGE)) val = 120;
+    else if(0 == strcmp(cmd, CMD_AUTOX) || 0 == strcmp(cmd, CMD_AUTOY) || 0 == strcmp(cmd, "YXY") ||
+            0 == strcmp(cmd, CMD_WRITEFLASH) || 0 == strcmp(cmd, CMD_READFLASH)) isget = FALSE; // nothing to do
+    else{
+        val = arg;
+        known = conffield(cmd, !isget, &val);
+    }
+    pthread_mutex_unlock(&emumutex);
+    if(!known){
+        statinc(EMU_UNKNOWN);
+        if(G.verbose) WARNX("Unknown command %s", cmd);
+        return 0;
+    }
+    if(!isget) return 0;
+    int l = snprintf((char*)ans, maxlen, "%lld\r", (long long)val);
+    return (l > 0 && (size_t)l < maxlen) ? (size_t)l : 0;
+}
+
+// mount thread: read commands and answer
+static void *mountthread(void *arg){
+    int fd = *(int*)arg;
+    unsigned short xsubi[3] = {0x330e, (unsigned short)G.seed, 1};
+    uint8_t in[EMU_BUFSZ], buf[EMU_BUFSZ + 1], ans[EMU_BUFSZ];
+    size_t len = 0, binlen = 0;
+    struct pollfd pfd = {.fd = fd, .events = POLLIN};
+    while(!stopflag){
+        int p = poll(&pfd, 1, 100);
+        if(p < 1 || !(pfd.revents & POLLIN)) continue;
+        ssize_t l = read(fd, in, sizeof(in));
+        if(l < 1) continue;
+        for(ssize_t i = 0; i < l; ++i){
+            size_t alen = 0;
+            if(binlen){ // binary data of short/long command
+                buf[len++] = in[i];
+                if(len < binlen) continue;
+                if(binlen == sizeof(SSconfig)) progconf(buf);
+                else if(bincmd(buf, len, (SSstat*)ans, xsubi)) alen = sizeof(SSstat);
+                else if(G.verbose) WARNX("Bad checksum of binary command");
+                len = binlen = 0;
+            }else if(in[i] == '\r'){
+                buf[len] = 0;
+                alen = textcmd((char*)buf, ans, sizeof(ans), &binlen, xsubi);
+                len = 0;
+            }else if(len < EMU_BUFSZ) buf[len++] = in[i];
+            if(alen){
+                delay(G.latency / 1e3, G.jitter / 1e3, alen, G.mntspeed, xsubi);
+                if(!writeall(fd, ans, alen) && G.verbose) WARN("write()");
+            }
+        }
+    }
+    return NULL;
+}
+
+// packet of encoder by SSII protocol
+static void encpacket(uint8_t pkt[ENC_DATALEN], int32_t X, int32_t Y){
+    pkt[0] = ENC_MAGICK;
+    memcpy(&pkt[1], &Y, 4);
+    memcpy(&pkt[5], &X, 4);
+    uint32_t sum = 0;
+    for(int i = 1; i < 9; ++i) sum += pkt[i];
+    uint8_t x = sum >> 8;
+    pkt[9] = x;
+    pkt[10] = ((0xFFFF - sum) & 0xFF) - x;
+    pkt[11] = (0xFFFF - sum) >> 8;
+    pkt[12] = 0;
+}
+
+// encoder thread for one device: packets with rate G.encrate (sampled at period start, sent after latency)
+static void *encthread1(void *arg){
+    int fd = *(int*)arg;
+    unsigned short xsubi[3] = {0x330e, (unsigned short)G.seed, 2};
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    double period = 1. / G.encrate, t = tnow();
+    uint8_t pkt[ENC_DATALEN];
+    while(!stopflag){
+        pthread_mutex_lock(&emumutex);
+        encpacket(pkt, encpos(&axes[0], xsubi), encpos(&axes[1], xsubi));
+        pthread_mutex_unlock(&emumutex);
+        delay(G.enclatency / 1e3, 0., ENC_DATALEN, G.encspeed, xsubi);
+        if(writeall(fd, pkt, ENC_DATALEN)) statinc(EMU_ENC);
+        else statinc(EMU_ENCDROP);
+        t += period;
+        sleepuntil(t);
+    }
+    return NULL;
+}
+
+// encoder thread for two devices: each '\n' got is answered by current position
+static void *encthread2(void *arg){
+    int *fd = (int*)arg;
+    unsigned short xsubi[3] = {0x330e, (unsigned short)G.seed, 3};
+    struct pollfd pfd[2] = {{.fd = fd[0], .events = POLLIN}, {.fd = fd[1], .events = POLLIN}};
+    char in[EMU_BUFSZ], ans[2][32];
+    while(!stopflag){
+        int p = poll(pfd, 2, 100);
+        if(p < 1) continue;
+        int asked[2] = {0};
+        for(int i = 0; i < 2; ++i){
+            if(!(pfd[i].revents & POLLIN)) continue;
+            ssize_t l = read(fd[i], in, sizeof(in));
+            for(ssize_t k = 0; k < l; ++k) if(in[k] == '\n') asked[i] = 1;
+        }
+        if(!asked[0] && !asked[1]) continue;
+        int alen[2] = {0};
+        pthread_mutex_lock(&emumutex);
+        for(int i = 0; i < 2; ++i)
+            if(asked[i]) alen[i] = snprintf(ans[i], sizeof(ans[i]), "%d\n", encpos(&axes[i], xsubi));
+        pthread_mutex_unlock(&emumutex);
+        delay(G.enclatency / 1e3, 0., (size_t)(alen[0] > alen[1] ? alen[0] : alen[1]), G.encspeed, xsubi);
+        for(int i = 0; i < 2; ++i){
+            if(!asked[i]) continue;
+            if(writeall(fd[i], (uint8_t*)ans[i], (size_t)alen[i])) statinc(EMU_ENC);
+            else statinc(EMU_ENCDROP);
+        }
+    }
+    return NULL;
+}
+
+void signals(int sig){
+    if(sig){
+        signal(sig, SIG_IGN);
+        DBG("Get signal %d, quit.\n", sig);
+    }
+    stopflag = 1;
+}
+
+int main(int argc, char **argv){
+    sl_init();
+    sl_parseargs(&argc, &argv, cmdlnopts);
+    if(G.help) sl_showhelp(-1, cmdlnopts);
+    if(G.enctype < 0 || G.enctype > 2) ERRX("enctype should be 0, 1 or 2");
+    if(G.dt <= 0. || G.dt > 0.1) ERRX("dt should be in (0, 0.1]");
+    if(G.enctype == 1 && G.encrate <= 0.) ERRX("encrate should be > 0");
+    T0 = tnow();
+    const limits_t *lim[2] = {&Xlim, &Ylim};
+    double start[2] = {DEG2RAD(G.X0), DEG2RAD(G.Y0)}, motsteps[2] = {EMU_XMOTSTEPS, EMU_YMOTSTEPS};
+    for(int i = 0; i < 2; ++i){
+        axis_t *a = &axes[i];
+        if(!model_init(&a->model, RAMP_TRAPEZIUM, lim[i])) ERRX("Can't init model");
+        if(start[i] > lim[i]->max.coord || start[i] < lim[i]->min.coord) ERRX("Starting position is out of limits");
+        a->model.curparams.coord = a->cur.coord = start[i];
+        a->motsteps = motsteps[i];
+        a->motoffset = -start[i]; // motors' counters are zero after power on
+        a->speed = lim[i]->max.speed;
+    }
+    fillconf(&Config);
+    int slaves[3] = {-1, -1, -1}, mntfd, encfd[2] = {-1, -1};
+    mntfd = newpty(G.mntpath, &slaves[0]);
+    if(mntfd < 0) ERRX("Can't create mount PTY");
+    if(G.enctype == 1){
+        if((encfd[0] = newpty(G.encpath, &slaves[1])) < 0) ERRX("Can't create encoder PTY");
+    }else if(G.enctype == 2){
+        if((encfd[0] = newpty(G.encXpath, &slaves[1])) < 0 || (encfd[1] = newpty(G.encYpath, &slaves[2])) < 0)
+            ERRX("Can't create encoders' PTY");
+    }
+    // lines for configuration file
+    printf("MountDevPath = %s\nMountDevSpeed = %d\nSepEncoder = %d\n", G.mntpath ? G.mntpath : ptsname(mntfd),
+           G.mntspeed > 0 ? G.mntspeed : 19200, G.enctype);
+    if(G.enctype == 1) printf("EncoderDevPath = %s\n", G.encpath ? G.encpath : ptsname(encfd[0]));
+    else if(G.enctype == 2) printf("EncoderXDevPath = %s\nEncoderYDevPath = %s\n",
+               G.encXpath ? G.encXpath : ptsname(encfd[0]), G.encYpath ? G.encYpath : ptsname(encfd[1]));
+    if(G.enctype) printf("EncoderDevSpeed = %d\n", G.encspeed > 0 ? G.encspeed : 153000);
+    fflush(stdout);
+    signal(SIGTERM, signals); // kill (-15) - quit
+    signal(SIGHUP, SIG_IGN);  // hup - ignore
+    signal(SIGINT, signals);  // ctrl+C - quit
+    signal(SIGQUIT, signals); // ctrl+\ - quit
+    signal(SIGTSTP, SIG_IGN); // ignore ctrl+Z
+    pthread_t mthread, mntthread, encthread;
+    if(pthread_create(&mthread, NULL, modelthread, NULL) || pthread_create(&mntthread, NULL, mountthread, &mntfd))
+        ERRX("Can't create threads");
+    if(G.enctype && pthread_create(&encthread, NULL, (G.enctype == 1) ? encthread1 : encthread2, encfd))
+        ERRX("Can't create encoders' thread");
+    green("Emulator is running, press ctrl+C to quit\n");
+    while(!stopflag) pause();
+    pthread_join(mthread, NULL);
+    pthread_join(mntthread, NULL);
+    if(G.enctype) pthread_join(encthread, NULL);
+    const char *links[3] = {G.mntpath, (G.enctype == 1) ? G.encpath : G.encXpath, G.encYpath};
+    for(int i = 0; i < 3; ++i) if(links[i] && slaves[i] > -1) unlink(links[i]);
+    static const char *statnames[EMU_AMOUNT] = {"status requests", "short commands", "long commands",
+        "configuration requests", "text commands", "bad checksums", "unknown commands", "encoders' answers",
+        "encoders' packets dropped"};
+    for(int i = 0; i < EMU_AMOUNT; ++i) printf("%-26s %llu\n", statnames[i], emustat[i]);
+    return 0;
+}
@@ -0,0 +1,112 @@
+/*
+ * This file is part of the libsidservo project.
+ * Copyright 2026 Edward V. Emelianov <edward.emelianoff@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// dump binary telemetry log (Conf.RecordPath) as text: mount data and/or transactions with mount in given time range
+
+#include <ctype.h>
+#include <stdio.h>
+#include <usefull_macros.h>
+
+#include "telelog.h"
+
+typedef struct{
+    int help;
+    int mdonly;         // only telemetry
+    int cmdonly;        // only transactions
+    double tfrom;       // time range
+    double tto;
+    char *log;
+} parameters;
+
+static parameters G = {
+    .tfrom = -1.,
+    .tto = -1.,
+};
+
+static sl_option_t cmdlnopts[] = {
+    {"help",    NO_ARGS,    NULL,   'h',    arg_int,    APTR(&G.help),      "show this help"},
+    {"log",     NEED_ARG,   NULL,   'l',    arg_string, APTR(&G.log),       "binary log file name"},
+    {"from",    NEED_ARG,   NULL,   'f',    arg_double, APTR(&G.tfrom),     "dump records since this time (seconds from init())"},
+    {"to",      NEED_ARG,   NULL,   't',    arg_double, APTR(&G.tto),       "dump records till this time (seconds from init())"},
+    {"mount",   NO_ARGS,    NULL,   'm',    arg_int,    APTR(&G.mdonly),    "dump only mount data"},
+    {"commands",NO_ARGS,    NULL,   'c',    arg_int,    APTR(&G.cmdonly),   "dump only transactions with mount"},
+    end_option
+};
+
+// "time Xmot Ymot Xenc Yenc VXenc VYenc Xstate Ystate" (degrees)
+static void dumpmd(const tlog_rec_t *r){
+    const mountdata_t *m = &r->md;
+    printf("%-12.6f MD %12.6f %12.6f %12.6f %12.6f %10.6f %10.6f %d %d\n", r->t,
+           RAD2DEG(m->motXposition.val), RAD2DEG(m->motYposition.val),
+           RAD2DEG(m->encXposition.val), RAD2DEG(m->encYposition.val),
+           RAD2DEG(m->encXspeed.val), RAD2DEG(m->encYspeed.val), m->Xstate, m->Ystate);
+}
+
+// print data as string with escaped non-printable symbols
+static void dumpbuf(const uint8_t *buf, size_t len){
+    for(size_t i = 0; i < len; ++i){
+        if(isprint(buf[i]) && buf[i] != '\\') putchar(buf[i]);
+        else printf("\\x%02X", buf[i]);
+    }
+}
+
+// "time IO ret 'output' -> 'input'"
+static void dumpio(const tlog_rec_t *r){
+    const tlog_io_t *io = &r->io;
+    printf("%-12.6f IO %d '", r->t, io->ret);
+    dumpbuf(io->buf, io->outlen);
+    if(io->eol) printf("\\r");
+    printf("' -> '");
+    dumpbuf(io->buf + io->outlen, io->inlen);
+    printf("'%s\n", io->truncated ? " (truncated)" : "");
+}
+
+int main(int argc, char **argv){
+    sl_init();
+    sl_parseargs(&argc, &argv, cmdlnopts);
+    if(G.help) sl_showhelp(-1, cmdlnopts);
+    if(!G.log) ERRX("Point log file name");
+    tlog_map_t m;
+    if(!tlog_map(G.log, &m)) ERRX("Can't open %s or it's not a telemetry log", G.log);
+    printf("# %zd records", m.nrec);
+    if(m.hdr->nrec != m.nrec) printf(" (header: %zd, log wasn't closed?)", (size_t)m.hdr->nrec);
+    printf(", %zd dropped; start at %zd.%09ld", (size_t)m.hdr->dropped, (size_t)m.hdr->start.tv_sec, m.hdr->start.tv_nsec);
+    if(m.nrec) printf(", duration %.6fs", m.rec[m.nrec - 1].t);
+    printf("\n");
+    size_t i = (G.tfrom > 0.) ? tlog_find(&m, G.tfrom) : 0;
+    size_t nmd = 0, nio = 0;
+    for(; i < m.nrec; ++i){
+        const tlog_rec_t *r = &m.rec[i];
+        if(G.tto >= 0. && r->t > G.tto) break;
+        switch(r->type){
+            case TLOG_MOUNTDATA:
+                if(G.cmdonly) break;
+                dumpmd(r); ++nmd;
+                break;
+            case TLOG_MNTIO:
+                if(G.mdonly) break;
+                dumpio(r); ++nio;
+                break;
+            default:
+                WARNX("Unknown record type %u", r->type);
+        }
+    }
+    printf("# dumped %zd mount data and %zd transactions\n", nmd, nio);
+    tlog_unmap(&m);
+    return 0;
+}
@@ -0,0 +1,218 @@
+/*
+ * This file is part of the libsidservo project.
+ * Copyright 2026 Edward V. Emelianov <edward.emelianoff@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// compare tracking by PID (correctTo), PID with feed-forward (correctToFF) and by tracking engine (long commands with
+// adders) over the same traectory
+
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <usefull_macros.h>
+
+#include "conf.h"
+#include "dump.h"
+#include "sidservo.h"
+#include "simpleconv.h"
+#include "traectories.h"
+
+typedef struct{
+    int help;
+    int real;           // run on real mount
+    int virt;           // use virtual clock
+    int Ncycles;        // n cycles to wait stop
+    double tmax;        // duration of each test
+    double settle;      // time from test start excluded from statistics
+    double interval;    // interval between long commands
+    double lookahead;   // adders' time
+    double X0;          // starting point of traectory (-30..30 degr)
+    double Y0;          // -//-
+    char *tfn;          // traectory function name
+    char *conffile;
+} parameters;
+
+static conf_t *Config = NULL;
+static parameters G = {
+    .Ncycles = 40,
+    .tmax = 60.,
+    .settle = 5.,
+    .interval = 0.5,
+    .lookahead = 1.5,
+    .tfn = "sincos",
+    .X0 = 10.,
+    .Y0 = 10.,
+};
+
+static sl_option_t cmdlnopts[] = {
+    {"help",        NO_ARGS,    NULL,   'h',    arg_int,    APTR(&G.help),      "show this help"},
+    {"real",        NO_ARGS,    NULL,   'r',    arg_int,    APTR(&G.real),      "run on real mount (default: model)"},
+    {"virtual",     NO_ARGS,    NULL,   'v',    arg_int,    APTR(&G.virt),      "model by virtual clock (faster than real time)"},
+    {"ncycles",     NEED_ARG,   NULL,   'n',    arg_int,    APTR(&G.Ncycles),   "N cycles in stopped state (default: 40)"},
+    {"tmax",        NEED_ARG,   NULL,   'T',    arg_double, APTR(&G.tmax),      "duration of each test (default: 60 seconds)"},
+    {"settle",      NEED_ARG,   NULL,   's',    arg_double, APTR(&G.settle),    "don't count errors for this time from test start (default: 5 seconds)"},
+    {"interval",    NEED_ARG,   NULL,   'i',    arg_double, APTR(&G.interval),  "interval between long commands (default: 0.5 second)"},
+    {"lookahead",   NEED_ARG,   NULL,   'l',    arg_double, APTR(&G.lookahead), "adders' time of long commands (default: 1.5 second)"},
+    {"traectory",   NEED_ARG,   NULL,   't',    arg_string, APTR(&G.tfn),       "used traectory function (default: sincos)"},
+    {"x0",          NEED_ARG,   NULL,   '0',    arg_double, APTR(&G.X0),        "starting X-coordinate of traectory (default: 10 degrees)"},
+    {"y0",          NEED_ARG,   NULL,   '1',    arg_double, APTR(&G.Y0),        "starting Y-coordinate of traectory (default: 10 degrees)"},
+    {"conffile",    NEED_ARG,   NULL,   'C',    arg_string, APTR(&G.conffile),  "configuration file name"},
+    end_option
+};
+
+// modes of tracking
+typedef enum{
+    MODE_PID,           // correctTo()
+    MODE_PIDFF,         // correctToFF()
+    MODE_TRACK,         // tracking engine
+    MODE_AMOUNT
+} trackmode_t;
+
+// results of one test
+typedef struct{
+    double rms;         // RMS of error, ''
+    double max;         // max error, ''
+    double cmdrate;     // commands per second
+} result_t;
+
+void signals(int sig){
+    if(sig){
+        signal(sig, SIG_IGN);
+        DBG("Get signal %d, quit.\n", sig);
+    }
+    Mount.stop();
+    sleep(1);
+    dumpstats(stderr);
+    Mount.quit();
+    exit(sig);
+}
+
+// traectory for tracking engine
+static int trackfn(double t, coordpair_t *pos, void _U_ *arg){
+    return traectory_point(pos, t);
+}
+
+// go to starting point and start traectory from it
+static void gostart(traectory_fn tfn){
+    coordpair_t c = {.X = DEG2RAD(G.X0), .Y = DEG2RAD(G.Y0)};
+    if(MCC_E_OK != Mount.moveTo(&c)) ERRX("Can't move to starting point");
+    waitmoving(G.Ncycles);
+    if(!init_traectory(tfn, &c)) ERRX("Can't init traectory");
+}
+
+/**
+ * @brief runtest - track traectory for G.tmax seconds and collect errors (target - encoders) for each encoders' sample
+ * @param mode - tracking mode (for PID modes correction runs each PIDRefreshDt, tracking engine works itself)
+ * @param r (o) - results
+ */
+static void runtest(trackmode_t mode, result_t *r){
+    double t0 = Mount.timeFromStart(), tlast = 0., t, sum2 = 0., max = 0.;
+    size_t N = 0;
+    struct timespec tprev = {0};
+    while((t = Mount.timeFromStart()) - t0 < G.tmax){
+        if(mode != MODE_TRACK && t - tlast >= Config->PIDRefreshDt){
+            mcc_errcodes_t e = MCC_E_OK;
+            if(mode == MODE_PIDFF){
+                targval_pair_t target;
+                if(!traectory_targval(&target, t) || !Mount.currentT(&target.X.t)) break;
+                target.Y.t = target.X.t;
+                e = Mount.correctToFF(&target);
+            }else{
+                coordval_pair_t target;
+                coordpair_t pt;
+                if(!traectory_point(&pt, t) || !Mount.currentT(&target.X.t)) break;
+                target.Y.t = target.X.t;
+                target.X.val = pt.X; target.Y.val = pt.Y;
+                e = Mount.correctTo(&target);
+            }
+            if(MCC_E_OK != e) WARNX("Error of correction!");
+            tlast = t;
+        }
+        coordval_pair_t telXY;
+        if(!telpos(&telXY)) break;
+        if(telXY.X.t.tv_sec != tprev.tv_sec || telXY.X.t.tv_nsec != tprev.tv_nsec){
+            tprev = telXY.X.t;
+            coordpair_t pt;
+            if(t - t0 > G.settle && traectory_point(&pt, Mount.timeDiff0(&telXY.X.t))){
+                double dX = RAD2ASEC(pt.X - telXY.X.val), dY = RAD2ASEC(pt.Y - telXY.Y.val);
+                double e2 = dX*dX + dY*dY;
+                sum2 += e2;
+                if(e2 > max) max = e2;
+                ++N;
+            }
+        }
+        Mount.advanceClock(0.0005);
+    }
+    r->rms = N ? sqrt(sum2 / N) : 0.;
+    r->max = sqrt(max);
+    mcc_stats_t s;
+    if(MCC_E_OK == Mount.getStats(&s)) r->cmdrate = ((mode == MODE_TRACK) ? s.trackPeriod.n : s.pidPeriod.n) / G.tmax;
+}
+
+int main(int argc, char **argv){
+    sl_init();
+    sl_parseargs(&argc, &argv, cmdlnopts);
+    if(G.help) sl_showhelp(-1, cmdlnopts);
+    if(G.tmax <= G.settle) ERRX("tmax should be larger than settle");
+    if(G.X0 < -30. || G.X0 > 30. || G.Y0 < -30. || G.Y0 > 30.)
+        ERRX("X0 and Y0 should be -30..30 degrees");
+    Config = readServoConf(G.conffile);
+    if(!Config){
+        dumpConf();
+        return 1;
+    }
+    if(!G.real) Config->RunModel = 1;
+    else if(G.virt) ERRX("Virtual clock works only with model");
+    if(G.virt){
+        mcc_clock_t clk = {.source = MCC_CLOCK_VIRTUAL};
+        if(MCC_E_OK != Mount.setClock(&clk)) ERRX("Can't set virtual clock");
+    }
+    traectory_fn tfn = traectory_by_name(G.tfn);
+    if(!tfn){
+        WARNX("Bad traectory name %s, should be one of", G.tfn);
+        print_tr_names();
+        return 1;
+    }
+    mcc_errcodes_t e = Mount.init(Config);
+    if(e != MCC_E_OK){
+        WARNX("Can't init devices");
+        return 1;
+    }
+    signal(SIGTERM, signals); // kill (-15) - quit
+    signal(SIGHUP, SIG_IGN);  // hup - ignore
+    signal(SIGINT, signals);  // ctrl+C - quit
+    signal(SIGQUIT, signals); // ctrl+\ - quit
+    signal(SIGTSTP, SIG_IGN); // ignore ctrl+Z
+    static const char *modenames[MODE_AMOUNT] = {"PID", "PID+FF", "Track"};
+    result_t res[MODE_AMOUNT] = {0};
+    for(trackmode_t m = 0; m < MODE_AMOUNT; ++m){
+        green("Tracking by %s\n", modenames[m]);
+        gostart(tfn);
+        Mount.resetStats();
+        if(m == MODE_TRACK){
+            mcc_track_t tr = {.traject = trackfn, .interval = G.interval, .lookahead = G.lookahead};
+            if(MCC_E_OK != Mount.track(&tr)) ERRX("Can't start tracking");
+        }
+        runtest(m, &res[m]);
+        Mount.stop();
+    }
+    printf("          RMS('')    max('')   commands/s\n");
+    for(trackmode_t m = 0; m < MODE_AMOUNT; ++m)
+        printf("%-7s %9.3f  %9.3f  %9.2f\n", modenames[m], res[m].rms, res[m].max, res[m].cmdrate);
+    signals(0);
+    return 0;
+}
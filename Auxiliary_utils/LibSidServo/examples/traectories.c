@@ -77,6 +77,25 @@ int traectory_point(coordpair_t *nextpt, double t){
     return TRUE;
 }
 
+/**
+ * @brief traectory_targval - get traectory point with its speed and acceleration (by central differences)
+ * @param tag (o) - target (only values, speeds and accelerations are filled)
+ * @param t - time
+ * @return FALSE if something wrong
+ */
+int traectory_targval(targval_pair_t *tag, double t){
+    const double h = 0.01; // differentiation step, s
+    coordpair_t p, pm, pp;
+    if(!tag || !traectory_point(&p, t) || !traectory_point(&pm, t - h) || !traectory_point(&pp, t + h)) return FALSE;
+    tag->X.val = p.X;
+    tag->Y.val = p.Y;
+    tag->X.speed = (pp.X - pm.X) / (2. * h);
+    tag->Y.speed = (pp.Y - pm.Y) / (2. * h);
+    tag->X.accel = (pp.X - 2. * p.X + pm.X) / (h * h);
+    tag->Y.accel = (pp.Y - 2. * p.Y + pm.Y) / (h * h);
+    return TRUE;
+}
+
 // current telescope position according to starting motor coordinates
 // @return FALSE if failed to get current coordinates
 int telpos(coordval_pair_t *curpos){
@@ -27,6 +27,7 @@ int init_traectory(traectory_fn f, coordpair_t *XY0);
 traectory_fn traectory_by_name(const char *name);
 void print_tr_names();
 int traectory_point(coordpair_t *nextpt, double t);
+int traectory_targval(targval_pair_t *tag, double t);
 int telpos(coordval_pair_t *curpos);
 int Linear(coordpair_t *nextpt, double t);
 int SinCos(coordpair_t *nextpt, double t);
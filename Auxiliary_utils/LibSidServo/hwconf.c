@@ -0,0 +1,422 @@
+/*
+ * This file is part of the libsidservo project.
+ * Copyright 2026 Edward V. Emelianov <edward.emelianoff@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Hardware configuration of controller: reading, writing of changed fields only and binary cache
+ * (Conf.HWConfPath) to skip slow reading on init if controller has the same serial number
+ */
+
+#include <byteswap.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+#include "hwconf.h"
+#include "main.h"
+#include "serial.h"
+#include "ssii.h"
+
+// file of cache
+typedef struct{
+    uint32_t magic;         // HWCACHE_MAGIC
+    uint32_t version;       // HWCACHE_VERSION
+    uint32_t size;          // sizeof(hwcache_t)
+    int64_t serial;         // serial number of controller
+    hwraw_t raw;
+    uint16_t checksum;      // SScalcChecksum() of all above
+} __attribute__((packed)) hwcache_t;
+
+// field of SSconfig having text setter
+typedef struct{
+    const char *cmd;
+    size_t off;             // offset in SSconfig
+    size_t len;             // size, bytes
+    int msb;                // ==1 if stored MSB first
+    int sign;               // ==1 if signed
+} hwfield_t;
+
+#define HWF(cmd, fld, msb, sign)  {cmd, offsetof(SSconfig, fld), sizeof(((SSconfig*)0)->fld), msb, sign}
+// fields changed by text commands (others are written by the whole configuration block)
+static const hwfield_t hwfields[] = {
+    HWF(CMD_MOTXACCEL, Xconf.accel, 0, 0),      HWF(CMD_MOTYACCEL, Yconf.accel, 0, 0),
+    HWF(CMD_POSERRLIMX, Xconf.errlimit, 0, 0),  HWF(CMD_POSERRLIMY, Yconf.errlimit, 0, 0),
+    HWF(CMD_PIDPX, Xconf.propgain, 0, 0),       HWF(CMD_PIDPY, Yconf.propgain, 0, 0),
+    HWF(CMD_PIDIX, Xconf.intgain, 0, 0),        HWF(CMD_PIDIY, Yconf.intgain, 0, 0),
+    HWF(CMD_PIDDX, Xconf.derivgain, 0, 0),      HWF(CMD_PIDDY, Yconf.derivgain, 0, 0),
+    HWF(CMD_PWMOUTX, Xconf.outplimit, 0, 0),    HWF(CMD_PWMOUTY, Yconf.outplimit, 0, 0),
+    HWF(CMD_MOTCURNTX, Xconf.currlimit, 0, 0),  HWF(CMD_MOTCURNTY, Yconf.currlimit, 0, 0),
+    HWF(CMD_PIDILX, Xconf.intlimit, 0, 0),      HWF(CMD_PIDILY, Yconf.intlimit, 0, 0),
+    HWF(CMD_BITSX, xbits, 0, 0),                HWF(CMD_BITSY, ybits, 0, 0),
+    HWF(CMD_LATITUDE, latitude, 1, 0),
+    HWF(CMD_SLEWRATEX, Xslewrate, 0, 1),        HWF(CMD_SLEWRATEY, Yslewrate, 0, 1),
+    HWF(CMD_PANRATEX, Xpanrate, 0, 1),          HWF(CMD_PANRATEY, Ypanrate, 0, 1),
+    HWF(CMD_GUIDERATEX, Xguiderate, 0, 1),      HWF(CMD_GUIDERATEY, Yguiderate, 0, 1),
+};
+#define NHWFIELDS   (sizeof(hwfields) / sizeof(hwfield_t))
+
+// motor's ticks (ticks per loop, ticks per loop^2) to radians (rad/s, rad/s^2) and back by steps per revolution
+#define T2R(t, steps)       (2. * M_PI * (double)(t) / (steps))
+#define R2T(r, steps)       ((r) / (2. * M_PI) * (steps))
+#define T2RS(t, steps)      (T2R(t, steps) / 65536. * (SITECH_LOOP_FREQUENCY))
+#define RS2T(r, steps)      (R2T(r, steps) * 65536. / (SITECH_LOOP_FREQUENCY))
+#define T2RSS(t, steps)     (T2RS(t, steps) * (SITECH_LOOP_FREQUENCY))
+#define RSS2T(r, steps)     (RS2T(r, steps) / (SITECH_LOOP_FREQUENCY))
+
+// value of field `f` in configuration `c`
+static int64_t fieldval(const SSconfig *c, const hwfield_t *f){
+    const uint8_t *p = (const uint8_t*)c + f->off;
+    uint64_t u = 0;
+    for(size_t i = 0; i < f->len; ++i) u = (u << 8) | p[f->msb ? i : f->len - 1 - i];
+    if(f->sign && (u >> (8 * f->len - 1))) return (int64_t)u - ((int64_t)1 << (8 * f->len));
+    return (int64_t)u;
+}
+
+// simplest checksum of configuration block
+static uint16_t confsum(const SSconfig *c){
+    uint16_t sum = 0;
+    for(uint32_t i = 0; i < sizeof(SSconfig) - 2; ++i) sum += ((const uint8_t*)c)[i];
+    return sum;
+}
+
+// set constants of mount by configuration
+static void setconsts(const hwraw_t *r){
+    X_ENC_ZERO = Inst->Conf.XEncZero;
+    Y_ENC_ZERO = Inst->Conf.YEncZero;
+    X_MOT_STEPSPERREV = (double)r->Xmotticks;
+    Y_MOT_STEPSPERREV = (double)r->Ymotticks;
+    X_ENC_STEPSPERREV = r->conf.xbits.encrev ? -(double)r->Xencticks : (double)r->Xencticks;
+    Y_ENC_STEPSPERREV = r->conf.ybits.encrev ? -(double)r->Yencticks : (double)r->Yencticks;
+    SSsetconst(&Inst->ss);
+    DBG("zero: %d/%d; motsteps: %.10g/%.10g; encsteps: %.10g/%.10g", X_ENC_ZERO, Y_ENC_ZERO,
+        X_MOT_STEPSPERREV, Y_MOT_STEPSPERREV, X_ENC_STEPSPERREV, Y_ENC_STEPSPERREV);
+}
+
+// check ticks per revolution got from controller or user
+static int chkticks(const hwraw_t *r){
+    const int64_t t[4] = {r->Xmotticks, r->Ymotticks, r->Xencticks, r->Yencticks};
+    for(int i = 0; i < 4; ++i) if(t[i] < 1 || t[i] > INT32_MAX) return FALSE;
+    return TRUE;
+}
+
+/**
+ * @brief readraw - read configuration from controller
+ * @param r (o) - configuration
+ * @return FALSE if failed
+ */
+static int readraw(hwraw_t *r){
+    DBG("Read HW configuration");
+    if(!cmdC(&r->conf, FALSE)) return FALSE;
+    // motor's and axis encoders' ticks per revolution
+    int64_t i64[4];
+    const char *cmds[4] = {CMD_MEPRX, CMD_MEPRY, CMD_AEPRX, CMD_AEPRY};
+    for(int i = 0; i < 4; ++i) if(!SSgetint(cmds[i], &i64[i])) return FALSE;
+    r->Xmotticks = i64[0]; r->Ymotticks = i64[1];
+    r->Xencticks = i64[2]; r->Yencticks = i64[3];
+    DBG("xyrev: %d/%d, xyencrev: %d/%d", r->conf.xbits.motrev, r->conf.ybits.motrev, r->conf.xbits.encrev, r->conf.ybits.encrev);
+    return chkticks(r);
+}
+
+/**
+ * @brief raw2hw - convert raw configuration into human-readable
+ * @param r - raw configuration
+ * @param hw (o) - converted
+ */
+static void raw2hw(const hwraw_t *r, hardware_configuration_t *hw){
+    const SSconfig *c = &r->conf;
+    double xs = (double)r->Xmotticks, ys = (double)r->Ymotticks;
+    bzero(hw, sizeof(hardware_configuration_t));
+    // Convert acceleration (ticks per loop^2 to rad/s^2)
+    hw->Xconf.accel = T2RSS(c->Xconf.accel, xs);
+    hw->Yconf.accel = T2RSS(c->Yconf.accel, ys);
+    // Convert backlash and error limit (ticks to radians)
+    hw->Xconf.backlash = T2R(c->Xconf.backlash, xs);
+    hw->Yconf.backlash = T2R(c->Yconf.backlash, ys);
+    hw->Xconf.errlimit = T2R(c->Xconf.errlimit, xs);
+    hw->Yconf.errlimit = T2R(c->Yconf.errlimit, ys);
+    // Gains and integral limit are unitless
+    hw->Xconf.propgain = (double)c->Xconf.propgain;
+    hw->Yconf.propgain = (double)c->Yconf.propgain;
+    hw->Xconf.intgain = (double)c->Xconf.intgain;
+    hw->Yconf.intgain = (double)c->Yconf.intgain;
+    hw->Xconf.derivgain = (double)c->Xconf.derivgain;
+    hw->Yconf.derivgain = (double)c->Yconf.derivgain;
+    hw->Xconf.intlimit = (double)c->Xconf.intlimit;
+    hw->Yconf.intlimit = (double)c->Yconf.intlimit;
+    // Output limit is a percentage (0-100)
+    hw->Xconf.outplimit = (double)c->Xconf.outplimit / 255.0 * 100.0;
+    hw->Yconf.outplimit = (double)c->Yconf.outplimit / 255.0 * 100.0;
+    // Current limit in amps
+    hw->Xconf.currlimit = (double)c->Xconf.currlimit / 100.0;
+    hw->Yconf.currlimit = (double)c->Yconf.currlimit / 100.0;
+    // ticks per revolution (negative sign of axis ticks means reversed encoder)
+    hw->Xconf.motor_stepsperrev = xs;
+    hw->Yconf.motor_stepsperrev = ys;
+    hw->Xconf.axis_stepsperrev = c->xbits.encrev ? -(double)r->Xencticks : (double)r->Xencticks;
+    hw->Yconf.axis_stepsperrev = c->ybits.encrev ? -(double)r->Yencticks : (double)r->Yencticks;
+    hw->xbits = c->xbits;
+    hw->ybits = c->ybits;
+    hw->address = c->address;
+    // TODO: What to do with eqrate, eqadj and trackgoal? Now they are given as is
+    hw->eqrate = (double)c->eqrate;
+    hw->eqadj = (double)c->eqadj;
+    hw->trackgoal = (double)c->trackgoal;
+    // Convert latitude (degrees * 100 to radians)
+    hw->latitude = (double)bswap_16(c->latitude) / 100.0 * M_PI / 180.0;
+    hw->Xsetpr = bswap_32(c->Xsetpr);
+    hw->Ysetpr = bswap_32(c->Ysetpr);
+    hw->Xmetpr = bswap_32(c->Xmetpr); // as documentation said, real ticks are 4 times less
+    hw->Ymetpr = bswap_32(c->Ymetpr);
+    // Convert slew, pan and guide rates (ticks per loop to rad/s)
+    hw->Xslewrate = T2RS(c->Xslewrate, xs);
+    hw->Yslewrate = T2RS(c->Yslewrate, ys);
+    hw->Xpanrate = T2RS(c->Xpanrate, xs);
+    hw->Ypanrate = T2RS(c->Ypanrate, ys);
+    hw->Xguiderate = T2RS(c->Xguiderate, xs);
+    hw->Yguiderate = T2RS(c->Yguiderate, ys);
+    hw->baudrate = (uint32_t)c->baudrate;
+    // Convert local search degrees (degrees * 100 to radians) and speed (arcsec per second to rad/s)
+    hw->locsdeg = (double)c->locsdeg / 100.0 * M_PI / 180.0;
+    hw->locsspeed = (double)c->locsspeed * M_PI / (180.0 * 3600.0);
+    // Convert backlash speed (ticks per loop to rad/s)
+    hw->backlspd = T2RS(c->backlspd, xs);
+}
+
+/**
+ * @brief hw2raw - convert human-readable configuration into raw (fields not converted are left unchanged)
+ * @param hw - configuration
+ * @param r (io) - raw configuration
+ */
+static void hw2raw(const hardware_configuration_t *hw, hwraw_t *r){
+    SSconfig *c = &r->conf;
+    r->Xmotticks = llround(hw->Xconf.motor_stepsperrev);
+    r->Ymotticks = llround(hw->Yconf.motor_stepsperrev);
+    r->Xencticks = llround(fabs(hw->Xconf.axis_stepsperrev));
+    r->Yencticks = llround(fabs(hw->Yconf.axis_stepsperrev));
+    double xs = (double)r->Xmotticks, ys = (double)r->Ymotticks;
+    c->Xconf.accel = (uint32_t)lround(RSS2T(hw->Xconf.accel, xs));
+    c->Yconf.accel = (uint32_t)lround(RSS2T(hw->Yconf.accel, ys));
+    c->Xconf.backlash = (uint32_t)lround(R2T(hw->Xconf.backlash, xs));
+    c->Yconf.backlash = (uint32_t)lround(R2T(hw->Yconf.backlash, ys));
+    c->Xconf.errlimit = (uint16_t)lround(R2T(hw->Xconf.errlimit, xs));
+    c->Yconf.errlimit = (uint16_t)lround(R2T(hw->Yconf.errlimit, ys));
+    c->Xconf.propgain = (uint16_t)lround(hw->Xconf.propgain);
+    c->Yconf.propgain = (uint16_t)lround(hw->Yconf.propgain);
+    c->Xconf.intgain = (uint16_t)lround(hw->Xconf.intgain);
+    c->Yconf.intgain = (uint16_t)lround(hw->Yconf.intgain);
+    c->Xconf.derivgain = (uint16_t)lround(hw->Xconf.derivgain);
+    c->Yconf.derivgain = (uint16_t)lround(hw->Yconf.derivgain);
+    c->Xconf.intlimit = (uint16_t)lround(hw->Xconf.intlimit);
+    c->Yconf.intlimit = (uint16_t)lround(hw->Yconf.intlimit);
+    c->Xconf.outplimit = (uint16_t)lround(hw->Xconf.outplimit / 100.0 * 255.0);
+    c->Yconf.outplimit = (uint16_t)lround(hw->Yconf.outplimit / 100.0 * 255.0);
+    c->Xconf.currlimit = (uint16_t)lround(hw->Xconf.currlimit * 100.0);
+    c->Yconf.currlimit = (uint16_t)lround(hw->Yconf.currlimit * 100.0);
+    c->xbits = hw->xbits;
+    c->ybits = hw->ybits;
+    c->address = hw->address;
+    c->latitude = bswap_16((uint16_t)lround(hw->latitude * 180.0 / M_PI * 100.0));
+    c->Xsetpr = bswap_32(hw->Xsetpr);
+    c->Ysetpr = bswap_32(hw->Ysetpr);
+    c->Xmetpr = bswap_32(hw->Xmetpr);
+    c->Ymetpr = bswap_32(hw->Ymetpr);
+    c->Xslewrate = (int32_t)lround(RS2T(hw->Xslewrate, xs));
+    c->Yslewrate = (int32_t)lround(RS2T(hw->Yslewrate, ys));
+    c->Xpanrate = (int32_t)lround(RS2T(hw->Xpanrate, xs));
+    c->Ypanrate = (int32_t)lround(RS2T(hw->Ypanrate, ys));
+    c->Xguiderate = (int32_t)lround(RS2T(hw->Xguiderate, xs));
+    c->Yguiderate = (int32_t)lround(RS2T(hw->Yguiderate, ys));
+    c->baudrate = (uint8_t)hw->baudrate;
+    c->locsdeg = (uint32_t)lround(hw->locsdeg * 180.0 / M_PI * 100.0);
+    c->locsspeed = (uint32_t)lround(hw->locsspeed * 180.0 * 3600.0 / M_PI);
+    c->backlspd = (uint32_t)lround(RS2T(hw->backlspd, xs));
+}
+
+static uint16_t cachesum(const hwcache_t *c){
+    return SScalcChecksum((uint8_t*)c, offsetof(hwcache_t, checksum));
+}
+
+/**
+ * @brief cacheload - load cached configuration of controller
+ * @param path - cache file
+ * @param serial - serial number of controller
+ * @param r (o) - configuration
+ * @return FALSE if there's no valid cache for this controller
+ */
+static int cacheload(const char *path, int64_t serial, hwraw_t *r){
+    FILE *f = fopen(path, "r");
+    if(!f){
+        DBG("Can't open %s", path);
+        return FALSE;
+    }
+    hwcache_t c;
+    int ok = (1 == fread(&c, sizeof(c), 1, f));
+    fclose(f);
+    if(!ok || c.magic != HWCACHE_MAGIC || c.version != HWCACHE_VERSION || c.size != sizeof(hwcache_t)
+        || c.checksum != cachesum(&c)){
+        DBG("Bad cache %s", path);
+        return FALSE;
+    }
+    if(c.serial != serial){
+        DBG("Cache is for controller %" PRIi64 ", not %" PRIi64, c.serial, serial);
+        return FALSE;
+    }
+    *r = c.raw;
+    return chkticks(r);
+}
+
+// save actual configuration into cache (if it's known for what controller)
+static void cachesave(){
+    const char *path = Inst->Conf.HWConfPath;
+    if(!path || Inst->Conf.ReplayPath || Inst->hw.serial == INT64_MAX || !Inst->hw.valid) return;
+    char tmp[4096];
+    if(snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)) return;
+    hwcache_t c = {.magic = HWCACHE_MAGIC, .version = HWCACHE_VERSION, .size = sizeof(hwcache_t),
+                   .serial = Inst->hw.serial, .raw = Inst->hw.raw};
+    c.checksum = cachesum(&c);
+    FILE *f = fopen(tmp, "w");
+    if(!f){
+        DBG("Can't open %s", tmp);
+        return;
+    }
+    int ok = (1 == fwrite(&c, sizeof(c), 1, f));
+    if(fclose(f)) ok = FALSE;
+    if(ok && rename(tmp, path)) ok = FALSE;
+    if(!ok){DBG("Can't save %s", path);}
+}
+
+/**
+ * @brief hwconf_cached - load configuration from Conf.HWConfPath if it was saved for controller with
+ *          the same serial number (one short text transaction instead of full reading)
+ * @return TRUE if loaded (constants of mount are set by it)
+ */
+int hwconf_cached(){
+    hwconf_state_t *H = &Inst->hw;
+    H->serial = INT64_MAX;
+    if(!Inst->Conf.HWConfPath || Inst->Conf.RunModel) return FALSE;
+    int64_t serial;
+    if(!SSgetint(CMD_SERIAL, &serial) || serial == INT64_MAX){
+        DBG("Can't get serial number");
+        return FALSE;
+    }
+    H->serial = serial;
+    hwraw_t r;
+    if(!cacheload(Inst->Conf.HWConfPath, serial, &r)) return FALSE;
+    DBG("Configuration of %" PRIi64 " loaded from cache", serial);
+    H->raw = r;
+    H->valid = 1;
+    setconsts(&r);
+    return TRUE;
+}
+
+// configuration should be read again (on next init)
+void hwconf_forget(){
+    Inst->hw.valid = 0;
+}
+
+/**
+ * @brief get_hwconf - get hardware configuration: read from controller once after init (if it wasn't
+ *          loaded from cache), then given from memory; conversion constants of mount are updated by it
+ * @param hwConfig (o) - configuration
+ * @return error code
+ */
+mcc_errcodes_t get_hwconf(hardware_configuration_t *hwConfig){
+    if(!hwConfig) return MCC_E_BADFORMAT;
+    if(Inst->Conf.RunModel) return MCC_E_FAILED;
+    hwconf_state_t *H = &Inst->hw;
+    if(!H->valid){
+        hwraw_t r;
+        if(!readraw(&r)) return MCC_E_FAILED;
+        H->raw = r;
+        H->valid = 1;
+        setconsts(&r);
+        cachesave();
+    }
+    raw2hw(&H->raw, hwConfig);
+    return MCC_E_OK;
+}
+
+/**
+ * @brief write_hwconf - write changed fields of configuration and save it into flash of controller:
+ *          fields having text setters are sent one by one, if anything else changed whole block is written
+ * @param hwConfig - new configuration (eqrate, eqadj and trackgoal are ignored)
+ * @return error code
+ */
+mcc_errcodes_t write_hwconf(hardware_configuration_t *hwConfig){
+    if(!hwConfig) return MCC_E_BADFORMAT;
+    if(Inst->Conf.RunModel) return MCC_E_FAILED;
+    hardware_configuration_t cur;
+    if(MCC_E_OK != get_hwconf(&cur)) return MCC_E_FAILED;
+    const hwraw_t *old = &Inst->hw.raw;
+    hwraw_t r = *old;
+    hw2raw(hwConfig, &r);
+    if(!chkticks(&r)) return MCC_E_BADFORMAT;
+    // compare fields without text setters
+    SSconfig a = old->conf, b = r.conf;
+    for(size_t i = 0; i < NHWFIELDS; ++i){
+        memset((uint8_t*)&a + hwfields[i].off, 0, hwfields[i].len);
+        memset((uint8_t*)&b + hwfields[i].off, 0, hwfields[i].len);
+    }
+    a.checksum = b.checksum = 0;
+    int block = (0 != memcmp(&a, &b, sizeof(SSconfig))), ntext = 0, ok = TRUE;
+    if(block){ // write all to flash and reload RAM
+        DBG("Write whole configuration");
+        SSconfig c = r.conf;
+        ok = cmdC(&c, TRUE) && SStextcmd(CMD_READFLASH, NULL);
+    }else for(size_t i = 0; i < NHWFIELDS && ok; ++i){
+        const hwfield_t *f = &hwfields[i];
+        int64_t v = fieldval(&r.conf, f);
+        if(v == fieldval(&old->conf, f)) continue;
+        DBG("%s: %" PRIi64 " -> %" PRIi64, f->cmd, fieldval(&old->conf, f), v);
+        ok = SSsetterI(f->cmd, (int32_t)v);
+        ++ntext;
+    }
+    const struct{
+        const char *cmd;
+        int64_t old, new;
+    } ticks[4] = {
+        {CMD_MEPRX, old->Xmotticks, r.Xmotticks}, {CMD_MEPRY, old->Ymotticks, r.Ymotticks},
+        {CMD_AEPRX, old->Xencticks, r.Xencticks}, {CMD_AEPRY, old->Yencticks, r.Yencticks},
+    };
+    for(int i = 0; i < 4 && ok; ++i){
+        if(ticks[i].old == ticks[i].new) continue;
+        DBG("%s: %" PRIi64 " -> %" PRIi64, ticks[i].cmd, ticks[i].old, ticks[i].new);
+        ok = SSsetterI(ticks[i].cmd, (int32_t)ticks[i].new);
+        ++ntext;
+    }
+    // save RAM configuration into flash
+    if(ok && ntext) ok = SStextcmd(CMD_WRITEFLASH, NULL);
+    if(!ok){ // state of controller is unknown
+        DBG("Can't write configuration");
+        hwconf_forget();
+        return MCC_E_FAILED;
+    }
+    if(!block && !ntext){
+        DBG("Nothing changed");
+        return MCC_E_OK;
+    }
+    r.conf.checksum = confsum(&r.conf);
+    double encsteps[2] = {X_ENC_STEPSPERREV, Y_ENC_STEPSPERREV};
+    Inst->hw.raw = r;
+    setconsts(&r);
+    if(encsteps[0] != X_ENC_STEPSPERREV || encsteps[1] != Y_ENC_STEPSPERREV) enc_reconf();
+    cachesave();
+    return MCC_E_OK;
+}
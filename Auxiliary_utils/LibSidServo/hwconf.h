@@ -0,0 +1,46 @@
+/*
+ * This file is part of the libsidservo project.
+ * Copyright 2026 Edward V. Emelianov <edward.emelianoff@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "sidservo.h"
+#include "ssii.h"
+
+// binary cache of hardware configuration: "SSHW" and version of format
+#define HWCACHE_MAGIC       (0x57485353)
+#define HWCACHE_VERSION     (1)
+
+// raw hardware configuration: binary config and ticks per revolution got by text commands
+typedef struct{
+    SSconfig conf;
+    int64_t Xmotticks, Ymotticks;   // CMD_MEPRX/CMD_MEPRY
+    int64_t Xencticks, Yencticks;   // CMD_AEPRX/CMD_AEPRY
+} __attribute__((packed)) hwraw_t;
+
+typedef struct{
+    hwraw_t raw;        // actual configuration of controller
+    int valid;          // ==1 if `raw` was read (or loaded from cache) after init
+    int64_t serial;     // serial number of controller (INT64_MAX if unknown)
+} hwconf_state_t;
+
+int hwconf_cached();
+void hwconf_forget();
+mcc_errcodes_t get_hwconf(hardware_configuration_t *hwConfig);
+mcc_errcodes_t write_hwconf(hardware_configuration_t *hwConfig);
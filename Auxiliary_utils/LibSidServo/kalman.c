@@ -20,150 +20,159 @@
 
 #include "kalman.h"
 
-void kalman3_init(Kalman3 *kf, double dt, double enc_var){
-    kf->dt = dt;
-
-    kf->x[0] = 0;
-    kf->x[1] = 0;
-    kf->x[2] = 0;
-
-    for(int i=0;i<3;i++)
-        for(int j=0;j<3;j++)
-            kf->P[i][j] = 0;
-
-    kf->P[0][0] = 1;
-    kf->P[1][1] = 1;
-    kf->P[2][2] = 1;
-
-    // process noise
-    kf->Q[0][0] = 1e-6;
-    kf->Q[1][1] = 1e-4;
-    kf->Q[2][2] = 1e-3;
-
-    kf->R = enc_var; // encoder noise variance
+// 1/k! for k = 0..KF_MAXSTATES-1
+static const double invfact[KF_MAXSTATES] = {1., 1., 1./2., 1./6.};
+
+/**
+ * @brief calcFQ - transition matrix and process noise for time steps `dt`:
+ *      F[i][j] = dt^(j-i)/(j-i)!, j >= i;
+ *      Q[i][j] = q * dt^(2n-1-i-j) / ((2n-1-i-j) * (n-1-i)! * (n-1-j)!) (discretized white noise of highest derivative)
+ *      for dt = 0 F = I and Q = 0, so such axis isn't changed by prediction
+ * @param kf - filter
+ * @param F (o) - transition matrix
+ * @param Q (o) - process noise
+ * @param dt - time step of each axis
+ */
+static void calcFQ(const kalman_t *kf, double F[KF_MAXSTATES][KF_MAXSTATES][KF_NAXES],
+                   double Q[KF_MAXSTATES][KF_MAXSTATES][KF_NAXES], const double dt[KF_NAXES]){
+    int n = kf->n;
+    double dtp[2*KF_MAXSTATES][KF_NAXES]; // powers of dt
+    for(int a = 0; a < KF_NAXES; ++a){
+        dtp[0][a] = 1.;
+        dtp[1][a] = (dt[a] > 0.) ? dt[a] : 0.;
+    }
+    for(int k = 2; k < 2*n; ++k)
+        for(int a = 0; a < KF_NAXES; ++a) dtp[k][a] = dtp[k-1][a] * dtp[1][a];
+    for(int i = 0; i < n; ++i)
+        for(int j = 0; j < n; ++j){
+            int p = 2*n - 1 - i - j;
+            for(int a = 0; a < KF_NAXES; ++a){
+                F[i][j][a] = (j < i) ? 0. : dtp[j-i][a] * invfact[j-i];
+                Q[i][j][a] = kf->q[a] * dtp[p][a] * kf->Qc[i][j];
+            }
+        }
 }
 
-void kalman3_set_jerk_noise(Kalman3 *kf, double sigma_j){
-    double dt = kf->dt;
-
-    double dt2 = dt*dt;
-    double dt3 = dt2*dt;
-    double dt4 = dt3*dt;
-    double dt5 = dt4*dt;
-
-    double q = sigma_j * sigma_j;
-
-    kf->Q[0][0] = q * dt5 / 20.0;
-    kf->Q[0][1] = q * dt4 / 8.0;
-    kf->Q[0][2] = q * dt3 / 6.0;
-
-    kf->Q[1][0] = q * dt4 / 8.0;
-    kf->Q[1][1] = q * dt3 / 3.0;
-    kf->Q[1][2] = q * dt2 / 2.0;
-
-    kf->Q[2][0] = q * dt3 / 6.0;
-    kf->Q[2][1] = q * dt2 / 2.0;
-    kf->Q[2][2] = q * dt;
+/**
+ * @brief kalman_init - init filter for both axes
+ * @param kf - filter
+ * @param model - amount of states
+ * @param dt - nominal time step
+ * @param R - measurement noise variance of each axis
+ * @param sigma - sigma of highest derivative white noise of each axis
+ * @return 0 if parameters are wrong
+ */
+int kalman_init(kalman_t *kf, kf_model_t model, double dt, const double R[KF_NAXES], const double sigma[KF_NAXES]){
+    if(!kf || !R || !sigma || dt <= 0.) return 0;
+    if(model < KF_MODEL_CV || model > KF_MODEL_CJ) return 0;
+    int n = (int)model;
+    kf->n = n;
+    kf->dt = dt;
+    for(int a = 0; a < KF_NAXES; ++a){
+        kf->R[a] = R[a];
+        kf->q[a] = sigma[a] * sigma[a];
+    }
+    for(int i = 0; i < KF_MAXSTATES; ++i)
+        for(int a = 0; a < KF_NAXES; ++a){
+            kf->x[i][a] = 0.;
+            for(int j = 0; j < KF_MAXSTATES; ++j)
+                kf->P[i][j][a] = (i == j) ? 1. : 0.;
+        }
+    for(int i = 0; i < n; ++i)
+        for(int j = 0; j < n; ++j){
+            int p = 2*n - 1 - i - j;
+            kf->Qc[i][j] = invfact[n-1-i] * invfact[n-1-j] / p;
+        }
+    double dts[KF_NAXES];
+    for(int a = 0; a < KF_NAXES; ++a) dts[a] = dt;
+    calcFQ(kf, kf->F, kf->Q, dts);
+    return 1;
 }
 
-void kalman3_predict(Kalman3 *kf){
-    double dt = kf->dt;
-    double dt2 = 0.5 * dt * dt;
-
-    double theta = kf->x[0];
-    double omega = kf->x[1];
-    double alpha = kf->x[2];
-
-    // state prediction
-    kf->x[0] = theta + omega*dt + alpha*dt2;
-    kf->x[1] = omega + alpha*dt;
-    kf->x[2] = alpha;
-
-    // transition matrix
-    double F[3][3] =
-        {
-            {1, dt, dt2},
-            {0, 1,  dt},
-            {0, 0,  1}
-        };
-
-    // P = FPF^T + Q
-
-    double FP[3][3];
-
-    for(int i=0;i<3;i++)
-        for(int j=0;j<3;j++){
-            FP[i][j] =
-                F[i][0]*kf->P[0][j] +
-                F[i][1]*kf->P[1][j] +
-                F[i][2]*kf->P[2][j];
+// prediction with given F and Q
+static void predict_FQ(kalman_t *kf, double F[KF_MAXSTATES][KF_MAXSTATES][KF_NAXES],
+                       double Q[KF_MAXSTATES][KF_MAXSTATES][KF_NAXES]){
+    int n = kf->n;
+    // state; F is upper triangular
+    double x[KF_MAXSTATES][KF_NAXES];
+    for(int i = 0; i < n; ++i){
+        for(int a = 0; a < KF_NAXES; ++a) x[i][a] = kf->x[i][a];
+        for(int k = i + 1; k < n; ++k)
+            for(int a = 0; a < KF_NAXES; ++a) x[i][a] += F[i][k][a] * kf->x[k][a];
+    }
+    // FP = F*P
+    double FP[KF_MAXSTATES][KF_MAXSTATES][KF_NAXES];
+    for(int i = 0; i < n; ++i)
+        for(int j = 0; j < n; ++j){
+            for(int a = 0; a < KF_NAXES; ++a) FP[i][j][a] = kf->P[i][j][a];
+            for(int k = i + 1; k < n; ++k)
+                for(int a = 0; a < KF_NAXES; ++a) FP[i][j][a] += F[i][k][a] * kf->P[k][j][a];
         }
-
-    double Pnew[3][3];
-
-    for(int i=0;i<3;i++)
-        for(int j=0;j<3;j++){
-            Pnew[i][j] =
-                FP[i][0]*F[j][0] +
-                FP[i][1]*F[j][1] +
-                FP[i][2]*F[j][2] +
-                kf->Q[i][j];
+    // P = FP*F^T + Q; P is symmetric, so calculate only upper triangle
+    for(int i = 0; i < n; ++i){
+        for(int a = 0; a < KF_NAXES; ++a) kf->x[i][a] = x[i][a];
+        for(int j = i; j < n; ++j){
+            double s[KF_NAXES];
+            for(int a = 0; a < KF_NAXES; ++a) s[a] = FP[i][j][a] + Q[i][j][a];
+            for(int k = j + 1; k < n; ++k)
+                for(int a = 0; a < KF_NAXES; ++a) s[a] += FP[i][k][a] * F[j][k][a];
+            for(int a = 0; a < KF_NAXES; ++a) kf->P[i][j][a] = kf->P[j][i][a] = s[a];
         }
-
-    for(int i=0;i<3;i++)
-        for(int j=0;j<3;j++)
-            kf->P[i][j] = Pnew[i][j];
+    }
 }
 
-void kalman3_update(Kalman3 *kf, double z){
-    // innovation
-    double y = z - kf->x[0];
-
-    // S = HPH^T + R
-    double S = kf->P[0][0] + kf->R;
-
-    // Kalman gain
-    double K[3];
-
-    K[0] = kf->P[0][0] / S;
-    K[1] = kf->P[1][0] / S;
-    K[2] = kf->P[2][0] / S;
-
-    // state update
-    kf->x[0] += K[0] * y;
-    kf->x[1] += K[1] * y;
-    kf->x[2] += K[2] * y;
-
-    // covariance update
-    double P00 = kf->P[0][0];
-    double P01 = kf->P[0][1];
-    double P02 = kf->P[0][2];
-
-    double P10 = kf->P[1][0];
-    double P11 = kf->P[1][1];
-    double P12 = kf->P[1][2];
-
-    double P20 = kf->P[2][0];
-    double P21 = kf->P[2][1];
-    double P22 = kf->P[2][2];
-
-    kf->P[0][0] = P00 - K[0]*P00;
-    kf->P[0][1] = P01 - K[0]*P01;
-    kf->P[0][2] = P02 - K[0]*P02;
-
-    kf->P[1][0] = P10 - K[1]*P00;
-    kf->P[1][1] = P11 - K[1]*P01;
-    kf->P[1][2] = P12 - K[1]*P02;
-
-    kf->P[2][0] = P20 - K[2]*P00;
-    kf->P[2][1] = P21 - K[2]*P01;
-    kf->P[2][2] = P22 - K[2]*P02;
+/**
+ * @brief kalman_predict - prediction step for both axes: x = Fx, P = FPF^T + Q
+ * @param kf - filter
+ * @param dt - time from previous prediction for each axis (NULL for nominal);
+ *          axis with dt <= 0 isn't changed; if dt differs from nominal more than
+ *          KF_DT_TOL, F and Q are recalculated for it
+ */
+void kalman_predict(kalman_t *kf, const double dt[KF_NAXES]){
+    double Floc[KF_MAXSTATES][KF_MAXSTATES][KF_NAXES], Qloc[KF_MAXSTATES][KF_MAXSTATES][KF_NAXES];
+    double (*F)[KF_MAXSTATES][KF_NAXES] = kf->F, (*Q)[KF_MAXSTATES][KF_NAXES] = kf->Q;
+    int nominal = 1;
+    if(dt) for(int a = 0; a < KF_NAXES; ++a)
+        if(fabs(dt[a] - kf->dt) > KF_DT_TOL * kf->dt) nominal = 0;
+    if(!nominal){ // some axes need own matrices
+        F = Floc; Q = Qloc;
+        calcFQ(kf, F, Q, dt);
+    }
+    predict_FQ(kf, F, Q);
 }
 
+/**
+ * @brief kalman_update - update step by measured positions
+ * @param kf - filter
+ * @param z - measured positions of each axis
+ * @param mask - bit mask of axes having new measurement (bit 0 - axis 0 etc)
+ */
+void kalman_update(kalman_t *kf, const double z[KF_NAXES], unsigned mask){
+    int n = kf->n;
+    double y[KF_NAXES], Sinv[KF_NAXES];
+    for(int a = 0; a < KF_NAXES; ++a){ // axes without measurement have zero gain
+        if(mask & (1u << a)){
+            y[a] = z[a] - kf->x[0][a];
+            Sinv[a] = 1. / (kf->P[0][0][a] + kf->R[a]);
+        }else y[a] = Sinv[a] = 0.;
+    }
+    // K = P*H^T/S, H = [1 0 ...]
+    double K[KF_MAXSTATES][KF_NAXES], P0[KF_MAXSTATES][KF_NAXES];
+    for(int i = 0; i < n; ++i)
+        for(int a = 0; a < KF_NAXES; ++a){
+            K[i][a] = kf->P[i][0][a] * Sinv[a];
+            P0[i][a] = kf->P[0][i][a];
+        }
+    // x += Ky, P -= K*H*P
+    for(int i = 0; i < n; ++i){
+        for(int a = 0; a < KF_NAXES; ++a) kf->x[i][a] += K[i][a] * y[a];
+        for(int j = 0; j < n; ++j)
+            for(int a = 0; a < KF_NAXES; ++a) kf->P[i][j][a] -= K[i][a] * P0[j][a];
+    }
+}
 
 // estimation of the R
 double encoder_noise(int counts){
     double d = 2.0*M_PI / counts;
     return d*d / 12.0;
 }
-
@@ -18,17 +18,39 @@
 
 #pragma once
 
-typedef struct{
-    double x[3];        // [theta, omega, alpha]
-    double P[3][3];     // covariance
-    double Q[3][3];     // process noise
-    double R;           // measurement noise
-    double dt;
-} Kalman3;
+/*
+ * Kalman filter for both axes at once. Measured value is position only; state is
+ * position and its derivatives (2, 3 or 4 states); process noise is white noise of highest derivative.
+ * Data stored in "structure of arrays" form: last index of each array is axis number, so
+ * all loops over axes are short and vectorizable.
+ */
 
+#define KF_NAXES        (2)
+#define KF_MAXSTATES    (4)
+// relative difference of `dt` from nominal, when precomputed matrices are used
+#define KF_DT_TOL       (1e-3)
+
+typedef enum{
+    KF_MODEL_CV = 2,    // [theta, omega], white acceleration noise
+    KF_MODEL_CA = 3,    // [theta, omega, alpha], white jerk noise
+    KF_MODEL_CJ = 4,    // [theta, omega, alpha, jerk], white snap noise
+} kf_model_t;
+
+typedef struct{
+    int n;                                              // amount of states
+    double dt;                                          // nominal time step
+    double q[KF_NAXES];                                 // spectral density of process noise
+    double R[KF_NAXES];                                 // measurement noise variance
+    double x[KF_MAXSTATES][KF_NAXES];                   // state
+    double P[KF_MAXSTATES][KF_MAXSTATES][KF_NAXES];     // covariance
+    double F[KF_MAXSTATES][KF_MAXSTATES][KF_NAXES];     // transition matrix for nominal dt
+    double Q[KF_MAXSTATES][KF_MAXSTATES][KF_NAXES];     // process noise for nominal dt
+    double Qc[KF_MAXSTATES][KF_MAXSTATES];              // Q[i][j] = q*dt^(2n-1-i-j)*Qc[i][j]
+} kalman_t;
 
 double encoder_noise(int counts);
-void kalman3_update(Kalman3 *kf, double z);
-void kalman3_predict(Kalman3 *kf);
-void kalman3_set_jerk_noise(Kalman3 *kf, double sigma_j);
-void kalman3_init(Kalman3 *kf, double dt, double enc_var);
+int kalman_init(kalman_t *kf, kf_model_t model, double dt, const double R[KF_NAXES], const double sigma[KF_NAXES]);
+void kalman_predict(kalman_t *kf, const double dt[KF_NAXES]);
+void kalman_update(kalman_t *kf, const double z[KF_NAXES], unsigned mask);
+// get i-th derivative (0 - position) of axis `a` or 0 if model have no such state
+#define kalman_val(kf, i, a)  (((i) < (kf)->n) ? (kf)->x[i][a] : 0.)
@@ -20,41 +20,51 @@
  * main functions to fill struct `mount_t`
  */
 
+#include <errno.h>
 #include <inttypes.h>
+#include <sched.h>
 #include <strings.h>
 #include <time.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 
+#include "enchist.h"
+#include "hwconf.h"
 #include "main.h"
 #include "movingmodel.h"
+#include "pec.h"
 #include "serial.h"
 #include "ssii.h"
+#include "telelog.h"
 #include "PID.h"
+#include "pidtune.h"
+#include "replay.h"
+#include "slew.h"
+#include "tracking.h"
+#include "vclock.h"
 
-// adder for monotonic time by realtime: inited any call of init()
-static struct timespec timeadder = {0}, // adder of CLOCK_REALTIME to CLOCK_MONOTONIC
-    t0 = {0},           // curtime() for initstarttime() call
-    starttime = {0};    // starting time by monotonic (for timefromstart())
-
-conf_t Conf = {0};
-// parameters for model
-static movemodel_t *Xmodel, *Ymodel;
-// limits for model and/or real mount (in latter case data should be read from mount on init)
-// radians, rad/sec, rad/sec^2
+static int wasinited = 0; // init() was called (clock source can't be changed)
+// interval of mount data polling while waiting for fresh data on init, s
+#define INIT_POLL_INTERVAL  (0.01)
+// limits for model and/or real mount by default (in latter case data should be read from mount on init)
 // max speeds (rad/s): xs=10 deg/s, ys=8 deg/s
 // accelerations: xa=12.6 deg/s^2, ya= 9.5 deg/s^2
-limits_t
-    Xlimits = {
+static const limits_t
+    Xdeflimits = {
         .min = {.coord = -3.1241, .speed = 1e-10, .accel = 1e-6},
         .max = {.coord = 3.1241, .speed = 0.174533, .accel = 0.219911}},
-    Ylimits = {
+    Ydeflimits = {
         .min = {.coord = -3.1241, .speed = 1e-10, .accel = 1e-6},
         .max = {.coord = 3.1241, .speed = 0.139626, .accel = 0.165806}}
 ;
+// instances of mounts: 0 - `Mount`, others are given by mount_open()
+static mntinst_t Inst0;
+static mntinst_t *Instances[MCC_MAXMOUNTS] = {&Inst0};
+static pthread_mutex_t instmutex = PTHREAD_MUTEX_INITIALIZER; // for mount_open()/mount_close()
+__thread mntinst_t *Inst = &Inst0;
 static mcc_errcodes_t shortcmd(short_command_t *cmd);
-static mcc_errcodes_t get_hwconf(hardware_configuration_t *hwConfig);
+static void init_join();
 
 /**
  * @brief curtime - monotonic time from first run
@@ -64,9 +74,9 @@ static mcc_errcodes_t get_hwconf(hardware_configuration_t *hwConfig);
  */
 int curtime(struct timespec *t){
     struct timespec now;
-    if(clock_gettime(CLOCK_MONOTONIC, &now)) return FALSE;
-    now.tv_sec += timeadder.tv_sec;
-    now.tv_nsec += timeadder.tv_nsec;
+    vclock_now(&now);
+    now.tv_sec += Inst->timeadder.tv_sec;
+    now.tv_nsec += Inst->timeadder.tv_nsec;
     if(now.tv_nsec > 999999999L){
         ++now.tv_sec;
         now.tv_nsec -= 1000000000L;
@@ -75,18 +85,18 @@ int curtime(struct timespec *t){
     return TRUE;
 }
 
-// init starttime; @return TRUE if all OK
+// init Inst->starttime; @return TRUE if all OK
 static int initstarttime(){
     struct timespec start;
-    if(clock_gettime(CLOCK_MONOTONIC, &starttime)) return FALSE;
-    if(clock_gettime(CLOCK_REALTIME, &start)) return FALSE;
-    timeadder.tv_sec = start.tv_sec - starttime.tv_sec;
-    timeadder.tv_nsec = start.tv_nsec - starttime.tv_nsec;
-    if(timeadder.tv_nsec < 0){
-        --timeadder.tv_sec;
-        timeadder.tv_nsec += 1000000000L;
+    vclock_now(&Inst->starttime);
+    vclock_realtime(&start);
+    Inst->timeadder.tv_sec = start.tv_sec - Inst->starttime.tv_sec;
+    Inst->timeadder.tv_nsec = start.tv_nsec - Inst->starttime.tv_nsec;
+    if(Inst->timeadder.tv_nsec < 0){
+        --Inst->timeadder.tv_sec;
+        Inst->timeadder.tv_nsec += 1000000000L;
     }
-    curtime(&t0);
+    curtime(&Inst->t0);
     return TRUE;
 }
 
@@ -95,38 +105,123 @@ double timediff(const struct timespec *time1, const struct timespec *time0){
     if(!time1 || !time0) return -1.;
     return (time1->tv_sec - time0->tv_sec) + (time1->tv_nsec - time0->tv_nsec) / 1e9;
 }
+// time of last initstarttime() call (curtime())
+void inittime(struct timespec *t){
+    if(t) *t = Inst->t0;
+}
 // difference between given time and  last initstarttime() call
 double timediff0(const struct timespec *time1){
-    return timediff(time1, &t0);
+    return timediff(time1, &Inst->t0);
 }
 // time from last initstarttime() call
 double timefromstart(){
     struct timespec now;
-    if(clock_gettime(CLOCK_MONOTONIC, &now)) return -1.;
-    return (now.tv_sec - starttime.tv_sec) + (now.tv_nsec - starttime.tv_nsec) / 1e9;
+    vclock_now(&now);
+    return (now.tv_sec - Inst->starttime.tv_sec) + (now.tv_nsec - Inst->starttime.tv_nsec) / 1e9;
+}
+
+// shift time `t` by `dt` seconds
+void tsshift(struct timespec *t, double dt){
+    long ns = t->tv_nsec + (long)(dt * 1e9);
+    t->tv_sec += ns / 1000000000L;
+    ns %= 1000000000L;
+    if(ns < 0){
+        --t->tv_sec;
+        ns += 1000000000L;
+    }
+    t->tv_nsec = ns;
+}
+
+/**
+ * @brief period_wait - sleep till the end of current period of periodic loop (drift-free: next deadline is
+ *          counted from previous, not from wakeup time)
+ * @param deadline (io) - end of previous period by monotonic clock (init it by vclock_now() before loop)
+ * @param period - loop period, s
+ * @param jitter - histogram of wakeup lateness (or NULL)
+ * @return FALSE if loop is late more than for a period (then deadline is set to current time)
+ */
+int period_wait(struct timespec *deadline, double period, hist_t *jitter){
+    struct timespec now;
+    tsshift(deadline, period);
+    vclock_now(&now);
+    double late = timediff(&now, deadline);
+    if(late > period){ // don't try to catch up missed periods
+        if(jitter) hist_add(jitter, late);
+        *deadline = now;
+        return FALSE;
+    }
+    vclock_sleepuntil(deadline);
+    if(jitter){
+        vclock_now(&now);
+        hist_add(jitter, timediff(&now, deadline));
+    }
+    return TRUE;
+}
+
+// sleep for `t` seconds (by absolute time, so signals don't make pause longer)
+void sleep_s(double t){
+    struct timespec deadline;
+    vclock_now(&deadline);
+    tsshift(&deadline, t);
+    vclock_sleepuntil(&deadline);
 }
 
 /**
  * @brief quit - close all opened and return to default state
- * TODO: close serial devices even in "model" mode
  */
 static void quit(){
-    if(Conf.RunModel) return;
-    for(int i = 0; i < 10; ++i) if(SSstop(TRUE)) break;
-    DBG("Close all serial devices");
+    atomic_store(&Inst->ini.abort, 1);
+    init_join();
+    track_stop();
+    if(!Inst->Conf.RunModel){
+        for(int i = 0; i < 10; ++i) if(SSstop(TRUE)) break;
+    }
+    DBG("Close all serial devices and stop threads");
     closeSerial();
+    tlog_close();
+    pec_close();
+    // PIDs will be created by new configuration
+    pid_delete(&Inst->pid.X);
+    pid_delete(&Inst->pid.Y);
+    Inst->pid.tprev = -1.;
+    hwconf_forget();
+    pthread_mutex_lock(&Inst->ini.mutex);
+    Inst->ini.st = (mcc_initstate_t){.stage = MCC_INIT_IDLE};
+    pthread_mutex_unlock(&Inst->ini.mutex);
     DBG("Exit");
 }
 
+/**
+ * @brief modadd - move model's target by adder (should be called after proc_move() for time `t`)
+ * @param m - model
+ * @param a - adder
+ * @param t - current time
+ */
+static void modadd(movemodel_t *m, modadder_t *a, double t){
+    if(!a->active) return;
+    double ta = t;
+    if(ta >= a->tend){ // last moving of target
+        ta = a->tend;
+        a->active = 0;
+    }
+    moveparam_t p = a->target;
+    p.coord += a->adder * (ta - a->t0);
+    model_move2(m, &p, t);
+}
+
 void getModData(coordpair_t *c, movestate_t *xst, movestate_t *yst){
-    if(!c || !Xmodel || !Ymodel) return;
+    if(!c || !Inst->Xmodel || !Inst->Ymodel) return;
     double tnow = timefromstart();
     moveparam_t Xp, Yp;
-    movestate_t Xst = Xmodel->get_state(Xmodel, &Xp);
+    movestate_t Xst = Inst->Xmodel->get_state(Inst->Xmodel, &Xp);
     //DBG("Xstate = %d", Xst);
-    if(Xst == ST_MOVE) Xst = Xmodel->proc_move(Xmodel, &Xp, tnow);
-    movestate_t Yst = Ymodel->get_state(Ymodel, &Yp);
-    if(Yst == ST_MOVE) Yst = Ymodel->proc_move(Ymodel, &Yp, tnow);
+    if(Xst == ST_MOVE) Xst = Inst->Xmodel->proc_move(Inst->Xmodel, &Xp, tnow);
+    movestate_t Yst = Inst->Ymodel->get_state(Inst->Ymodel, &Yp);
+    if(Yst == ST_MOVE) Yst = Inst->Ymodel->proc_move(Inst->Ymodel, &Yp, tnow);
+    pthread_mutex_lock(&Inst->madmutex);
+    modadd(Inst->Xmodel, &Inst->Xmadder, tnow);
+    modadd(Inst->Ymodel, &Inst->Ymadder, tnow);
+    pthread_mutex_unlock(&Inst->madmutex);
     c->X = Xp.coord;
     c->Y = Yp.coord;
     if(xst) *xst = Xst;
@@ -144,138 +239,394 @@ less_square_t *LS_init(size_t Ndata){
     DBG("Init less squares: %zd", Ndata);
     less_square_t *l = calloc(1, sizeof(less_square_t));
     l->x = calloc(Ndata, sizeof(double));
-    l->t2 = calloc(Ndata, sizeof(double));
     l->t = calloc(Ndata, sizeof(double));
-    l->xt = calloc(Ndata, sizeof(double));
     l->arraysz = Ndata;
     return l;
 }
 void LS_delete(less_square_t **l){
     if(!l || !*l) return;
-    free((*l)->x); free((*l)->t2); free((*l)->t); free((*l)->xt);
+    free((*l)->x); free((*l)->t);
     free(*l);
     *l = NULL;
 }
+
+/**
+ * @brief LS_recalc - recalculate all sums from scratch relative to new reference point (means of x and t)
+ * Called each `arraysz` added points, so accumulated rounding errors can't grow
+ * (four partial sums let compiler use SIMD and don't depend on -ffast-math)
+ * @param l - less squares
+ */
+void LS_recalc(less_square_t *l){
+    if(!l || !l->ndata) return;
+    size_t n = l->ndata, i = 0;
+    const double *x = l->x, *t = l->t;
+    // first pass: means
+    double xs[4] = {0.}, ts[4] = {0.};
+    for(; i + 4 <= n; i += 4){
+        for(int j = 0; j < 4; ++j){
+            xs[j] += x[i+j];
+            ts[j] += t[i+j];
+        }
+    }
+    for(; i < n; ++i){ xs[0] += x[i]; ts[0] += t[i]; }
+    double x0 = (xs[0] + xs[1] + xs[2] + xs[3]) / (double)n;
+    double t0 = (ts[0] + ts[1] + ts[2] + ts[3]) / (double)n;
+    // second pass: centered sums
+    double xsum[4] = {0.}, tsum[4] = {0.}, t2sum[4] = {0.}, xtsum[4] = {0.};
+    for(i = 0; i + 4 <= n; i += 4){
+        for(int j = 0; j < 4; ++j){
+            double dx = x[i+j] - x0, dt = t[i+j] - t0;
+            xsum[j] += dx;
+            tsum[j] += dt;
+            t2sum[j] += dt * dt;
+            xtsum[j] += dx * dt;
+        }
+    }
+    for(; i < n; ++i){
+        double dx = x[i] - x0, dt = t[i] - t0;
+        xsum[0] += dx; tsum[0] += dt; t2sum[0] += dt * dt; xtsum[0] += dx * dt;
+    }
+    l->x0 = x0; l->t0 = t0;
+    l->xsum = xsum[0] + xsum[1] + xsum[2] + xsum[3];
+    l->tsum = tsum[0] + tsum[1] + tsum[2] + tsum[3];
+    l->t2sum = t2sum[0] + t2sum[1] + t2sum[2] + t2sum[3];
+    l->xtsum = xtsum[0] + xtsum[1] + xtsum[2] + xtsum[3];
+    l->nadded = 0;
+}
+
 // add next data portion and calculate current slope
 double LS_calc_slope(less_square_t *l, double x, double t){
     if(!l) return 0.;
     size_t idx = l->idx;
-    double oldx = l->x[idx], oldt = l->t[idx], oldt2 = l->t2[idx], oldxt = l->xt[idx];
-    /*DBG("old: x=%g, t=%g, t2=%g, xt=%g; sum: %g, t=%g, t2=%g, xt=%g", oldx, oldt, oldt2, oldxt,
-        l->xsum, l->tsum, l->t2sum, l->xtsum);*/
-    double t2 = t * t, xt = x * t;
-    l->x[idx] = x; l->t2[idx] = t2;
-    l->t[idx] = t; l->xt[idx] = xt;
+    if(l->ndata == 0){ // first point - reference
+        l->x0 = x; l->t0 = t;
+    }
+    if(l->ndata == l->arraysz){ // remove oldest point
+        double oldx = l->x[idx] - l->x0, oldt = l->t[idx] - l->t0;
+        l->xsum -= oldx;
+        l->tsum -= oldt;
+        l->t2sum -= oldt * oldt;
+        l->xtsum -= oldx * oldt;
+    }else ++l->ndata;
+    l->x[idx] = x; l->t[idx] = t;
     ++idx;
     l->idx = (idx >= l->arraysz) ? 0 : idx;
-    l->xsum += x - oldx;
-    l->t2sum += t2 - oldt2;
-    l->tsum += t - oldt;
-    l->xtsum += xt - oldxt;
-    double n = (double)l->arraysz;
+    if(++l->nadded >= l->arraysz) LS_recalc(l);
+    else{
+        double dx = x - l->x0, dt = t - l->t0;
+        l->xsum += dx;
+        l->tsum += dt;
+        l->t2sum += dt * dt;
+        l->xtsum += dx * dt;
+    }
+    if(l->ndata < 3) return 0.;
+    double n = (double)l->ndata;
     double denominator = n * l->t2sum - l->tsum * l->tsum;
-    if(fabs(denominator) < 1e-7) return 0.;
+    // all times are the same (relative check as sums are relative)
+    if(denominator <= 16. * DBL_EPSILON * n * l->t2sum) return 0.;
     double numerator = n * l->xtsum - l->xsum * l->tsum;
     //DBG("x=%g, t=%g; idx=%zd, arrsz=%zd, den=%g; xsum=%g, num=%g", x, t, l->idx, l->arraysz, denominator, l->xsum, numerator);
-    // point: (sum_x  - slope * sum_t) / n;
+    // point: x0 + (sum_x  - slope * sum_t) / n;
     return (numerator / denominator);
 }
 
 /**
- * @brief init - open serial devices and do other job
- * @param c - initial configuration
+ * @brief setclock - set clock source (threads of model mode can't change clock, so only before first init)
+ * @param c - clock parameters
  * @return error code
  */
-static mcc_errcodes_t init(conf_t *c){
-    FNAME();
-    if(!c) return MCC_E_BADFORMAT;
-    if(!initstarttime()) return MCC_E_FAILED;
-    Conf = *c;
-    mcc_errcodes_t ret = MCC_E_OK;
-    Xmodel = model_init(&Xlimits);
-    Ymodel = model_init(&Ylimits);
-    if(Conf.MountReqInterval > 1. || Conf.MountReqInterval < 0.05){
-        DBG("Bad value of MountReqInterval");
-        ret = MCC_E_BADFORMAT;
-    }
-    if(Conf.RunModel){
-        if(!Xmodel || !Ymodel || !openMount()) return MCC_E_FAILED;
-        return MCC_E_OK;
-    }
-    DBG("Try to open mount device");
-    if(!Conf.MountDevPath || Conf.MountDevSpeed < MOUNT_BAUDRATE_MIN){
-        DBG("Define mount device path and speed");
-        ret = MCC_E_BADFORMAT;
-    }else if(!openMount()){
-        DBG("Can't open %s with speed %d", Conf.MountDevPath, Conf.MountDevSpeed);
-        ret = MCC_E_MOUNTDEV;
+static mcc_errcodes_t setclock(const mcc_clock_t *c){
+    if(wasinited) return MCC_E_FAILED;
+    return vclock_set(c);
+}
+
+/**
+ * @brief init_setstate - add steps done and change stage of initialization
+ * @param done - bits of steps done
+ * @param stage - new stage
+ * @param err - error code
+ */
+static void init_setstate(unsigned done, mcc_initstage_t stage, mcc_errcodes_t err){
+    init_state_t *I = &Inst->ini;
+    pthread_mutex_lock(&I->mutex);
+    I->st.done |= done;
+    I->st.stage = stage;
+    I->st.err = err;
+    if(stage != MCC_INIT_BUSY) I->st.elapsed = timefromstart();
+    pthread_mutex_unlock(&I->mutex);
+}
+
+/**
+ * @brief init_getstate - get state of initialization
+ * @param st (o) - state
+ * @return error code
+ */
+static mcc_errcodes_t init_getstate(mcc_initstate_t *st){
+    if(!st) return MCC_E_BADFORMAT;
+    pthread_mutex_lock(&Inst->ini.mutex);
+    *st = Inst->ini.st;
+    pthread_mutex_unlock(&Inst->ini.mutex);
+    if(st->stage == MCC_INIT_BUSY) st->elapsed = timefromstart();
+    return MCC_E_OK;
+}
+
+/**
+ * @brief init_finish - set final stage of initialization and call user's callback
+ * @param err - result
+ * @return `err`
+ */
+static mcc_errcodes_t init_finish(mcc_errcodes_t err){
+    init_setstate(0, (err == MCC_E_OK) ? MCC_INIT_READY : MCC_INIT_FAILED, err);
+    DBG("Init finished with code %d", err);
+    if(Inst->ini.cb){
+        mcc_initstate_t st;
+        init_getstate(&st);
+        Inst->ini.cb(&st, Inst->ini.cbarg);
     }
-    // TODO: read hardware configuration on init
-    if(Conf.EncoderSpeedInterval < Conf.EncoderReqInterval * MCC_CONF_MIN_SPEEDC || Conf.EncoderSpeedInterval > MCC_CONF_MAX_SPEEDINT){
-        DBG("Wrong speed interval");
-        ret = MCC_E_BADFORMAT;
+    return err;
+}
+
+/**
+ * @brief init_join - wait for the end of bring-up thread (if it is current thread - just detach it)
+ */
+static void init_join(){
+    if(!Inst->ini.started) return;
+    if(pthread_equal(pthread_self(), Inst->ini.thread)) pthread_detach(Inst->ini.thread);
+    else pthread_join(Inst->ini.thread, NULL);
+    Inst->ini.started = 0;
+}
+
+/**
+ * @brief waitfresh - wait for data measured after given moment
+ * @param t0 - this moment
+ * @param tmax - max time of waiting, s
+ * @param enc - TRUE to wait for both encoders, FALSE - for both motors
+ * @return FALSE if timed out
+ */
+static int waitfresh(const struct timespec *t0, double tmax, int enc){
+    double tend = timefromstart() + tmax;
+    do{
+        mountdata_t md;
+        if(MCC_E_OK == getMD(&md)){
+            const struct timespec *tx = enc ? &md.encXposition.t : &md.motXposition.t;
+            const struct timespec *ty = enc ? &md.encYposition.t : &md.motYposition.t;
+            if(timediff(tx, t0) > 0. && timediff(ty, t0) > 0.) return TRUE;
+        }
+        sleep_s(INIT_POLL_INTERVAL);
+    }while(timefromstart() < tend && !atomic_load(&Inst->ini.abort));
+    return FALSE;
+}
+
+// open encoders while bring-up thread reads hardware configuration
+static void *encopenthread(void *inst){
+    Inst = (mntinst_t*)inst;
+    for(int i = 0; i < MAX_ERR_CTR && !atomic_load(&Inst->ini.abort); ++i){
+        if(openEncoder()){
+            init_setstate(MCC_INIT_ENCODERS, MCC_INIT_BUSY, MCC_E_OK);
+            break;
+        }
     }
-    if(ret != MCC_E_OK) return ret;
+    return NULL;
+}
+
+/**
+ * @brief bringupthread - bring-up of real mount (or replay): controller's setup and hardware configuration reading
+ *          run concurrently with encoders' opening, then motors are synced with encoders by first fresh data
+ */
+static void *bringupthread(void *inst){
+    Inst = (mntinst_t*)inst;
+    DBG("Bring-up started");
+    pthread_t encth;
+    int encstarted = 0;
+    if(!Inst->Conf.SepEncoder) init_setstate(MCC_INIT_ENCODERS, MCC_INIT_BUSY, MCC_E_OK); // encoders are in mount
+    else if(0 == pthread_create(&encth, NULL, encopenthread, Inst)) encstarted = 1;
     DBG("Exit ACM, exit manual mode");
     SSrawcmd(CMD_EXITACM, NULL);
     SStextcmd(CMD_AUTOX, NULL);
     SStextcmd(CMD_AUTOY, NULL);
     // read HW config to update constants
     hardware_configuration_t HW;
-    DBG("Read hardware configuration");
-    ret = MCC_E_FAILED;
-    for(int i = 0; i < MAX_ERR_CTR; ++i){
+    mcc_errcodes_t ret = MCC_E_FAILED;
+    if(hwconf_cached()){
+        init_setstate(MCC_INIT_HWCACHE, MCC_INIT_BUSY, MCC_E_OK);
+        ret = MCC_E_OK;
+    }else{DBG("Read hardware configuration");}
+    for(int i = 0; i < MAX_ERR_CTR && ret != MCC_E_OK && !atomic_load(&Inst->ini.abort); ++i){
         DBG("TRY %d..", i);
         ret = get_hwconf(&HW);
-        if(ret == MCC_E_OK) break;
     }
-    if(MCC_E_OK != ret) return ret;
-    // make a pause for actual encoder's values
-    DBG("Check encoders");
-    if(Conf.SepEncoder){
-        if(!Conf.EncoderDevPath && !Conf.EncoderXDevPath){
-            DBG("Define encoder device path");
-            ret = MCC_E_BADFORMAT;
-        }else{
-            ret = MCC_E_ENCODERDEV;
-            for(int i = 0; i < MAX_ERR_CTR; ++i){
-                if(openEncoder()){
-                    ret = MCC_E_OK;
-                    break;
-                }
-            }
-        }
+    // log recorded in model mode has no transactions with mount: use default constants
+    if(MCC_E_OK != ret && Inst->Conf.ReplayPath){
+        DBG("No hardware configuration in log");
+        ret = MCC_E_OK;
     }
-    if(MCC_E_OK != ret) return ret;
-    double t0 = timefromstart();
+    if(MCC_E_OK == ret) init_setstate(MCC_INIT_HWCONF, MCC_INIT_BUSY, MCC_E_OK);
+    if(encstarted) pthread_join(encth, NULL);
+    if(MCC_E_OK == ret && !(Inst->ini.st.done & MCC_INIT_ENCODERS)) ret = MCC_E_ENCODERDEV;
+    if(atomic_load(&Inst->ini.abort)) ret = MCC_E_FAILED;
+    if(MCC_E_OK != ret) goto ret;
+    // encoders could give some data by default constants
+    enc_reconf();
     DBG("Wait for first encoders' measurement");
-    while(timefromstart() - t0 < Conf.EncoderReqInterval * 15.) usleep(1000);
+    struct timespec t0;
+    curtime(&t0);
+    if(waitfresh(&t0, Inst->Conf.EncoderReqInterval * 15., TRUE)) init_setstate(MCC_INIT_ENCDATA, MCC_INIT_BUSY, MCC_E_OK);
+    if(atomic_load(&Inst->ini.abort)){
+        ret = MCC_E_FAILED;
+        goto ret;
+    }
     DBG("Update motor position");
-    mcc_errcodes_t e = updateMotorPos();
+    ret = updateMotorPos();
+    if(MCC_E_OK == ret) init_setstate(MCC_INIT_SYNC, MCC_INIT_BUSY, MCC_E_OK);
     // and refresh data after updating
     DBG("Wait for next mount reading");
-    t0 = timefromstart();
-    while(timefromstart() - t0 < Conf.MountReqInterval * 5.) usleep(1000);
+    curtime(&t0);
+    waitfresh(&t0, Inst->Conf.MountReqInterval * 5., FALSE);
     DBG("ALL READY!");
-    return e;
+ret:
+    init_finish(ret);
+    return NULL;
+}
+
+/**
+ * @brief init_start - check configuration and open mount device (model is ready after this)
+ * @param c - initial configuration
+ * @return error code
+ */
+static mcc_errcodes_t init_start(conf_t *c){
+    if(!initstarttime()) return MCC_E_FAILED;
+    resetstats();
+    Inst->Conf = *c;
+    mcc_errcodes_t ret = MCC_E_OK;
+    if(!Inst->Xmodel && model_init(&Inst->Xmod, RAMP_TRAPEZIUM, &Inst->Xlimits)) Inst->Xmodel = &Inst->Xmod;
+    if(!Inst->Ymodel && model_init(&Inst->Ymod, RAMP_TRAPEZIUM, &Inst->Ylimits)) Inst->Ymodel = &Inst->Ymod;
+    if(Inst->Conf.MountReqInterval > 1. || Inst->Conf.MountReqInterval < 0.05){
+        DBG("Bad value of MountReqInterval");
+        ret = MCC_E_BADFORMAT;
+    }
+    if(Inst->Conf.SpeedSource < SPEED_SRC_LS || Inst->Conf.SpeedSource > SPEED_SRC_BOTH){
+        DBG("Bad value of SpeedSource");
+        ret = MCC_E_BADFORMAT;
+    }
+    if(Inst->Conf.RTPriority < 0 || Inst->Conf.RTPriority > sched_get_priority_max(SCHED_FIFO)){
+        DBG("Bad value of RTPriority");
+        ret = MCC_E_BADFORMAT;
+    }
+    if(!pec_init()){
+        DBG("Bad values of PEC parameters");
+        ret = MCC_E_BADFORMAT;
+    }
+    if(vclock_active() && !Inst->Conf.RunModel && !Inst->Conf.ReplayPath){
+        DBG("Virtual clock works only in model or replay mode");
+        ret = MCC_E_BADFORMAT;
+    }
+    if(!Inst->Conf.RunModel){
+        if(Inst->Conf.EncoderSpeedInterval < Inst->Conf.EncoderReqInterval * MCC_CONF_MIN_SPEEDC || Inst->Conf.EncoderSpeedInterval > MCC_CONF_MAX_SPEEDINT){
+            DBG("Wrong speed interval");
+            ret = MCC_E_BADFORMAT;
+        }
+        if(Inst->Conf.SepEncoder && !Inst->Conf.ReplayPath && !Inst->Conf.EncoderDevPath && !Inst->Conf.EncoderXDevPath){
+            DBG("Define encoder device path");
+            ret = MCC_E_BADFORMAT;
+        }
+        if(!Inst->Conf.ReplayPath && (!Inst->Conf.MountDevPath || Inst->Conf.MountDevSpeed < MOUNT_BAUDRATE_MIN)){
+            DBG("Define mount device path and speed");
+            ret = MCC_E_BADFORMAT;
+        }
+    }
+    if(ret != MCC_E_OK) return ret;
+    wasinited = 1;
+    // recorder is opened only for accepted configuration
+    if(Inst->Conf.RecordPath && !tlog_open(Inst->Conf.RecordPath)){
+        DBG("Can't open record %s", Inst->Conf.RecordPath);
+        return MCC_E_FAILED;
+    }
+    if(Inst->Conf.RunModel){
+        if(!Inst->Xmodel || !Inst->Ymodel || !openMount()){
+            tlog_close();
+            return MCC_E_FAILED;
+        }
+        init_setstate(MCC_INIT_MOUNTDEV, MCC_INIT_BUSY, MCC_E_OK);
+        return MCC_E_OK;
+    }
+    DBG("Try to open mount device");
+    if(!openMount()){
+        DBG("Can't open %s with speed %d", Inst->Conf.MountDevPath, Inst->Conf.MountDevSpeed);
+        tlog_close();
+        return MCC_E_MOUNTDEV;
+    }
+    init_setstate(MCC_INIT_MOUNTDEV, MCC_INIT_BUSY, MCC_E_OK);
+    // encoders' zero is known before hardware configuration
+    X_ENC_ZERO = Inst->Conf.XEncZero;
+    Y_ENC_ZERO = Inst->Conf.YEncZero;
+    SSsetconst(&Inst->ss);
+    return MCC_E_OK;
+}
+
+/**
+ * @brief init_async - start initialization and return at once
+ * @param c - initial configuration
+ * @param cb - callback called after the end of bring-up (if returned MCC_E_OK)
+ * @param arg - its argument
+ * @return error code (MCC_E_OK if bring-up started)
+ */
+static mcc_errcodes_t init_async(conf_t *c, mcc_initcb_t cb, void *arg){
+    FNAME();
+    if(!c) return MCC_E_BADFORMAT;
+    init_join(); // previous bring-up (if init called without quit)
+    pthread_mutex_lock(&Inst->ini.mutex);
+    Inst->ini.st = (mcc_initstate_t){.stage = MCC_INIT_BUSY};
+    pthread_mutex_unlock(&Inst->ini.mutex);
+    atomic_store(&Inst->ini.abort, 0);
+    Inst->ini.cb = cb;
+    Inst->ini.cbarg = arg;
+    mcc_errcodes_t ret = init_start(c);
+    if(MCC_E_OK != ret){
+        init_setstate(0, MCC_INIT_FAILED, ret);
+        return ret;
+    }
+    if(Inst->Conf.RunModel){
+        init_finish(MCC_E_OK);
+        return MCC_E_OK;
+    }
+    if(pthread_create(&Inst->ini.thread, NULL, bringupthread, Inst)){
+        DBG("Can't create bring-up thread");
+        tlog_close();
+        init_setstate(0, MCC_INIT_FAILED, MCC_E_FAILED);
+        return MCC_E_FAILED;
+    }
+    Inst->ini.started = 1;
+    return MCC_E_OK;
+}
+
+/**
+ * @brief init - open serial devices and do other job (wait for the end of bring-up)
+ * @param c - initial configuration
+ * @return error code
+ */
+static mcc_errcodes_t init(conf_t *c){
+    mcc_errcodes_t ret = init_async(c, NULL, NULL);
+    if(MCC_E_OK != ret) return ret;
+    init_join();
+    return Inst->ini.st.err;
 }
 
 // check coordinates (rad) and speeds (rad/s); return FALSE if failed
 // TODO fix to real limits!!!
 static int chkX(double X){
-    if(X > Xlimits.max.coord || X < Xlimits.min.coord) return FALSE;
+    if(X > Inst->Xlimits.max.coord || X < Inst->Xlimits.min.coord) return FALSE;
     return TRUE;
 }
 static int chkY(double Y){
-    if(Y > Ylimits.max.coord || Y < Ylimits.min.coord) return FALSE;
+    if(Y > Inst->Ylimits.max.coord || Y < Inst->Ylimits.min.coord) return FALSE;
     return TRUE;
 }
 static int chkXs(double s){
-    if(s < Xlimits.min.speed || s > Xlimits.max.speed) return FALSE;
+    if(s < Inst->Xlimits.min.speed || s > Inst->Xlimits.max.speed) return FALSE;
     return TRUE;
 }
 static int chkYs(double s){
-    if(s < Ylimits.min.speed || s > Ylimits.max.speed) return FALSE;
+    if(s < Inst->Ylimits.min.speed || s > Inst->Ylimits.max.speed) return FALSE;
     return TRUE;
 }
 
@@ -309,8 +660,8 @@ static mcc_errcodes_t move2(const coordpair_t *target){
     DBG("x,y: %g, %g", target->X, target->Y);
     cmd.Xmot = target->X;
     cmd.Ymot = target->Y;
-    cmd.Xspeed = Xlimits.max.speed;
-    cmd.Yspeed = Ylimits.max.speed;
+    cmd.Xspeed = Inst->Xlimits.max.speed;
+    cmd.Yspeed = Inst->Ylimits.max.speed;
     return shortcmd(&cmd);
 }
 
@@ -322,7 +673,7 @@ static mcc_errcodes_t move2(const coordpair_t *target){
  */
 static mcc_errcodes_t setspeed(const coordpair_t *tagspeed){
     if(!tagspeed || !chkXs(tagspeed->X) || !chkYs(tagspeed->Y)) return MCC_E_BADFORMAT;
-    if(Conf.RunModel) return MCC_E_FAILED;
+    if(Inst->Conf.RunModel) return MCC_E_FAILED;
     int32_t spd = X_RS2MOTSPD(tagspeed->X);
     if(!SSsetterI(CMD_SPEEDX, spd)) return MCC_E_FAILED;
     spd = Y_RS2MOTSPD(tagspeed->Y);
@@ -336,7 +687,7 @@ static mcc_errcodes_t setspeed(const coordpair_t *tagspeed){
  * @param speed (i) - speed or NULL
  * @return
  */
-static mcc_errcodes_t move2s(const coordpair_t *target, const coordpair_t *speed){
+mcc_errcodes_t move2s(const coordpair_t *target, const coordpair_t *speed){
     if(!target || !speed) return MCC_E_BADFORMAT;
     if(!chkX(target->X) || !chkY(target->Y)) return MCC_E_BADFORMAT;
     if(!chkXs(speed->X) || !chkYs(speed->Y)) return MCC_E_BADFORMAT;
@@ -356,10 +707,11 @@ static mcc_errcodes_t move2s(const coordpair_t *target, const coordpair_t *speed
  */
 static mcc_errcodes_t emstop(){
     FNAME();
-    if(Conf.RunModel){
+    track_stop();
+    if(Inst->Conf.RunModel){
         double curt = timefromstart();
-        Xmodel->emergency_stop(Xmodel, curt);
-        Ymodel->emergency_stop(Ymodel, curt);
+        Inst->Xmodel->emergency_stop(Inst->Xmodel, curt);
+        Inst->Ymodel->emergency_stop(Inst->Ymodel, curt);
         return MCC_E_OK;
     }
     if(!SSstop(TRUE)) return MCC_E_FAILED;
@@ -368,16 +720,79 @@ static mcc_errcodes_t emstop(){
 // normal stop
 static mcc_errcodes_t stop(){
     FNAME();
-    if(Conf.RunModel){
+    track_stop();
+    if(Inst->Conf.RunModel){
         double curt = timefromstart();
-        Xmodel->stop(Xmodel, curt);
-        Ymodel->stop(Ymodel,curt);
+        Inst->Xmodel->stop(Inst->Xmodel, curt);
+        Inst->Ymodel->stop(Inst->Ymodel,curt);
         return MCC_E_OK;
     }
     if(!SSstop(FALSE)) return MCC_E_FAILED;
     return MCC_E_OK;
 }
 
+// convert short/long commands into SSII format
+static void scmd2SS(const short_command_t *cmd, SSscmd *s){
+    bzero(s, sizeof(SSscmd));
+    DBG("tag: xmot=%g rad, ymot=%g rad", cmd->Xmot, cmd->Ymot);
+    s->Xmot = X_RAD2MOT(cmd->Xmot);
+    s->Ymot = Y_RAD2MOT(cmd->Ymot);
+    s->Xspeed = X_RS2MOTSPD(cmd->Xspeed);
+    s->Yspeed = Y_RS2MOTSPD(cmd->Yspeed);
+    s->xychange = cmd->xychange;
+    s->XBits = cmd->XBits;
+    s->YBits = cmd->YBits;
+    DBG("X->%d, Y->%d, Xs->%d, Ys->%d", s->Xmot, s->Ymot, s->Xspeed, s->Yspeed);
+}
+static void lcmd2SS(const long_command_t *cmd, SSlcmd *l){
+    bzero(l, sizeof(SSlcmd));
+    l->Xmot = X_RAD2MOT(cmd->Xmot);
+    l->Ymot = Y_RAD2MOT(cmd->Ymot);
+    l->Xspeed = X_RS2MOTSPD(cmd->Xspeed);
+    l->Yspeed = Y_RS2MOTSPD(cmd->Yspeed);
+    l->Xadder = X_RS2MOTSPD(cmd->Xadder);
+    l->Yadder = Y_RS2MOTSPD(cmd->Yadder);
+    l->Xatime = S2ADDER(cmd->Xatime);
+    l->Yatime = S2ADDER(cmd->Yatime);
+}
+
+// move model to given point with given speed (adders of previous long command are cancelled)
+static mcc_errcodes_t modmove(double Xmot, double Xspeed, double Ymot, double Yspeed){
+    double curt = timefromstart();
+    moveparam_t param = {0};
+    pthread_mutex_lock(&Inst->madmutex);
+    Inst->Xmadder.active = Inst->Ymadder.active = 0;
+    pthread_mutex_unlock(&Inst->madmutex);
+    param.coord = Xmot; param.speed = Xspeed;
+    if(!model_move2(Inst->Xmodel, &param, curt)) return MCC_E_FAILED;
+    param.coord = Ymot; param.speed = Yspeed;
+    if(!model_move2(Inst->Ymodel, &param, curt)) return MCC_E_FAILED;
+    setslewingstate();
+    return MCC_E_OK;
+}
+
+// set adder by long command
+static void setmadder(modadder_t *a, double coord, double speed, double adder, double atime, double t){
+    a->target.coord = coord;
+    a->target.speed = speed;
+    a->adder = adder;
+    a->t0 = t;
+    a->tend = t + atime;
+    a->active = (adder != 0. && atime > 0.);
+}
+
+// run long command by model
+static mcc_errcodes_t modmovel(const long_command_t *cmd){
+    mcc_errcodes_t ret = modmove(cmd->Xmot, cmd->Xspeed, cmd->Ymot, cmd->Yspeed);
+    if(ret != MCC_E_OK) return ret;
+    double curt = timefromstart();
+    pthread_mutex_lock(&Inst->madmutex);
+    setmadder(&Inst->Xmadder, cmd->Xmot, cmd->Xspeed, cmd->Xadder, cmd->Xatime, curt);
+    setmadder(&Inst->Ymadder, cmd->Ymot, cmd->Yspeed, cmd->Yadder, cmd->Yatime, curt);
+    pthread_mutex_unlock(&Inst->madmutex);
+    return MCC_E_OK;
+}
+
 /**
  * @brief shortcmd - send and receive short binary command
  * @param cmd (io) - command
@@ -385,26 +800,9 @@ static mcc_errcodes_t stop(){
  */
 static mcc_errcodes_t shortcmd(short_command_t *cmd){
     if(!cmd) return MCC_E_BADFORMAT;
-    if(Conf.RunModel){
-        double curt = timefromstart();
-        moveparam_t param = {0};
-        param.coord = cmd->Xmot; param.speed = cmd->Xspeed;
-        if(!model_move2(Xmodel, &param, curt)) return MCC_E_FAILED;
-        param.coord = cmd->Ymot; param.speed = cmd->Yspeed;
-        if(!model_move2(Ymodel, &param, curt)) return MCC_E_FAILED;
-        setslewingstate();
-        return MCC_E_OK;
-    }
-    SSscmd s = {0};
-    DBG("tag: xmot=%g rad, ymot=%g rad", cmd->Xmot, cmd->Ymot);
-    s.Xmot = X_RAD2MOT(cmd->Xmot);
-    s.Ymot = Y_RAD2MOT(cmd->Ymot);
-    s.Xspeed = X_RS2MOTSPD(cmd->Xspeed);
-    s.Yspeed = Y_RS2MOTSPD(cmd->Yspeed);
-    s.xychange = cmd->xychange;
-    s.XBits = cmd->XBits;
-    s.YBits = cmd->YBits;
-    DBG("X->%d, Y->%d, Xs->%d, Ys->%d", s.Xmot, s.Ymot, s.Xspeed, s.Yspeed);
+    if(Inst->Conf.RunModel) return modmove(cmd->Xmot, cmd->Xspeed, cmd->Ymot, cmd->Yspeed);
+    SSscmd s;
+    scmd2SS(cmd, &s);
     if(!cmdS(&s)) return MCC_E_FAILED;
     setslewingstate();
     return MCC_E_OK;
@@ -415,221 +813,306 @@ static mcc_errcodes_t shortcmd(short_command_t *cmd){
  * @param cmd (io) - command
  * @return errcode
  */
-static mcc_errcodes_t longcmd(long_command_t *cmd){
+mcc_errcodes_t longcmd(long_command_t *cmd){
     if(!cmd) return MCC_E_BADFORMAT;
-    if(Conf.RunModel){
-        double curt = timefromstart();
-        moveparam_t param = {0};
-        param.coord = cmd->Xmot; param.speed = cmd->Xspeed;
-        if(!model_move2(Xmodel, &param, curt)) return MCC_E_FAILED;
-        param.coord = cmd->Ymot; param.speed = cmd->Yspeed;
-        if(!model_move2(Ymodel, &param, curt)) return MCC_E_FAILED;
-        setslewingstate();
-        return MCC_E_OK;
-    }
-    SSlcmd l = {0};
-    l.Xmot = X_RAD2MOT(cmd->Xmot);
-    l.Ymot = Y_RAD2MOT(cmd->Ymot);
-    l.Xspeed = X_RS2MOTSPD(cmd->Xspeed);
-    l.Yspeed = Y_RS2MOTSPD(cmd->Yspeed);
-    l.Xadder = X_RS2MOTSPD(cmd->Xadder);
-    l.Yadder = Y_RS2MOTSPD(cmd->Yadder);
-    l.Xatime = S2ADDER(cmd->Xatime);
-    l.Yatime = S2ADDER(cmd->Yatime);
+    if(Inst->Conf.RunModel) return modmovel(cmd);
+    SSlcmd l;
+    lcmd2SS(cmd, &l);
     if(!cmdL(&l)) return MCC_E_FAILED;
     setslewingstate();
     return MCC_E_OK;
 }
 
-static mcc_errcodes_t get_hwconf(hardware_configuration_t *hwConfig){
-    if(!hwConfig) return MCC_E_BADFORMAT;
-    if(Conf.RunModel) return MCC_E_FAILED;
-    SSconfig config;
-    DBG("Read HW configuration");
-    if(!cmdC(&config, FALSE)) return MCC_E_FAILED;
-    // Convert acceleration (ticks per loop^2 to rad/s^2)
-    hwConfig->Xconf.accel = X_MOTACC2RS(config.Xconf.accel);
-    hwConfig->Yconf.accel = Y_MOTACC2RS(config.Yconf.accel);
-    // Convert backlash (ticks to radians)
-    hwConfig->Xconf.backlash = X_MOT2RAD(config.Xconf.backlash);
-    hwConfig->Yconf.backlash = Y_MOT2RAD(config.Yconf.backlash);
-    // Convert error limit (ticks to radians)
-    hwConfig->Xconf.errlimit = X_MOT2RAD(config.Xconf.errlimit);
-    hwConfig->Yconf.errlimit = Y_MOT2RAD(config.Yconf.errlimit);
-    // Proportional, integral, and derivative gains are unitless, so no conversion needed
-    hwConfig->Xconf.propgain = (double)config.Xconf.propgain;
-    hwConfig->Yconf.propgain = (double)config.Yconf.propgain;
-    hwConfig->Xconf.intgain = (double)config.Xconf.intgain;
-    hwConfig->Yconf.intgain = (double)config.Yconf.intgain;
-    hwConfig->Xconf.derivgain = (double)config.Xconf.derivgain;
-    hwConfig->Yconf.derivgain = (double)config.Yconf.derivgain;
-    // Output limit is a percentage (0-100)
-    hwConfig->Xconf.outplimit = (double)config.Xconf.outplimit / 255.0 * 100.0;
-    hwConfig->Yconf.outplimit = (double)config.Yconf.outplimit / 255.0 * 100.0;
-    // Current limit in amps
-    hwConfig->Xconf.currlimit = (double)config.Xconf.currlimit / 100.0;
-    hwConfig->Yconf.currlimit = (double)config.Yconf.currlimit / 100.0;
-    // Integral limit is unitless
-    hwConfig->Xconf.intlimit = (double)config.Xconf.intlimit;
-    hwConfig->Yconf.intlimit = (double)config.Yconf.intlimit;
-    // Copy XBits and YBits (no conversion needed)
-    hwConfig->xbits = config.xbits;
-    hwConfig->ybits = config.ybits;
-    // Copy address
-    hwConfig->address = config.address;
-
-    // TODO: What to do with eqrate, eqadj and trackgoal?
-    config.latitude = __bswap_16(config.latitude);
-    // Convert latitude (degrees * 100 to radians)
-    hwConfig->latitude = ((double)config.latitude) / 100.0 * M_PI / 180.0;
-    // Copy ticks per revolution
-    hwConfig->Xsetpr = __bswap_32(config.Xsetpr);
-    hwConfig->Ysetpr = __bswap_32(config.Ysetpr);
-    hwConfig->Xmetpr = __bswap_32(config.Xmetpr); // as documentation said, real ticks are 4 times less
-    hwConfig->Ymetpr = __bswap_32(config.Ymetpr);
-    // Convert slew rates (ticks per loop to rad/s)
-    hwConfig->Xslewrate = X_MOTSPD2RS(config.Xslewrate);
-    hwConfig->Yslewrate = Y_MOTSPD2RS(config.Yslewrate);
-    // Convert pan rates (ticks per loop to rad/s)
-    hwConfig->Xpanrate = X_MOTSPD2RS(config.Xpanrate);
-    hwConfig->Ypanrate = Y_MOTSPD2RS(config.Ypanrate);
-    // Convert guide rates (ticks per loop to rad/s)
-    hwConfig->Xguiderate = X_MOTSPD2RS(config.Xguiderate);
-    hwConfig->Yguiderate = Y_MOTSPD2RS(config.Yguiderate);
-    // copy baudrate
-    hwConfig->baudrate = (uint32_t) config.baudrate;
-    // Convert local search degrees (degrees * 100 to radians)
-    hwConfig->locsdeg = (double)config.locsdeg / 100.0 * M_PI / 180.0;
-    // Convert local search speed (arcsec per second to rad/s)
-    hwConfig->locsspeed = (double)config.locsspeed * M_PI / (180.0 * 3600.0);
-    // Convert backlash speed (ticks per loop to rad/s)
-    hwConfig->backlspd = X_MOTSPD2RS(config.backlspd);
-    // now read text commands
-    int64_t i64;
-    double Xticks, Yticks;
-    DBG("SERIAL");
-    // motor's encoder ticks per rev
-    if(!SSgetint(CMD_MEPRX, &i64)) return MCC_E_FAILED;
-    Xticks = ((double) i64); // divide by 4 as these values stored ???
-    if(!SSgetint(CMD_MEPRY, &i64)) return MCC_E_FAILED;
-    Yticks = ((double) i64);
-    X_ENC_ZERO = Conf.XEncZero;
-    Y_ENC_ZERO = Conf.YEncZero;
-    DBG("xyrev: %d/%d", config.xbits.motrev, config.ybits.motrev);
-    X_MOT_STEPSPERREV = hwConfig->Xconf.motor_stepsperrev = Xticks; // (config.xbits.motrev) ? -Xticks : Xticks;
-    Y_MOT_STEPSPERREV = hwConfig->Yconf.motor_stepsperrev = Yticks; //(config.ybits.motrev) ? -Yticks : Yticks;
-    DBG("zero: %d/%d; motsteps: %.10g/%.10g", X_ENC_ZERO, Y_ENC_ZERO, X_MOT_STEPSPERREV, Y_MOT_STEPSPERREV);
-    // axis encoder ticks per rev
-    if(!SSgetint(CMD_AEPRX, &i64)) return MCC_E_FAILED;
-    Xticks = (double) i64;
-    if(!SSgetint(CMD_AEPRY, &i64)) return MCC_E_FAILED;
-    Yticks = (double) i64;
-    DBG("xyencrev: %d/%d", config.xbits.encrev, config.ybits.encrev);
-    X_ENC_STEPSPERREV = hwConfig->Xconf.axis_stepsperrev = (config.xbits.encrev) ? -Xticks : Xticks;
-    Y_ENC_STEPSPERREV = hwConfig->Yconf.axis_stepsperrev = (config.ybits.encrev) ? -Yticks : Yticks;
-    DBG("encsteps: %.10g/%.10g", X_ENC_STEPSPERREV, Y_ENC_STEPSPERREV);
+/**
+ * @brief shortcmd_async - put short binary command into I/O queue
+ * @param cmd (i) - command
+ * @param cb - callback after command done (or NULL)
+ * @param arg - callback argument
+ * @return errcode (of queueing; result of command is given to callback)
+ */
+static mcc_errcodes_t shortcmd_async(const short_command_t *cmd, mcc_cmdcb_t cb, void *arg){
+    if(!cmd) return MCC_E_BADFORMAT;
+    if(Inst->Conf.RunModel){
+        mcc_errcodes_t ret = modmove(cmd->Xmot, cmd->Xspeed, cmd->Ymot, cmd->Yspeed);
+        if(cb) cb(ret, arg);
+        return MCC_E_OK;
+    }
+    SSscmd s;
+    scmd2SS(cmd, &s);
+    // state is changed before command sent: if it fails, mount thread will find that axes are stopped
+    setslewingstate();
+    if(!cmdSasync(&s, cb, arg)) return MCC_E_FAILED;
     return MCC_E_OK;
 }
 
-static mcc_errcodes_t write_hwconf(hardware_configuration_t *hwConfig){
-    SSconfig config;
-    if(Conf.RunModel) return MCC_E_FAILED;
-    // Convert acceleration (rad/s^2 to ticks per loop^2)
-    config.Xconf.accel = X_RS2MOTACC(hwConfig->Xconf.accel);
-    config.Yconf.accel = Y_RS2MOTACC(hwConfig->Yconf.accel);
-    // Convert backlash (radians to ticks)
-    config.Xconf.backlash = X_RAD2MOT(hwConfig->Xconf.backlash);
-    config.Yconf.backlash = Y_RAD2MOT(hwConfig->Yconf.backlash);
-    // Convert error limit (radians to ticks)
-    config.Xconf.errlimit = X_RAD2MOT(hwConfig->Xconf.errlimit);
-    config.Yconf.errlimit = Y_RAD2MOT(hwConfig->Yconf.errlimit);
-    // Proportional, integral, and derivative gains are unitless, so no conversion needed
-    config.Xconf.propgain = (uint16_t)hwConfig->Xconf.propgain;
-    config.Yconf.propgain = (uint16_t)hwConfig->Yconf.propgain;
-    config.Xconf.intgain = (uint16_t)hwConfig->Xconf.intgain;
-    config.Yconf.intgain = (uint16_t)hwConfig->Yconf.intgain;
-    config.Xconf.derivgain = (uint16_t)hwConfig->Xconf.derivgain;
-    config.Yconf.derivgain = (uint16_t)hwConfig->Yconf.derivgain;
-    // Output limit is a percentage (0-100), so convert back to 0-255
-    config.Xconf.outplimit = (uint8_t)(hwConfig->Xconf.outplimit / 100.0 * 255.0);
-    config.Yconf.outplimit = (uint8_t)(hwConfig->Yconf.outplimit / 100.0 * 255.0);
-    // Current limit is in amps (convert back to *100)
-    config.Xconf.currlimit = (uint16_t)(hwConfig->Xconf.currlimit * 100.0);
-    config.Yconf.currlimit = (uint16_t)(hwConfig->Yconf.currlimit * 100.0);
-    // Integral limit is unitless, so no conversion needed
-    config.Xconf.intlimit = (uint16_t)hwConfig->Xconf.intlimit;
-    config.Yconf.intlimit = (uint16_t)hwConfig->Yconf.intlimit;
-    // Copy XBits and YBits (no conversion needed)
-    config.xbits = hwConfig->xbits;
-    config.ybits = hwConfig->ybits;
-    // Convert latitude (radians to degrees * 100)
-    config.latitude = __bswap_16((uint16_t)(hwConfig->latitude * 180.0 / M_PI * 100.0));
-    // Convert slew rates (rad/s to ticks per loop)
-    config.Xslewrate = X_RS2MOTSPD(hwConfig->Xslewrate);
-    config.Yslewrate = Y_RS2MOTSPD(hwConfig->Yslewrate);
-    // Convert pan rates (rad/s to ticks per loop)
-    config.Xpanrate = X_RS2MOTSPD(hwConfig->Xpanrate);
-    config.Ypanrate = Y_RS2MOTSPD(hwConfig->Ypanrate);
-    // Convert guide rates (rad/s to ticks per loop)
-    config.Xguiderate = X_RS2MOTSPD(hwConfig->Xguiderate);
-    config.Yguiderate = Y_RS2MOTSPD(hwConfig->Yguiderate);
-    // Convert local search degrees (radians to degrees * 100)
-    config.locsdeg = (uint32_t)(hwConfig->locsdeg * 180.0 / M_PI * 100.0);
-    // Convert local search speed (rad/s to arcsec per second)
-    config.locsspeed = (uint32_t)(hwConfig->locsspeed * 180.0 * 3600.0 / M_PI);
-    // Convert backlash speed (rad/s to ticks per loop)
-    config.backlspd = X_RS2MOTSPD(hwConfig->backlspd);
-    config.Xsetpr = __bswap_32(hwConfig->Xsetpr);
-    config.Ysetpr = __bswap_32(hwConfig->Ysetpr);
-    config.Xmetpr = __bswap_32(hwConfig->Xmetpr);
-    config.Ymetpr = __bswap_32(hwConfig->Ymetpr);
-    // todo - also write text params
-    // TODO - next
-    (void) config;
+/**
+ * @brief longcmd_async - put long binary command into I/O queue
+ * @param cmd (i) - command
+ * @param cb - callback after command done (or NULL)
+ * @param arg - callback argument
+ * @return errcode (of queueing; result of command is given to callback)
+ */
+static mcc_errcodes_t longcmd_async(const long_command_t *cmd, mcc_cmdcb_t cb, void *arg){
+    if(!cmd) return MCC_E_BADFORMAT;
+    if(Inst->Conf.RunModel){
+        mcc_errcodes_t ret = modmovel(cmd);
+        if(cb) cb(ret, arg);
+        return MCC_E_OK;
+    }
+    SSlcmd l;
+    lcmd2SS(cmd, &l);
+    setslewingstate();
+    if(!cmdLasync(&l, cb, arg)) return MCC_E_FAILED;
     return MCC_E_OK;
 }
 
 // getters of max/min speed and acceleration
 mcc_errcodes_t maxspeed(coordpair_t *v){
     if(!v) return MCC_E_BADFORMAT;
-    v->X = Xlimits.max.speed;
-    v->Y = Ylimits.max.speed;
+    v->X = Inst->Xlimits.max.speed;
+    v->Y = Inst->Ylimits.max.speed;
     return MCC_E_OK;
 }
 mcc_errcodes_t minspeed(coordpair_t *v){
     if(!v) return MCC_E_BADFORMAT;
-    v->X = Xlimits.min.speed;
-    v->Y = Ylimits.min.speed;
+    v->X = Inst->Xlimits.min.speed;
+    v->Y = Inst->Ylimits.min.speed;
     return MCC_E_OK;
 }
 mcc_errcodes_t acceleration(coordpair_t *a){
     if(!a) return MCC_E_BADFORMAT;
-    a->X = Xlimits.max.accel;
-    a->Y = Ylimits.max.accel;
+    a->X = Inst->Xlimits.max.accel;
+    a->Y = Inst->Ylimits.max.accel;
     return MCC_E_OK;
 }
 
+/**
+ * @brief readenchist - read encoders' history since last call
+ * @param X (o) - array for X samples or NULL
+ * @param nX (io) - size of X (in) and amount of samples read (out)
+ * @param Y, nY - the same for Y
+ * @return errcode
+ */
+static mcc_errcodes_t readenchist(encsample_t *X, size_t *nX, encsample_t *Y, size_t *nY){
+    if((!X || !nX) && (!Y || !nY)) return MCC_E_BADFORMAT;
+    if(X && nX) *nX = enchist_read(0, X, *nX);
+    if(Y && nY) *nY = enchist_read(1, Y, *nY);
+    return MCC_E_OK;
+}
+
+/**
+ * @brief inst_init - set default state of mount instance
+ * @param m - instance
+ * @param id - its index
+ */
+static void inst_init(mntinst_t *m, int id){
+    bzero(m, sizeof(mntinst_t));
+    m->id = id;
+    m->Xlimits = Xdeflimits;
+    m->Ylimits = Ydeflimits;
+    m->ss = (ssconst_t) SS_DEFCONST;
+    SSsetconst(&m->ss);
+    pthread_mutex_init(&m->madmutex, NULL);
+    serial_state_t *S = &m->ser;
+    S->encfd[0] = S->encfd[1] = S->mntfd = -1;
+    S->mntslot = -1;
+    S->Xmot_prev = S->Ymot_prev = INT32_MAX;
+    pthread_mutex_init(&S->mntmutex, NULL);
+    pthread_mutex_init(&S->datamutex, NULL);
+    pthread_mutex_init(&S->qmutex, NULL);
+    pthread_cond_init(&S->qcond, NULL);
+    pthread_cond_init(&S->donecond, NULL);
+    m->pid.tprev = -1.;
+    m->trk.slot = -1;
+    pthread_mutex_init(&m->trk.mutex, NULL);
+    pthread_mutex_init(&m->slew.mutex, NULL);
+    pthread_mutex_init(&m->pec.mutex, NULL);
+    pthread_mutex_init(&m->rp.mutex, NULL);
+    pthread_mutex_init(&m->tlog.mutex, NULL);
+    pthread_cond_init(&m->tlog.cond, NULL);
+    pthread_mutex_init(&m->ini.mutex, NULL);
+}
+
+/**
+ * @brief inst_destroy - free models and sync objects of stopped instance (before its slot reuse by inst_init())
+ * @param m - instance
+ */
+static void inst_destroy(mntinst_t *m){
+    if(m->Xmodel){ model_free(m->Xmodel); m->Xmodel = NULL; }
+    if(m->Ymodel){ model_free(m->Ymodel); m->Ymodel = NULL; }
+    if(m->slew.inited){
+        model_free(&m->slew.X);
+        model_free(&m->slew.Y);
+        m->slew.inited = 0;
+    }
+    pthread_mutex_destroy(&m->madmutex);
+    serial_state_t *S = &m->ser;
+    pthread_mutex_destroy(&S->mntmutex);
+    pthread_mutex_destroy(&S->datamutex);
+    pthread_mutex_destroy(&S->qmutex);
+    pthread_cond_destroy(&S->qcond);
+    pthread_cond_destroy(&S->donecond);
+    pthread_mutex_destroy(&m->trk.mutex);
+    pthread_mutex_destroy(&m->slew.mutex);
+    pthread_mutex_destroy(&m->pec.mutex);
+    pthread_mutex_destroy(&m->rp.mutex);
+    pthread_mutex_destroy(&m->tlog.mutex);
+    pthread_cond_destroy(&m->tlog.cond);
+    pthread_mutex_destroy(&m->ini.mutex);
+}
+
+__attribute__((constructor)) static void inst0_init(){
+    inst_init(&Inst0, 0);
+}
+
+/*
+ * Methods of each slot of `Instances`: make slot's instance current for the time of call, so any thread
+ * can work with any mount (and callbacks of one mount can call methods of another)
+ */
+#define INSTFN(N, type, fn, par, arg)  static type fn ## N par{ \
+    mntinst_t *oldinst = Inst; Inst = Instances[N]; type ret = fn arg; Inst = oldinst; return ret; }
+#define INSTFNV(N, fn, par, arg)  static void fn ## N par{ \
+    mntinst_t *oldinst = Inst; Inst = Instances[N]; fn arg; Inst = oldinst; }
+
+#define INSTFUNCS(N) \
+    INSTFN(N, mcc_errcodes_t, init, (conf_t *c), (c)) \
+    INSTFNV(N, quit, (), ()) \
+    INSTFN(N, mcc_errcodes_t, getMD, (mountdata_t *d), (d)) \
+    INSTFN(N, mcc_errcodes_t, correct2, (const coordval_pair_t *t), (t)) \
+    INSTFN(N, mcc_errcodes_t, correct2ff, (const targval_pair_t *t), (t)) \
+    INSTFN(N, mcc_errcodes_t, move2, (const coordpair_t *t), (t)) \
+    INSTFN(N, mcc_errcodes_t, move2s, (const coordpair_t *t, const coordpair_t *s), (t, s)) \
+    INSTFN(N, mcc_errcodes_t, setspeed, (const coordpair_t *s), (s)) \
+    INSTFN(N, mcc_errcodes_t, stop, (), ()) \
+    INSTFN(N, mcc_errcodes_t, emstop, (), ()) \
+    INSTFN(N, mcc_errcodes_t, shortcmd, (short_command_t *c), (c)) \
+    INSTFN(N, mcc_errcodes_t, longcmd, (long_command_t *c), (c)) \
+    INSTFN(N, mcc_errcodes_t, get_hwconf, (hardware_configuration_t *c), (c)) \
+    INSTFN(N, mcc_errcodes_t, write_hwconf, (hardware_configuration_t *c), (c)) \
+    INSTFN(N, int, curtime, (struct timespec *t), (t)) \
+    INSTFN(N, double, timefromstart, (), ()) \
+    INSTFN(N, double, timediff0, (const struct timespec *t), (t)) \
+    INSTFN(N, mcc_errcodes_t, maxspeed, (coordpair_t *v), (v)) \
+    INSTFN(N, mcc_errcodes_t, minspeed, (coordpair_t *v), (v)) \
+    INSTFN(N, mcc_errcodes_t, acceleration, (coordpair_t *a), (a)) \
+    INSTFN(N, mcc_errcodes_t, readenchist, (encsample_t *X, size_t *nX, encsample_t *Y, size_t *nY), (X, nX, Y, nY)) \
+    INSTFN(N, mcc_errcodes_t, shortcmd_async, (const short_command_t *c, mcc_cmdcb_t cb, void *arg), (c, cb, arg)) \
+    INSTFN(N, mcc_errcodes_t, longcmd_async, (const long_command_t *c, mcc_cmdcb_t cb, void *arg), (c, cb, arg)) \
+    INSTFN(N, mcc_errcodes_t, getCmdLatency, (mcc_cmdclass_t cls, mcc_hist_t *h), (cls, h)) \
+    INSTFN(N, mcc_errcodes_t, getstats, (mcc_stats_t *s), (s)) \
+    INSTFNV(N, resetstats, (), ()) \
+    INSTFN(N, mcc_errcodes_t, track_start, (const mcc_track_t *t), (t)) \
+    INSTFN(N, mcc_errcodes_t, track_stop, (), ()) \
+    INSTFN(N, mcc_errcodes_t, pid_tune, (const mcc_pidtune_t *p, mcc_pidtune_res_t *r), (p, r)) \
+    INSTFN(N, mcc_errcodes_t, slew_to, (const coordpair_t *t, double *d), (t, d)) \
+    INSTFN(N, mcc_errcodes_t, slew_plan, (const mcc_slewplan_t *p, mcc_slewplan_res_t *r), (p, r)) \
+    INSTFN(N, mcc_errcodes_t, replay_state, (mcc_replay_t *s), (s)) \
+    INSTFN(N, mcc_errcodes_t, pec_set, (const mcc_pecmode_t *m), (m)) \
+    INSTFN(N, mcc_errcodes_t, pec_get, (mcc_pec_t *s), (s)) \
+    INSTFN(N, mcc_errcodes_t, pec_save, (const char *p), (p)) \
+    INSTFN(N, mcc_errcodes_t, init_async, (conf_t *c, mcc_initcb_t cb, void *arg), (c, cb, arg)) \
+    INSTFN(N, mcc_errcodes_t, init_getstate, (mcc_initstate_t *s), (s))
+
+// class of mount in slot N
+#define INSTTABLE(N) { \
+    .init = init ## N, \
+    .quit = quit ## N, \
+    .getMountData = getMD ## N, \
+    .moveTo = move2 ## N, \
+    .moveWspeed = move2s ## N, \
+    .setSpeed = setspeed ## N, \
+    .emergStop = emstop ## N, \
+    .stop = stop ## N, \
+    .shortCmd = shortcmd ## N, \
+    .longCmd = longcmd ## N, \
+    .getHWconfig = get_hwconf ## N, \
+    .saveHWconfig = write_hwconf ## N, \
+    .currentT = curtime ## N, \
+    .timeFromStart = timefromstart ## N, \
+    .timeDiff = timediff, \
+    .timeDiff0 = timediff0 ## N, \
+    .correctTo = correct2 ## N, \
+    .correctToFF = correct2ff ## N, \
+    .getMaxSpeed = maxspeed ## N, \
+    .getMinSpeed = minspeed ## N, \
+    .getAcceleration = acceleration ## N, \
+    .readEncoderHistory = readenchist ## N, \
+    .shortCmdAsync = shortcmd_async ## N, \
+    .longCmdAsync = longcmd_async ## N, \
+    .getCmdLatency = getCmdLatency ## N, \
+    .getStats = getstats ## N, \
+    .resetStats = resetstats ## N, \
+    .track = track_start ## N, \
+    .trackStop = track_stop ## N, \
+    .trajSpline = traj_spline, \
+    .tunePID = pid_tune ## N, \
+    .setClock = setclock, \
+    .advanceClock = vclock_advance, \
+    .slewTo = slew_to ## N, \
+    .planSlew = slew_plan ## N, \
+    .replayState = replay_state ## N, \
+    .setPEC = pec_set ## N, \
+    .getPEC = pec_get ## N, \
+    .savePEC = pec_save ## N, \
+    .initAsync = init_async ## N, \
+    .initState = init_getstate ## N, \
+}
+
+INSTFUNCS(0) INSTFUNCS(1) INSTFUNCS(2) INSTFUNCS(3)
+INSTFUNCS(4) INSTFUNCS(5) INSTFUNCS(6) INSTFUNCS(7)
+
 // init mount class
-mount_t Mount = {
-    .init = init,
-    .quit = quit,
-    .getMountData = getMD,
-    .moveTo = move2,
-    .moveWspeed = move2s,
-    .setSpeed = setspeed,
-    .emergStop = emstop,
-    .stop = stop,
-    .shortCmd = shortcmd,
-    .longCmd = longcmd,
-    .getHWconfig = get_hwconf,
-    .saveHWconfig = write_hwconf,
-    .currentT = curtime,
-    .timeFromStart = timefromstart,
-    .timeDiff = timediff,
-    .timeDiff0 = timediff0,
-    .correctTo = correct2,
-    .getMaxSpeed = maxspeed,
-    .getMinSpeed = minspeed,
-    .getAcceleration = acceleration,
+mount_t Mount = INSTTABLE(0);
+static mount_t Mounts[MCC_MAXMOUNTS] = {
+    [1] = INSTTABLE(1), [2] = INSTTABLE(2), [3] = INSTTABLE(3),
+    [4] = INSTTABLE(4), [5] = INSTTABLE(5), [6] = INSTTABLE(6), [7] = INSTTABLE(7),
 };
 
+/**
+ * @brief mount_open - init one more mount in free slot
+ * @param c - its configuration
+ * @return mount class or NULL if failed
+ */
+mount_t *mount_open(conf_t *c){
+    FNAME();
+    if(!c) return NULL;
+    int N = 1;
+    pthread_mutex_lock(&instmutex);
+    for(; N < MCC_MAXMOUNTS; ++N){
+        if(Instances[N] && Instances[N]->used) continue;
+        if(!Instances[N]) Instances[N] = malloc(sizeof(mntinst_t));
+        if(!Instances[N]) N = MCC_MAXMOUNTS;
+        break;
+    }
+    if(N == MCC_MAXMOUNTS){
+        pthread_mutex_unlock(&instmutex);
+        DBG("No free slots");
+        return NULL;
+    }
+    inst_init(Instances[N], N);
+    Instances[N]->used = 1;
+    pthread_mutex_unlock(&instmutex);
+    mount_t *m = &Mounts[N];
+    if(MCC_E_OK != m->init(c)){
+        DBG("Can't init mount %d", N);
+        mount_close(m);
+        return NULL;
+    }
+    return m;
+}
+
+/**
+ * @brief mount_close - stop mount and free its slot
+ * @param m - mount got by mount_open()
+ */
+void mount_close(mount_t *m){
+    if(!m || m < &Mounts[1] || m >= &Mounts[MCC_MAXMOUNTS]) return;
+    int N = (int)(m - Mounts);
+    if(!Instances[N] || !Instances[N]->used) return;
+    m->quit();
+    mntinst_t *I = Instances[N];
+    inst_destroy(I);
+    pthread_mutex_lock(&instmutex);
+    I->used = 0;
+    pthread_mutex_unlock(&instmutex);
+}
@@ -22,27 +22,101 @@
 
 #pragma once
 
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 
+#include "enchist.h"
+#include "hwconf.h"
 #include "movingmodel.h"
+#include "pec.h"
+#include "PID.h"
+#include "replay.h"
+#include "serial.h"
 #include "sidservo.h"
+#include "slew.h"
+#include "stats.h"
+#include "telelog.h"
+#include "tracking.h"
+
+// adders of long command in model mode: target moves with speed `adder` during adders' time after command
+typedef struct{
+    moveparam_t target;     // coordinate and max speed by command
+    double adder;           // speed of target moving, rad/s
+    double t0, tend;        // time of command and end of adders' time
+    int active;
+} modadder_t;
+
+// asynchronous bring-up of devices by init()/initAsync()
+typedef struct{
+    pthread_t thread;       // bring-up thread
+    int started;            // ==1 if thread should be joined
+    atomic_int abort;       // ==1 to break bring-up by quit()
+    mcc_initstate_t st;
+    mcc_initcb_t cb;
+    void *cbarg;
+    pthread_mutex_t mutex;  // for `st`
+} init_state_t;
+
+/*
+ * All state of one mount: each library thread works with instance of its creator, API functions of `mount_t`
+ * returned by mount_open() switch current instance of calling thread for the time of call.
+ */
+typedef struct mntinst{
+    int id;                 // index of instance (0 - `Mount`)
+    int used;               // ==1 if opened by mount_open()
+    conf_t Conf;
+    // limits for model and/or real mount: radians, rad/sec, rad/sec^2
+    limits_t Xlimits, Ylimits;
+    ssconst_t ss;           // constants from hardware configuration
+    hwconf_state_t hw;      // hardware configuration itself
+    struct timespec timeadder, // adder of CLOCK_REALTIME to CLOCK_MONOTONIC
+        t0,                 // curtime() for initstarttime() call
+        starttime;          // starting time by monotonic (for timefromstart())
+    // model
+    movemodel_t Xmod, Ymod, *Xmodel, *Ymodel;
+    modadder_t Xmadder, Ymadder;
+    pthread_mutex_t madmutex;
+    stats_t Stats;
+    enchist_t hist[2];      // encoders' history
+    serial_state_t ser;
+    pid_state_t pid;
+    track_state_t trk;
+    slew_state_t slew;
+    pec_state_t pec;
+    tlog_state_t tlog;
+    replay_state_t rp;
+    init_state_t ini;
+} mntinst_t;
+
+// instance of current thread
+extern __thread mntinst_t *Inst;
 
-extern conf_t Conf;
-extern limits_t Xlimits, Ylimits;
 int curtime(struct timespec *t);
 double timediff(const struct timespec *time1, const struct timespec *time0);
 double timediff0(const struct timespec *time1);
+void inittime(struct timespec *t);
 double timefromstart();
+void tsshift(struct timespec *t, double dt);
+int period_wait(struct timespec *deadline, double period, hist_t *jitter);
+void sleep_s(double t);
 void getModData(coordpair_t *c, movestate_t *xst, movestate_t *yst);
-typedef struct{
-    double *x, *t, *t2, *xt; // arrays of coord/time and multiply
-    double xsum, tsum, t2sum, xtsum; // sums of coord/time and their multiply
+mcc_errcodes_t move2s(const coordpair_t *target, const coordpair_t *speed);
+mcc_errcodes_t longcmd(long_command_t *cmd);
+// sliding less squares; all sums are relative to reference point (x0, t0) to prevent precision loss
+typedef struct less_square{
+    double *x, *t; // ring arrays of coordinates and times
+    double x0, t0; // reference point (renewed on each recalculation)
+    double xsum, tsum, t2sum, xtsum; // sums of relative coord/time and their multiply
     size_t idx; // index of current data in array
+    size_t ndata; // amount of data in arrays (<= arraysz)
+    size_t nadded; // amount of data added since last recalculation
     size_t arraysz; // size of arrays
 } less_square_t;
 
 less_square_t *LS_init(size_t Ndata);
 void LS_delete(less_square_t **ls);
+void LS_recalc(less_square_t *l);
 double LS_calc_slope(less_square_t *l, double x, double t);
 
 // unused arguments of functions
@@ -25,8 +25,6 @@
 #include "movingmodel.h"
 #include "ramp.h"
 
-extern movemodel_t trapez;
-
 static void chkminmax(double *min, double *max){
     if(*min <= *max) return;
     double t = *min;
@@ -34,14 +32,20 @@ static void chkminmax(double *min, double *max){
     *max = t;
 }
 
-movemodel_t *model_init(limits_t *l){
-    if(!l) return FALSE;
-    movemodel_t *m = calloc(1, sizeof(movemodel_t));
-    // we can't use memcpy or assign as Times/Params would be common for all
-    *m = trapez;
-    m->Times = calloc(STAGE_AMOUNT, sizeof(double));
-    m->Params = calloc(STAGE_AMOUNT, sizeof(moveparam_t));
-    moveparam_t *max = &l->max, *min = &l->min;
+/**
+ * @brief model_init - init model in given memory (no allocations)
+ * @param m - model
+ * @param type - type of ramp
+ * @param l - limits
+ * @return FALSE if failed
+ */
+int model_init(movemodel_t *m, ramptype_t type, const limits_t *l){
+    if(!m || !l || type < RAMP_DUMB || type >= RAMP_AMOUNT) return FALSE;
+    *m = rampmodel;
+    m->type = type;
+    m->Min = l->min;
+    m->Max = l->max;
+    moveparam_t *max = &m->Max, *min = &m->Min;
     if(min->speed < 0.) min->speed = -min->speed;
     if(max->speed < 0.) max->speed = -max->speed;
     if(min->accel < 0.) min->accel = -min->accel;
@@ -49,13 +53,17 @@ movemodel_t *model_init(limits_t *l){
     chkminmax(&min->coord, &max->coord);
     chkminmax(&min->speed, &max->speed);
     chkminmax(&min->accel, &max->accel);
-    m->Min = l->min;
-    m->Max = l->max;
-    m->movingstage = STAGE_STOPPED;
+    m->jerk = fabs(l->jerk);
+    if(m->jerk == 0.) m->jerk = max->accel / RAMP_JERK_TIME;
     m->state = ST_STOP;
     pthread_mutex_init(&m->mutex, NULL);
     DBG("model inited");
-    return m;
+    return TRUE;
+}
+
+void model_free(movemodel_t *m){
+    if(!m) return;
+    pthread_mutex_destroy(&m->mutex);
 }
 
 int model_move2(movemodel_t *model, moveparam_t *target, double t){
@@ -29,6 +29,13 @@
 #define TIME_TICK_MIN           (1e-9)
 #define TIME_TICK_MAX           (10.)
 
+typedef enum{
+    RAMP_DUMB,          // no ramp: infinite acceleration/deceleration
+    RAMP_TRAPEZIUM,     // trapezium ramp: limited acceleration
+    RAMP_S,             // s-shaped ramp: limited acceleration and jerk
+    RAMP_AMOUNT
+} ramptype_t;
+
 typedef enum{
     ST_STOP,            // stopped
     ST_MOVE,            // moving
@@ -44,33 +51,44 @@ typedef struct{
 typedef struct{
     moveparam_t min;
     moveparam_t max;
-    //double acceleration;
+    double jerk;        // max jerk for s-shaped ramp (0 - reach max acceleration for RAMP_JERK_TIME)
 } limits_t;
 
-typedef enum{
-    STAGE_ACCEL,        // start from last speed and accelerate/decelerate to target speed
-    STAGE_MAXSPEED,     // go with target speed
-    STAGE_DECEL,        // go from target speed to zero
-    STAGE_STOPPED,      // stop
-    STAGE_AMOUNT
-} movingstage_t;
+// time to reach max acceleration if jerk isn't set, s
+#define RAMP_JERK_TIME  (0.2)
+// max amount of trajectory segments: change speed (3), go with constant speed (1), stop (3) and stopped (1)
+#define RAMP_MAXSEG     (8)
 
+// segment of trajectory: x = x0 + v0*dt + a0*dt^2/2 + j*dt^3/6, dt = t - t0
+typedef struct{
+    double t0;
+    double x0;
+    double v0;
+    double a0;
+    double j;
+} rampseg_t;
+
+// model state: all in one structure without allocations; last segment of moving is stopped state
 typedef struct movemodel{
+    movestate_t state;
+    ramptype_t type;
+    int nseg;                                 // amount of segments
+    int curseg;                               // current segment
+    moveparam_t curparams;                    // current coordinate/speed/acceleration
+    rampseg_t seg[RAMP_MAXSEG];
     moveparam_t Min;
     moveparam_t Max;
-    movingstage_t movingstage;
-    movestate_t state;
-    double *Times;
-    moveparam_t *Params;
-    moveparam_t curparams;                    // init values of limits, jerk
+    double jerk;
     int (*calculate)(struct movemodel *m, moveparam_t *target, double t);        // calculate stages of traectory beginning from t
     movestate_t (*proc_move)(struct movemodel *m, moveparam_t *next, double t);  // calculate next model point for time t
     movestate_t (*get_state)(struct movemodel *m, moveparam_t *cur);             // get current moving state
     void (*stop)(struct movemodel *m, double t);                                 // stop by ramp
     void (*emergency_stop)(struct movemodel *m, double t);                       // stop with highest acceleration
     double (*stoppedtime)(struct movemodel *m);                                  // time when moving will ends
+    size_t (*eval)(struct movemodel *m, const double *t, size_t n, moveparam_t *out); // model points for times `t`
     pthread_mutex_t mutex;
 } movemodel_t;
 
-movemodel_t *model_init(limits_t *l);
+int model_init(movemodel_t *m, ramptype_t type, const limits_t *l);
+void model_free(movemodel_t *m);
 int model_move2(movemodel_t *model, moveparam_t *target, double t);
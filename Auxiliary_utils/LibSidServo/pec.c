@@ -0,0 +1,310 @@
+/*
+ * This file is part of the libsidservo project.
+ * Copyright 2026 Edward V. Emelianov <edward.emelianoff@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Periodic error correction: worm turns once per 2pi/teeth of axis, so error of axis (by axis encoder) relatively
+ * to motor (by motor's encoder) repeats with worm phase. Residuals of each status reading are averaged in bins
+ * by phase (after subtraction of slow baseline), tracking engine subtracts learned error from motors' targets,
+ * so correction works as feed-forward of position and speed (adders).
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "main.h"
+#include "pec.h"
+
+#define RAD2ASEC    (180. * 3600. / M_PI)
+
+static const char axname[2] = {'X', 'Y'};
+
+// clear learned table
+static void axclear(pecaxis_t *a){
+    memset(a->tab, 0, sizeof(a->tab));
+    memset(a->n, 0, sizeof(a->n));
+    a->sum = 0.;
+    a->ncovered = 0;
+    a->base = 0.;
+    a->phprev = NAN;
+    a->tmot = (struct timespec){0};
+    a->nsamples = 0;
+}
+
+// worm phase [0, 1) by motor's position
+static double wormphase(const pecaxis_t *a, double mot){
+    double ph = mot * a->teeth / (2. * M_PI);
+    return ph - floor(ph);
+}
+
+// learned error (zero mean) at given phase: linear interpolation between centers of bins
+static double pecval(const pecaxis_t *a, double ph){
+    double x = ph * a->nbins - 0.5, fl = floor(x), f = x - fl;
+    int i0 = (int)fl, i1 = i0 + 1;
+    if(i0 < 0) i0 += a->nbins;
+    if(i1 >= a->nbins) i1 -= a->nbins;
+    return a->tab[i0] + (a->tab[i1] - a->tab[i0]) * f - a->sum / a->nbins;
+}
+
+/**
+ * @brief learnaxis - add sample of one axis
+ * @param a - axis
+ * @param mot - motor's position
+ * @param enc - axis position
+ * @param speed - axis speed
+ * @return TRUE if sample added
+ */
+static int learnaxis(pecaxis_t *a, const coordval_t *mot, const coordval_t *enc, double speed){
+    if(!a->teeth || mot->t.tv_sec == 0 || enc->t.tv_sec == 0) return FALSE;
+    if(mot->t.tv_sec == a->tmot.tv_sec && mot->t.tv_nsec == a->tmot.tv_nsec) return FALSE; // the same status
+    a->tmot = mot->t;
+    double ph = a->phase = wormphase(a, mot->val);
+    if(fabs(speed) < PEC_LEARN_MINSPEED || fabs(speed) > PEC_LEARN_MAXSPEED){
+        a->phprev = NAN;
+        return FALSE;
+    }
+    // axis position at time of motor's measurement
+    double r = enc->val + speed * timediff(&mot->t, &enc->t) - mot->val;
+    double dph = 0.;
+    if(isnan(a->phprev) || fabs(r - a->base - pecval(a, ph)) > PEC_MAXERR){ // (re)start: baseline by learned table
+        a->base = r - pecval(a, ph);
+    }else{
+        dph = fabs(ph - a->phprev);
+        if(dph > 0.5) dph = 1. - dph;
+    }
+    a->phprev = ph;
+    double k = dph / PEC_BASE_PERIODS;
+    a->base += (r - a->base) * (k > 1. ? 1. : k);
+    int i = (int)(ph * a->nbins);
+    if(i >= a->nbins) i = a->nbins - 1;
+    if(a->n[i] < PEC_BIN_MAXN && ++a->n[i] == PEC_BIN_MINN) ++a->ncovered;
+    double d = (r - a->base - a->tab[i]) / a->n[i];
+    a->tab[i] += d;
+    a->sum += d;
+    ++a->nsamples;
+    return TRUE;
+}
+
+/**
+ * @brief pec_learn - learn periodic error by fresh mount data (new motors' positions only)
+ * @param m - mount data
+ */
+void pec_learn(const mountdata_t *m){
+    pec_state_t *P = &Inst->pec;
+    pthread_mutex_lock(&P->mutex);
+    if(P->learn){
+        if(learnaxis(&P->ax[0], &m->motXposition, &m->encXposition, m->encXspeed.val)) P->dirty = 1;
+        if(learnaxis(&P->ax[1], &m->motYposition, &m->encYposition, m->encYspeed.val)) P->dirty = 1;
+    }else{
+        if(P->ax[0].teeth) P->ax[0].phase = wormphase(&P->ax[0], m->motXposition.val);
+        if(P->ax[1].teeth) P->ax[1].phase = wormphase(&P->ax[1], m->motYposition.val);
+    }
+    pthread_mutex_unlock(&P->mutex);
+}
+
+/**
+ * @brief pec_corr - periodic error of axis relatively to motor (motor should be moved by minus this value)
+ * @param axis - 0 for X, 1 for Y
+ * @param mot - motor's position, rad
+ * @return error, rad (0 if correction is off or table isn't ready)
+ */
+double pec_corr(int axis, double mot){
+    pec_state_t *P = &Inst->pec;
+    double e = 0.;
+    pthread_mutex_lock(&P->mutex);
+    const pecaxis_t *a = &P->ax[axis];
+    if(P->apply && a->teeth && a->ncovered == a->nbins) e = pecval(a, wormphase(a, mot));
+    pthread_mutex_unlock(&P->mutex);
+    return e;
+}
+
+/**
+ * @brief pecload - load learned tables (axes with other teeth/bins than in configuration are ignored)
+ * @param path - file name
+ * @return FALSE if can't read file
+ */
+static int pecload(const char *path){
+    FILE *f = fopen(path, "r");
+    if(!f){
+        DBG("Can't open %s", path);
+        return FALSE;
+    }
+    char line[256], name;
+    int teeth, nbins;
+    pecaxis_t *a = NULL;
+    int idx = 0;
+    while(fgets(line, sizeof(line), f)){
+        if(*line == '#' || *line == '\n') continue;
+        if(3 == sscanf(line, "%c %d %d", &name, &teeth, &nbins) && (name == 'X' || name == 'Y')){
+            a = &Inst->pec.ax[name == 'Y'];
+            if(!a->teeth || a->teeth != teeth || a->nbins != nbins){
+                DBG("Table of %c axis doesn't match configuration", name);
+                a = NULL;
+            }else axclear(a);
+            idx = 0;
+            continue;
+        }
+        double val;
+        unsigned n;
+        if(!a || idx >= a->nbins || 2 != sscanf(line, "%lf %u", &val, &n)) continue;
+        a->tab[idx] = val / RAD2ASEC;
+        a->sum += a->tab[idx];
+        a->n[idx] = (n > PEC_BIN_MAXN) ? PEC_BIN_MAXN : n;
+        if(a->n[idx] >= PEC_BIN_MINN) ++a->ncovered;
+        a->nsamples += n;
+        ++idx;
+    }
+    fclose(f);
+    return TRUE;
+}
+
+/**
+ * @brief pec_init - set tables by configuration and load learned ones (called by init())
+ * @return FALSE if configuration is wrong
+ */
+int pec_init(){
+    pec_state_t *P = &Inst->pec;
+    int teeth[2] = {Inst->Conf.XWormTeeth, Inst->Conf.YWormTeeth}, nbins = Inst->Conf.PECBins;
+    if(nbins == 0) nbins = PEC_DEFBINS;
+    if(teeth[0] < 0 || teeth[1] < 0 || nbins < PEC_MINBINS || nbins > MCC_PEC_MAXBINS){
+        DBG("Wrong PEC parameters");
+        return FALSE;
+    }
+    pthread_mutex_lock(&P->mutex);
+    for(int i = 0; i < 2; ++i){
+        pecaxis_t *a = &P->ax[i];
+        if(a->teeth != teeth[i] || a->nbins != nbins){
+            a->teeth = teeth[i];
+            a->nbins = nbins;
+            axclear(a);
+        }
+        a->phprev = NAN;
+    }
+    P->dirty = 0;
+    P->apply = 1;
+    if(Inst->Conf.PECPath && (teeth[0] || teeth[1])) pecload(Inst->Conf.PECPath);
+    pthread_mutex_unlock(&P->mutex);
+    return TRUE;
+}
+
+// save tables; @return FALSE if failed
+static int pecsave(const char *path){
+    char tmp[4096];
+    if(snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)) return FALSE;
+    FILE *f = fopen(tmp, "w");
+    if(!f){
+        DBG("Can't open %s", tmp);
+        return FALSE;
+    }
+    fprintf(f, "# periodic error (axis - motor) by worm phase\n# axis teeth bins, then error of bins ('') and amount of samples\n");
+    for(int i = 0; i < 2; ++i){
+        const pecaxis_t *a = &Inst->pec.ax[i];
+        if(!a->teeth) continue;
+        fprintf(f, "%c %d %d\n", axname[i], a->teeth, a->nbins);
+        for(int b = 0; b < a->nbins; ++b) fprintf(f, "%.5f %u\n", a->tab[b] * RAD2ASEC, a->n[b]);
+    }
+    int ok = (0 == fclose(f));
+    if(ok && rename(tmp, path)) ok = FALSE;
+    if(!ok){DBG("Can't save %s", path);}
+    return ok;
+}
+
+/**
+ * @brief pec_save - save learned tables
+ * @param path - file name (NULL - Conf.PECPath)
+ * @return errcode
+ */
+mcc_errcodes_t pec_save(const char *path){
+    if(!path) path = Inst->Conf.PECPath;
+    if(!path) return MCC_E_BADFORMAT;
+    pec_state_t *P = &Inst->pec;
+    if(!P->ax[0].teeth && !P->ax[1].teeth) return MCC_E_FAILED;
+    pthread_mutex_lock(&P->mutex);
+    int ok = pecsave(path);
+    if(ok && path == Inst->Conf.PECPath) P->dirty = 0;
+    pthread_mutex_unlock(&P->mutex);
+    return ok ? MCC_E_OK : MCC_E_FAILED;
+}
+
+// save learned tables on quit()
+void pec_close(){
+    pec_state_t *P = &Inst->pec;
+    if(P->dirty && Inst->Conf.PECPath) pec_save(NULL);
+    pthread_mutex_lock(&P->mutex);
+    P->learn = 0;
+    pthread_mutex_unlock(&P->mutex);
+}
+
+/**
+ * @brief pec_set - set modes of PEC
+ * @param m - modes
+ * @return errcode
+ */
+mcc_errcodes_t pec_set(const mcc_pecmode_t *m){
+    if(!m) return MCC_E_BADFORMAT;
+    pec_state_t *P = &Inst->pec;
+    if(!P->ax[0].teeth && !P->ax[1].teeth) return MCC_E_FAILED; // no worms in configuration
+    pthread_mutex_lock(&P->mutex);
+    if(m->reset){
+        axclear(&P->ax[0]);
+        axclear(&P->ax[1]);
+        P->dirty = 1;
+    }
+    if(m->learn && !P->learn){ // start with new baseline
+        P->ax[0].phprev = P->ax[1].phprev = NAN;
+    }
+    P->learn = m->learn;
+    P->apply = m->apply;
+    pthread_mutex_unlock(&P->mutex);
+    return MCC_E_OK;
+}
+
+// fill state of axis
+static void axget(const pecaxis_t *a, mcc_pecaxis_t *s){
+    s->teeth = a->teeth;
+    s->nbins = a->nbins;
+    s->phase = a->phase;
+    s->nsamples = a->nsamples;
+    s->coverage = a->nbins ? (double)a->ncovered / a->nbins : 0.;
+    double mean = a->nbins ? a->sum / a->nbins : 0., mn = 0., mx = 0., s2 = 0.;
+    for(int i = 0; i < a->nbins; ++i){
+        double v = s->table[i] = a->tab[i] - mean;
+        if(v < mn) mn = v;
+        if(v > mx) mx = v;
+        s2 += v * v;
+    }
+    s->ptp = mx - mn;
+    s->rms = a->nbins ? sqrt(s2 / a->nbins) : 0.;
+}
+
+/**
+ * @brief pec_get - get state of PEC and learned tables
+ * @param s (o) - state
+ * @return errcode
+ */
+mcc_errcodes_t pec_get(mcc_pec_t *s){
+    if(!s) return MCC_E_BADFORMAT;
+    pec_state_t *P = &Inst->pec;
+    pthread_mutex_lock(&P->mutex);
+    s->learn = P->learn;
+    s->apply = P->apply;
+    axget(&P->ax[0], &s->X);
+    axget(&P->ax[1], &s->Y);
+    pthread_mutex_unlock(&P->mutex);
+    return MCC_E_OK;
+}
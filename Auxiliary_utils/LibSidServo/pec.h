@@ -0,0 +1,71 @@
+/*
+ * This file is part of the libsidservo project.
+ * Copyright 2026 Edward V. Emelianov <edward.emelianoff@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <pthread.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "sidservo.h"
+
+// default amount of bins by worm phase
+#define PEC_DEFBINS         (128)
+// min amount of bins
+#define PEC_MINBINS         (8)
+// samples are learned only while axis speed is in this range, rad/s (phase should change, but slowly)
+#define PEC_LEARN_MINSPEED  (1e-6)
+#define PEC_LEARN_MAXSPEED  (5e-3)
+// samples with larger error (slip of motor, resync of its position) restart learning, rad (~200'')
+#define PEC_MAXERR          (1e-3)
+// weight of new sample in bin is 1/min(n, PEC_BIN_MAXN), so old data is forgotten after ~PEC_BIN_MAXN samples
+#define PEC_BIN_MAXN        (100)
+// bin is used for correction after this amount of samples
+#define PEC_BIN_MINN        (3)
+// baseline (slow offset between motor and axis) is filtered by this amount of worm periods
+#define PEC_BASE_PERIODS    (4.)
+
+// periodic error of one axis
+typedef struct{
+    int teeth;                      // teeth of worm wheel (0 - no PEC)
+    int nbins;                      // amount of bins
+    double tab[MCC_PEC_MAXBINS];    // mean error (axis - motor - baseline) in bins, rad
+    uint32_t n[MCC_PEC_MAXBINS];    // amount of samples in bins (saturated at PEC_BIN_MAXN)
+    double sum;                     // sum of `tab` (for zero mean)
+    int ncovered;                   // amount of bins with n >= PEC_BIN_MINN
+    double base;                    // baseline
+    double phprev;                  // worm phase of previous sample (NAN - start learning again)
+    double phase;                   // worm phase of last motor's position
+    struct timespec tmot;           // time of last motor's position learned
+    uint64_t nsamples;              // samples learned
+} pecaxis_t;
+
+typedef struct{
+    pecaxis_t ax[2];
+    int learn, apply;               // modes
+    int dirty;                      // ==1 if tables changed since loading/saving
+    pthread_mutex_t mutex;
+} pec_state_t;
+
+int pec_init();
+void pec_close();
+void pec_learn(const mountdata_t *m);
+double pec_corr(int axis, double mot);
+mcc_errcodes_t pec_set(const mcc_pecmode_t *m);
+mcc_errcodes_t pec_get(mcc_pec_t *s);
+mcc_errcodes_t pec_save(const char *path);
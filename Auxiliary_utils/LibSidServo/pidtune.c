@@ -0,0 +1,461 @@
+/*
+ * This file is part of the libsidservo project.
+ * Copyright 2026 Edward V. Emelianov <edward.emelianoff@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Offline PID tuning: PID of one axis drives its own instance of trapezoid model (the same as used in model mode)
+ * by virtual time, so simulation runs much faster than real time and doesn't touch the mount. Gains are searched
+ * by grid over [min, max] and then refined by Nelder-Mead from the best grid points; simulations are distributed
+ * over threads, each thread has its own models and PIDs. Results don't depend on amount of threads.
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "main.h"
+#include "movingmodel.h"
+#include "PID.h"
+#include "pidtune.h"
+
+// built-in trajectories: X and Y are the same
+static int tr_sidereal(double t, coordpair_t *pos, void _U_ *arg){
+    pos->X = pos->Y = 0.1 + 7.2921159e-5 * t;
+    return TRUE;
+}
+// sine with amplitude 1 degree and period of 1 minute
+static int tr_sine(double t, coordpair_t *pos, void _U_ *arg){
+    pos->X = pos->Y = 0.1 + 0.017453293 * sin(2. * M_PI * t / 60.);
+    return TRUE;
+}
+// satellite-like pass with max speed of 0.86 degr/s at 60th second
+static int tr_satellite(double t, coordpair_t *pos, void _U_ *arg){
+    pos->X = pos->Y = 0.3 * atan((t - 60.) / 20.);
+    return TRUE;
+}
+static const mcc_traject_t builtin[] = {tr_sidereal, tr_sine, tr_satellite};
+
+// resolved parameters of tuning
+typedef struct{
+    mcc_pidtune_t par;      // with defaults instead of zeros
+    limits_t lim;           // limits of axis
+    double corrdt;          // interval of PID corrections
+    double maxpointing;     // thresholds of axis states
+    double finepointing;
+    size_t Iarrsz;          // size of PID integral array
+    size_t nlat;            // latency in `dt` steps
+    int ndim;               // amount of free gains
+    int dim[3];             // their indexes
+} tune_t;
+
+// simulation results
+typedef struct{
+    double rms;
+    double peak;
+    double settle;
+} simres_t;
+
+// per-thread simulation context
+typedef struct{
+    const tune_t *tune;
+    double *ring;           // measured positions (latency buffer)
+    double *tagring;        // target positions at the same times
+    atomic_size_t *nsim;    // common simulations' counter
+} simctx_t;
+
+// gains by index: 0 - P, 1 - I, 2 - D
+static inline double *gainptr(PIDpar_t *g, int idx){
+    return (idx == 0) ? &g->P : ((idx == 1) ? &g->I : &g->D);
+}
+static inline double gainval(const PIDpar_t *g, int idx){
+    return (idx == 0) ? g->P : ((idx == 1) ? g->I : g->D);
+}
+
+// gaussian noise by Box-Muller
+static double gauss(unsigned short xsubi[3]){
+    double u1 = erand48(xsubi), u2 = erand48(xsubi);
+    if(u1 < 1e-300) u1 = 1e-300;
+    return sqrt(-2. * log(u1)) * cos(2. * M_PI * u2);
+}
+
+// target position of trajectory `n` for current axis
+static int tagpos(const tune_t *tn, size_t n, double t, double *pos){
+    coordpair_t p;
+    if(!tn->par.traject[n](t, &p, tn->par.args ? tn->par.args[n] : NULL)) return FALSE;
+    *pos = tn->par.axis ? p.Y : p.X;
+    return TRUE;
+}
+
+// target speed for feed-forward: at the middle of interval till next correction (like in correctToFF())
+static double ffspeed(const tune_t *tn, size_t n, double t){
+    double t1, t2, tm = t + tn->corrdt / 2.;
+    if(!tagpos(tn, n, tm - 0.01, &t1) || !tagpos(tn, n, tm + 0.01, &t2)) return 0.;
+    return (t2 - t1) / 0.02;
+}
+
+// the same as moveWspeed() of model
+static int modelmove(movemodel_t *m, const tune_t *tn, double pos, double speed, double t){
+    moveparam_t p = {.coord = pid_endpoint(pos, speed), .speed = fabs(speed)};
+    if(p.coord < tn->lim.min.coord) p.coord = tn->lim.min.coord;
+    else if(p.coord > tn->lim.max.coord) p.coord = tn->lim.max.coord;
+    if(p.speed > tn->lim.max.speed) p.speed = tn->lim.max.speed;
+    return model_move2(m, &p, t);
+}
+
+/**
+ * @brief simulate - track trajectory `n` by PID with gains `g`
+ * @param ctx - thread context
+ * @param g - gains
+ * @param n - index of trajectory
+ * @param seed - seed of noise generator
+ * @param r (o) - results (sum of errors' squares in `rms`, amount of samples in `settle`)
+ * @param settle (o) - settling time
+ * @return FALSE if simulation failed
+ */
+static int simulate(simctx_t *ctx, const PIDpar_t *g, size_t n, unsigned short seed[3], simres_t *r, double *settle){
+    const tune_t *tn = ctx->tune;
+    const mcc_pidtune_t *p = &tn->par;
+    movemodel_t model, *m = &model;
+    if(!model_init(m, RAMP_TRAPEZIUM, &tn->lim)) return FALSE;
+    PIDController_t *pid = pid_create(g, tn->Iarrsz);
+    int ret = FALSE;
+    if(!pid) goto ret;
+    double x0;
+    if(!tagpos(tn, n, 0., &x0)) goto ret;
+    m->curparams.coord = x0 + p->offset;
+    size_t rsz = tn->nlat + 1, N = 0;
+    double tcorr = 0., tlast = 0., sum2 = 0., peak = 0., vmax = tn->lim.max.speed;
+    int slewing = 1;
+    for(size_t i = 0; ; ++i){
+        double t = (double)i * p->dt, tag;
+        if(t > p->duration) break;
+        moveparam_t cur;
+        if(ST_MOVE == m->get_state(m, &cur)) m->proc_move(m, &cur, t);
+        if(!tagpos(tn, n, t, &tag)) break;
+        double err = tag - cur.coord, fe = fabs(err);
+        if(t >= p->skip){
+            sum2 += err * err;
+            if(fe > peak) peak = fe;
+            ++N;
+        }
+        if(fe > p->tolerance) tlast = t + p->dt;
+        ctx->ring[i % rsz] = cur.coord + ((p->noise > 0.) ? p->noise * gauss(seed) : 0.);
+        ctx->tagring[i % rsz] = tag;
+        if(t + p->dt / 2. < tcorr) continue;
+        tcorr += tn->corrdt;
+        // data measured `latency` ago
+        size_t idx = (i >= tn->nlat) ? (i - tn->nlat) % rsz : 0;
+        double mpos = ctx->ring[idx], mtag = ctx->tagring[idx], merr = mtag - mpos, speed;
+        // axis states like in correctTo()
+        if(slewing && fabs(merr) < tn->finepointing){
+            slewing = 0;
+            pid_clear(pid);
+            pid->prev_tagpos = mtag;
+            speed = p->feedforward ? ffspeed(tn, n, t) : 0.;
+        }else{
+            if(!slewing && fabs(merr) > tn->maxpointing) slewing = 1;
+            if(slewing) speed = (merr < 0.) ? -vmax : vmax;
+            else{
+                double tagspeed = p->feedforward ? ffspeed(tn, n, t) : (mtag - pid->prev_tagpos) / tn->corrdt;
+                pid->prev_tagpos = mtag;
+                speed = pid_step(pid, merr, tn->corrdt, tagspeed, vmax);
+            }
+        }
+        if(!modelmove(m, tn, cur.coord, speed, t)) goto ret;
+    }
+    r->rms += sum2;
+    r->settle += (double)N;
+    if(peak > r->peak) r->peak = peak;
+    if(tlast > *settle) *settle = tlast;
+    ret = TRUE;
+ret:
+    atomic_fetch_add(ctx->nsim, 1);
+    pid_delete(&pid);
+    model_free(m);
+    return ret;
+}
+
+/**
+ * @brief evaluate - run simulations by all trajectories for given gains
+ * @param ctx - thread context
+ * @param g - gains
+ * @param r (o) - results
+ * @return cost (RMS error) or INFINITY if simulation failed
+ */
+static double evaluate(simctx_t *ctx, const PIDpar_t *g, simres_t *r){
+    const mcc_pidtune_t *p = &ctx->tune->par;
+    simres_t s = {0};
+    double settle = 0.;
+    for(size_t n = 0; n < p->ntraject; ++n){
+        // the same noise for all gains
+        unsigned short seed[3] = {p->seed, (unsigned short)n, 0x330e};
+        if(!simulate(ctx, g, n, seed, &s, &settle)){
+            r->rms = r->peak = r->settle = INFINITY;
+            return INFINITY;
+        }
+    }
+    r->rms = (s.settle > 0.) ? sqrt(s.rms / s.settle) : INFINITY;
+    r->peak = s.peak;
+    r->settle = settle;
+    return r->rms;
+}
+
+static int ctx_init(simctx_t *ctx, const tune_t *tn, atomic_size_t *nsim){
+    ctx->tune = tn;
+    ctx->nsim = nsim;
+    ctx->ring = calloc(tn->nlat + 1, sizeof(double));
+    ctx->tagring = calloc(tn->nlat + 1, sizeof(double));
+    return (ctx->ring && ctx->tagring);
+}
+static void ctx_free(simctx_t *ctx){
+    free(ctx->ring);
+    free(ctx->tagring);
+}
+
+// common data of worker threads
+typedef struct{
+    const tune_t *tune;
+    atomic_size_t nsim;     // amount of simulations
+    atomic_size_t next;     // next job
+    size_t njobs;           // amount of jobs
+    PIDpar_t *gains;        // gains of jobs (start points for Nelder-Mead)
+    double *cost;           // costs of jobs
+    simres_t *res;          // results of jobs
+    int NM;                 // ==1 for Nelder-Mead, 0 for grid
+} jobs_t;
+
+// normalized coordinates [0, 1] of free gains <-> gains
+static void u2gain(const tune_t *tn, const double *u, PIDpar_t *g){
+    for(int i = 0; i < tn->ndim; ++i){
+        int d = tn->dim[i];
+        double x = u[i];
+        if(x < 0.) x = 0.;
+        else if(x > 1.) x = 1.;
+        double mn = gainval(&tn->par.min, d), mx = gainval(&tn->par.max, d);
+        *gainptr(g, d) = mn + x * (mx - mn);
+    }
+}
+static void gain2u(const tune_t *tn, const PIDpar_t *g, double *u){
+    for(int i = 0; i < tn->ndim; ++i){
+        int d = tn->dim[i];
+        double mn = gainval(&tn->par.min, d), mx = gainval(&tn->par.max, d);
+        u[i] = (gainval(g, d) - mn) / (mx - mn);
+    }
+}
+
+/**
+ * @brief neldermead - refine gains by Nelder-Mead simplex method in normalized coordinates
+ * @param ctx - thread context
+ * @param g (io) - start point / result
+ * @param r (io) - its results / results for best point
+ * @return cost of best point
+ */
+static double neldermead(simctx_t *ctx, PIDpar_t *g, simres_t *r){
+    const tune_t *tn = ctx->tune;
+    int D = tn->ndim, NP = D + 1;
+    if(D == 0) return r->rms;
+    double step = (tn->par.gridN > 1) ? 0.5 / (double)(tn->par.gridN - 1) : 0.25;
+    double u[4][3], f[4], c[3], xr[3], xe[3];
+    simres_t res[4], rr, re;
+    PIDpar_t gg = *g;
+    gain2u(tn, g, u[0]);
+    f[0] = r->rms; res[0] = *r;
+    for(int i = 1; i < NP; ++i){
+        memcpy(u[i], u[0], sizeof(u[0]));
+        u[i][i-1] += (u[0][i-1] + step > 1.) ? -step : step;
+        u2gain(tn, u[i], &gg);
+        f[i] = evaluate(ctx, &gg, &res[i]);
+    }
+    for(int iter = 0; iter < tn->par.NMiter; ++iter){
+        // sort points by cost (insertion)
+        for(int i = 1; i < NP; ++i){
+            for(int j = i; j > 0 && f[j] < f[j-1]; --j){
+                double tf = f[j]; f[j] = f[j-1]; f[j-1] = tf;
+                simres_t ts = res[j]; res[j] = res[j-1]; res[j-1] = ts;
+                double tu[3]; memcpy(tu, u[j], sizeof(tu)); memcpy(u[j], u[j-1], sizeof(tu)); memcpy(u[j-1], tu, sizeof(tu));
+            }
+        }
+        if(isfinite(f[D]) && f[D] - f[0] <= 1e-4 * f[0]) break;
+        // centroid of all but worst
+        for(int k = 0; k < D; ++k){
+            c[k] = 0.;
+            for(int i = 0; i < D; ++i) c[k] += u[i][k];
+            c[k] /= (double)D;
+        }
+        // reflection
+        for(int k = 0; k < D; ++k) xr[k] = c[k] + (c[k] - u[D][k]);
+        u2gain(tn, xr, &gg);
+        double fr = evaluate(ctx, &gg, &rr);
+        if(fr < f[0]){ // expansion
+            for(int k = 0; k < D; ++k) xe[k] = c[k] + 2. * (c[k] - u[D][k]);
+            u2gain(tn, xe, &gg);
+            double fe = evaluate(ctx, &gg, &re);
+            if(fe < fr){
+                memcpy(u[D], xe, sizeof(xe)); f[D] = fe; res[D] = re;
+            }else{
+                memcpy(u[D], xr, sizeof(xr)); f[D] = fr; res[D] = rr;
+            }
+        }else if(fr < f[D-1]){
+            memcpy(u[D], xr, sizeof(xr)); f[D] = fr; res[D] = rr;
+        }else{ // contraction
+            int outside = (fr < f[D]);
+            for(int k = 0; k < D; ++k) xe[k] = outside ? c[k] + 0.5 * (xr[k] - c[k]) : c[k] + 0.5 * (u[D][k] - c[k]);
+            u2gain(tn, xe, &gg);
+            double fc = evaluate(ctx, &gg, &re);
+            if(fc < (outside ? fr : f[D])){
+                memcpy(u[D], xe, sizeof(xe)); f[D] = fc; res[D] = re;
+            }else{ // shrink to best point
+                for(int i = 1; i < NP; ++i){
+                    for(int k = 0; k < D; ++k) u[i][k] = u[0][k] + 0.5 * (u[i][k] - u[0][k]);
+                    u2gain(tn, u[i], &gg);
+                    f[i] = evaluate(ctx, &gg, &res[i]);
+                }
+            }
+        }
+    }
+    int best = 0;
+    for(int i = 1; i < NP; ++i) if(f[i] < f[best]) best = i;
+    u2gain(tn, u[best], g);
+    *r = res[best];
+    return f[best];
+}
+
+static void *worker(void *arg){
+    jobs_t *j = (jobs_t*)arg;
+    simctx_t ctx;
+    if(ctx_init(&ctx, j->tune, &j->nsim)){
+        size_t n;
+        while((n = atomic_fetch_add(&j->next, 1)) < j->njobs){
+            if(j->NM) j->cost[n] = neldermead(&ctx, &j->gains[n], &j->res[n]);
+            else j->cost[n] = evaluate(&ctx, &j->gains[n], &j->res[n]);
+        }
+    }
+    ctx_free(&ctx);
+    return NULL;
+}
+
+// run all jobs in `nthreads` threads
+static int runjobs(jobs_t *j, int nthreads){
+    pthread_t threads[nthreads];
+    int nstarted = 0;
+    atomic_store(&j->next, 0);
+    for(; nstarted < nthreads; ++nstarted)
+        if(pthread_create(&threads[nstarted], NULL, worker, j)) break;
+    if(nstarted == 0) worker(j);
+    for(int i = 0; i < nstarted; ++i) pthread_join(threads[i], NULL);
+    return (atomic_load(&j->next) >= j->njobs);
+}
+
+/**
+ * @brief pid_tune - offline search of PID gains by model
+ * @param par - parameters
+ * @param res (o) - best gains and their errors
+ * @return error code
+ */
+mcc_errcodes_t pid_tune(const mcc_pidtune_t *par, mcc_pidtune_res_t *res){
+    if(!par || !res || par->axis < 0 || par->axis > 1) return MCC_E_BADFORMAT;
+    if(Inst->Conf.PIDRefreshDt <= 0. || Inst->Conf.PIDCycleDt <= 0.) return MCC_E_BADFORMAT; // no configuration
+    tune_t tn = {.par = *par};
+    mcc_pidtune_t *p = &tn.par;
+    if(!p->traject){
+        p->traject = builtin;
+        p->args = NULL;
+        p->ntraject = sizeof(builtin) / sizeof(builtin[0]);
+    }
+    if(p->ntraject == 0) return MCC_E_BADFORMAT;
+    if(p->duration <= 0.) p->duration = PIDTUNE_DURATION;
+    if(p->skip <= 0.) p->skip = PIDTUNE_SKIP;
+    if(p->dt <= 0.) p->dt = Inst->Conf.PIDRefreshDt / 10.;
+    if(p->tolerance <= 0.) p->tolerance = PIDTUNE_TOLERANCE;
+    if(p->gridN <= 0) p->gridN = PIDTUNE_GRIDN;
+    if(p->NMiter <= 0) p->NMiter = PIDTUNE_NMITER;
+    if(p->nthreads <= 0){
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        p->nthreads = (n > 0) ? (int)n : 1;
+    }
+    if(p->nthreads > PIDTUNE_MAXTHREADS) p->nthreads = PIDTUNE_MAXTHREADS;
+    if(p->max.P == 0. && p->max.I == 0. && p->max.D == 0.){
+        p->max.P = PIDTUNE_PMAX; p->max.I = PIDTUNE_IMAX; p->max.D = PIDTUNE_DMAX;
+    }
+    if(p->skip >= p->duration || p->dt > Inst->Conf.PIDRefreshDt || p->latency < 0. || p->noise < 0.) return MCC_E_BADFORMAT;
+    tn.lim = p->axis ? Inst->Ylimits : Inst->Xlimits;
+    tn.corrdt = Inst->Conf.PIDRefreshDt;
+    tn.maxpointing = Inst->Conf.MaxPointingErr;
+    tn.finepointing = Inst->Conf.MaxFinePointingErr;
+    tn.Iarrsz = Inst->Conf.PIDCycleDt / Inst->Conf.PIDRefreshDt;
+    tn.nlat = (size_t)(p->latency / p->dt + 0.5);
+    for(int d = 0; d < 3; ++d){
+        double mn = gainval(&p->min, d), mx = gainval(&p->max, d);
+        if(mn < 0. || mx < mn) return MCC_E_BADFORMAT;
+        if(mx > mn) tn.dim[tn.ndim++] = d;
+    }
+    // grid search
+    size_t ngrid = 1, G = (size_t)p->gridN;
+    for(int i = 0; i < tn.ndim; ++i) ngrid *= G;
+    jobs_t j = {.tune = &tn, .njobs = ngrid};
+    j.gains = calloc(ngrid, sizeof(PIDpar_t));
+    j.cost = calloc(ngrid, sizeof(double));
+    j.res = calloc(ngrid, sizeof(simres_t));
+    mcc_errcodes_t ret = MCC_E_FATAL;
+    if(!j.gains || !j.cost || !j.res) goto ret;
+    for(size_t n = 0; n < ngrid; ++n){
+        double u[3];
+        size_t idx = n;
+        for(int i = 0; i < tn.ndim; ++i){
+            u[i] = (G > 1) ? (double)(idx % G) / (double)(G - 1) : 0.5;
+            idx /= G;
+        }
+        j.gains[n] = p->min;
+        u2gain(&tn, u, &j.gains[n]);
+    }
+    if(!runjobs(&j, p->nthreads)) goto ret;
+    // Nelder-Mead from the best grid points (at least one per thread)
+    size_t nbest = (size_t)p->nthreads;
+    if(nbest < 4) nbest = 4;
+    if(nbest > ngrid) nbest = ngrid;
+    for(size_t i = 0; i < nbest; ++i){ // partial selection sort
+        size_t b = i;
+        for(size_t k = i + 1; k < ngrid; ++k) if(j.cost[k] < j.cost[b]) b = k;
+        PIDpar_t tg = j.gains[i]; j.gains[i] = j.gains[b]; j.gains[b] = tg;
+        double tc = j.cost[i]; j.cost[i] = j.cost[b]; j.cost[b] = tc;
+        simres_t tr = j.res[i]; j.res[i] = j.res[b]; j.res[b] = tr;
+    }
+    if(!isfinite(j.cost[0])){
+        DBG("All simulations failed");
+        ret = MCC_E_FAILED;
+        goto ret;
+    }
+    j.njobs = nbest;
+    j.NM = 1;
+    if(!runjobs(&j, p->nthreads)) goto ret;
+    size_t best = 0;
+    for(size_t i = 1; i < nbest; ++i) if(j.cost[i] < j.cost[best]) best = i;
+    res->gain = j.gains[best];
+    res->rms = j.res[best].rms;
+    res->peak = j.res[best].peak;
+    res->settle = j.res[best].settle;
+    res->nsim = atomic_load(&j.nsim);
+    ret = MCC_E_OK;
+ret:
+    free(j.gains);
+    free(j.cost);
+    free(j.res);
+    return ret;
+}
@@ -1,6 +1,6 @@
 /*
- * This file is part of the moving_model project.
- * Copyright 2025 Edward V. Emelianov <edward.emelianoff@gmail.com>.
+ * This file is part of the libsidservo project.
+ * Copyright 2026 Edward V. Emelianov <edward.emelianoff@gmail.com>.
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -18,9 +18,18 @@
 
 #pragma once
 
-#include "moving.h"
-
-extern double coord_tolerance;
-extern double time_tick;
+#include "sidservo.h"
 
+// default values of tuning parameters
+#define PIDTUNE_DURATION    (120.)
+#define PIDTUNE_SKIP        (10.)
+#define PIDTUNE_TOLERANCE   (4.8481368e-6)
+#define PIDTUNE_GRIDN       (5)
+#define PIDTUNE_NMITER      (200)
+#define PIDTUNE_PMAX        (10.)
+#define PIDTUNE_IMAX        (5.)
+#define PIDTUNE_DMAX        (1.)
+// max amount of threads
+#define PIDTUNE_MAXTHREADS  (256)
 
+mcc_errcodes_t pid_tune(const mcc_pidtune_t *par, mcc_pidtune_res_t *res);
@@ -16,7 +16,8 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-// simplest trapezioidal ramp
+// unified ramps: dumb (infinite acceleration), trapezium and s-shaped (limited jerk);
+// trajectory is a set of polynomial segments, so any point is calculated in closed form
 
 #include <math.h>
 #include <strings.h>
@@ -33,139 +34,154 @@
 
 static double coord_tolerance = COORD_TOLERANCE_DEFAULT;
 
+// kinematic state
+typedef struct{
+    double t, x, v, a;
+} kin_t;
+
+// parameters of segment `s` at time `t`
+static inline void segeval(const rampseg_t *s, double t, moveparam_t *p){
+    double dt = t - s->t0;
+    p->accel = s->a0 + s->j * dt;
+    p->speed = s->v0 + (s->a0 + s->j * dt / 2.) * dt;
+    p->coord = s->x0 + (s->v0 + (s->a0 / 2. + s->j * dt / 6.) * dt) * dt;
+}
+
+// index of segment for time `t` starting search from `i` (segments are sorted by time)
+static inline int segfind(const movemodel_t *m, int i, double t){
+    while(i + 1 < m->nseg && m->seg[i+1].t0 <= t) ++i;
+    while(i > 0 && m->seg[i].t0 > t) --i;
+    return i;
+}
+
+/**
+ * @brief addseg - move state `k` with jerk `j` for `dt` seconds
+ * @param k (io) - kinematic state
+ * @param j - jerk
+ * @param dt - duration of segment
+ * @param segs - array of segments to store this one (or NULL)
+ * @param n (io) - amount of segments in `segs`
+ */
+static void addseg(kin_t *k, double j, double dt, rampseg_t *segs, int *n){
+    if(dt <= 0.) return;
+    if(segs){
+        if(*n >= RAMP_MAXSEG) return; // never should be
+        rampseg_t *s = &segs[(*n)++];
+        s->t0 = k->t; s->x0 = k->x; s->v0 = k->v; s->a0 = k->a; s->j = j;
+    }
+    k->x += (k->v + (k->a / 2. + j * dt / 6.) * dt) * dt;
+    k->v += (k->a + j * dt / 2.) * dt;
+    k->a += j * dt;
+    k->t += dt;
+}
+
+/**
+ * @brief vtrans - change speed to `v1` (and acceleration to 0) as fast as possible
+ * @param k (io) - kinematic state
+ * @param v1 - target speed
+ * @param A - max acceleration (0 - infinite)
+ * @param J - max jerk (0 - infinite)
+ * @param segs, n - segments (or NULL)
+ */
+static void vtrans(kin_t *k, double v1, double A, double J, rampseg_t *segs, int *n){
+    double dv = v1 - k->v;
+    if(A <= 0.){ // speed jump
+        k->v = v1;
+        k->a = 0.;
+        return;
+    }
+    if(J <= 0.){ // acceleration jump
+        k->a = (dv < 0.) ? -A : A;
+        addseg(k, 0., fabs(dv) / A, segs, n);
+    }else{
+        double a0 = k->a;
+        double s = (dv - a0 * fabs(a0) / (2. * J) < 0.) ? -1. : 1.; // sign of acceleration after this stage
+        // |peak acceleration| without constant acceleration part
+        double p2 = J * s * dv + a0 * a0 / 2., p = (p2 > 0.) ? sqrt(p2) : 0., thold = 0.;
+        if(p > A){ // have constant acceleration
+            thold = (s * dv - (2. * A * A - a0 * a0) / (2. * J)) / A;
+            p = A;
+        }
+        double ap = s * p;
+        addseg(k, (ap > a0) ? J : -J, fabs(ap - a0) / J, segs, n);
+        k->a = ap;
+        addseg(k, 0., thold, segs, n);
+        addseg(k, -s * J, p / J, segs, n);
+    }
+    k->v = v1; // remove rounding errors
+    k->a = 0.;
+}
+
+// path to the stop after going with speed `vp` (from state `k0`)
+static double path(const kin_t *k0, double vp, double A, double J){
+    kin_t k = *k0;
+    vtrans(&k, vp, A, J, NULL, NULL);
+    vtrans(&k, 0., A, J, NULL, NULL);
+    return k.x - k0->x;
+}
+
+// max acceleration and jerk by ramp type (0 - infinite)
+static void getAJ(const movemodel_t *m, double *A, double *J){
+    *A = (m->type == RAMP_DUMB) ? 0. : m->Max.accel;
+    *J = (m->type == RAMP_S) ? m->jerk : 0.;
+}
+
+// update current parameters for time `t`
+static void setcur(movemodel_t *m, double t){
+    if(m->state != ST_MOVE || m->nseg < 1) return;
+    m->curseg = segfind(m, m->curseg, t);
+    if(m->curseg == m->nseg - 1){ // stopped
+        m->curparams.coord = m->seg[m->curseg].x0;
+        m->curparams.speed = m->curparams.accel = 0.;
+        m->state = ST_STOP;
+        m->nseg = 0;
+    }else segeval(&m->seg[m->curseg], t, &m->curparams);
+}
+
+// build segments to go from current state (at time `t`) with speed `vp` for `tc` seconds and then stop at `xend`
+static void build(movemodel_t *m, double t, double vp, double tc, double xend){
+    double A, J;
+    getAJ(m, &A, &J);
+    kin_t k = {.t = t, .x = m->curparams.coord, .v = m->curparams.speed, .a = m->curparams.accel};
+    int n = 0;
+    vtrans(&k, vp, A, J, m->seg, &n);
+    addseg(&k, 0., tc, m->seg, &n);
+    vtrans(&k, 0., A, J, m->seg, &n);
+    rampseg_t *s = &m->seg[n++]; // stopped
+    s->t0 = k.t; s->x0 = xend; s->v0 = s->a0 = s->j = 0.;
+    m->nseg = n;
+    m->curseg = 0;
+    m->state = ST_MOVE;
+}
+
 static void emstop(movemodel_t *m, double _U_ t){
     FNAME();
     pthread_mutex_lock(&m->mutex);
     m->curparams.accel = 0.;
     m->curparams.speed = 0.;
-    bzero(m->Times, sizeof(double) * STAGE_AMOUNT);
-    bzero(m->Params, sizeof(moveparam_t) * STAGE_AMOUNT);
+    m->nseg = 0;
     m->state = ST_STOP;
-    m->movingstage = STAGE_STOPPED;
     pthread_mutex_unlock(&m->mutex);
 }
 
 static void stop(movemodel_t *m, double t){
     FNAME();
     pthread_mutex_lock(&m->mutex);
-    if(m->state == ST_STOP || m->movingstage == STAGE_STOPPED) goto ret;
-    m->movingstage = STAGE_DECEL;
-    m->state = ST_MOVE;
-    m->Times[STAGE_DECEL] = t;
-    m->Params[STAGE_DECEL].speed = m->curparams.speed;
-    if(m->curparams.speed > 0.) m->Params[STAGE_DECEL].accel = -m->Max.accel;
-    else m->Params[STAGE_DECEL].accel = m->Max.accel;
-    m->Params[STAGE_DECEL].coord = m->curparams.coord;
-    // speed: v=v2+a2(t-t2), v2 and a2 have different signs; t3: v3=0 -> t3=t2-v2/a2
-    m->Times[STAGE_STOPPED] = t - m->curparams.speed / m->Params[STAGE_DECEL].accel;
-    // coordinate: x=x2+v2(t-t2)+a2(t-t2)^2/2 -> x3=x2+v2(t3-t2)+a2(t3-t2)^2/2
-    double dt = m->Times[STAGE_STOPPED] - t;
-    m->Params[STAGE_STOPPED].coord = m->curparams.coord + m->curparams.speed * dt +
-                                  m->Params[STAGE_DECEL].accel * dt * dt / 2.;
-ret:
-    pthread_mutex_unlock(&m->mutex);
-}
-
-// inner part of `calc`, could be called recoursively for hard case
-static void unlockedcalc(movemodel_t *m, moveparam_t *x, double t){
-    // signs
-    double sign_a01 = 0., sign_a23 = 0., sign_vset = 0.; // accelerations on stages ACCEL and DECEL, speed on maxspeed stage
-    // times
-    double dt01 = 0., dt12 = 0., dt23 = 0.;
-    // absolute speed at stage 23 (or in that point); absolute max acceleration
-    double abs_vset = x->speed, abs_a = m->Max.accel;
-    // absolute target movement
-    double abs_Dx = fabs(x->coord - m->curparams.coord);
-    if(m->state == ST_STOP && abs_Dx < coord_tolerance){
-        DBG("Movement too small -> stay at place");
-        return;
-    }
-    // signs of Dx and current speed
-    double sign_Dx = (x->coord > m->curparams.coord) ? 1. : -1.;
-    double v0 = m->curparams.speed;
-    double sign_v0 = v0 < 0. ? -1 : 1., abs_v0 = fabs(v0);
-    if(v0 == 0.) sign_v0 = 0.;
-    // preliminary calculations (vset and dependent values could be changed)
-    dt01 = fabs(abs_v0 - abs_vset) / abs_a;
-    double abs_dx23 = abs_vset * abs_vset / 2. / abs_a;
-    dt23 = abs_vset / abs_a;
-    double abs_dx_stop = abs_v0 * abs_v0 / 2. / abs_a;
-    if(sign_Dx * sign_v0 >= 0. && abs_dx_stop < abs_Dx){ // we shouldn't change speed direction
-        if(fabs(abs_dx_stop - abs_Dx) <= coord_tolerance){ // simplest case: just stop
-            //DBG("Simplest case: stop");
-            dt01 = dt12 = 0.;
-            sign_a23 = -sign_v0;
-            dt23 = abs_v0 / abs_a;
-        }else if(abs_vset < abs_v0){ // move with smaller speed than now: very simple case
-            //DBG("Move with smaller speed");
-            sign_a01 = sign_a23 = -sign_v0;
-            sign_vset = sign_v0;
-            double abs_dx01 = abs_v0 * dt01 - abs_a * dt01 * dt01 / 2.;
-            double abs_dx12 = abs_Dx - abs_dx01 - abs_dx23;
-            dt12 = abs_dx12 / abs_vset;
-        }else{// move with larget speed
-            //DBG("Move with larger speed");
-            double abs_dx01 = abs_v0 * dt01 + abs_a * dt01 * dt01 / 2.;
-            if(abs_Dx < abs_dx01 + abs_dx23){ // recalculate target speed and other
-                abs_vset = sqrt(abs_a * abs_Dx + abs_v0 * abs_v0 / 2.);
-                dt01 = fabs(abs_v0 - abs_vset) / abs_a;
-                abs_dx01 = abs_v0 * dt01 + abs_a * dt01 * dt01 / 2.;
-                dt23 = abs_vset / abs_a;
-                abs_dx23 = abs_vset * abs_vset / 2. / abs_a;
-                DBG("Can't reach target speed %g, take %g instead", x->speed, abs_vset);
-            }
-            sign_a01 = sign_Dx; // sign_v0 could be ZERO!!!
-            sign_a23 = -sign_Dx;
-            sign_vset = sign_Dx;
-            double abs_dx12 = abs_Dx - abs_dx01 - abs_dx23;
-            dt12 = abs_dx12 / abs_vset;
-        }
-    }else{
-        // if we are here, we have the worst case: change speed direction
-       // DBG("Hardest case: change speed direction");
-        // now we should calculate coordinate at which model stops and biuld new trapezium from that point
-        double x0 = m->curparams.coord, v0 = m->curparams.speed;
-        double xstop = x0 + sign_v0 * abs_dx_stop, tstop = t + abs_v0 / abs_a;
+    setcur(m, t);
+    if(m->state == ST_STOP) goto ret;
+    if(m->type == RAMP_DUMB){
+        m->curparams.accel = m->curparams.speed = 0.;
+        m->nseg = 0;
         m->state = ST_STOP;
-        m->curparams.accel = 0.; m->curparams.coord = xstop; m->curparams.speed = 0.;
-        unlockedcalc(m, x, tstop); // calculate new ramp
-        // and change started conditions
-        m->curparams.coord = x0; m->curparams.speed = v0;
-        m->Times[STAGE_ACCEL] = t;
-        m->Params[STAGE_ACCEL].coord = x0;
-        m->Params[STAGE_ACCEL].speed = v0;
-       // DBG("NOW t[0]=%g, X[0]=%g, V[0]=%g", t, x0, v0);
-        return;
+        goto ret;
     }
-    m->state = ST_MOVE;
-    m->movingstage = STAGE_ACCEL;
-    // some knot parameters
-    double a01 = sign_a01 * abs_a, a23 = sign_a23 * abs_a;
-    double v1, v2, x0, x1, x2;
-    v2 = v1 = sign_vset * abs_vset;
-    x0 = m->curparams.coord;
-    x1 = x0 + v0 * dt01 + a01 * dt01 * dt01 / 2.;
-    x2 = x1 + v1 * dt12;
-    // fill knot parameters
-    moveparam_t *p = &m->Params[STAGE_ACCEL]; // 0-1 - change started speed
-    p->accel = a01;
-    p->speed = m->curparams.speed;
-    p->coord = x0;
-    m->Times[STAGE_ACCEL] = t;
-    p = &m->Params[STAGE_MAXSPEED]; // 1-2 - constant speed
-    p->accel = 0.;
-    p->speed = v1;
-    p->coord = x1;
-    m->Times[STAGE_MAXSPEED] = m->Times[STAGE_ACCEL] + dt01;
-    p = &m->Params[STAGE_DECEL]; // 2-3 - decrease speed
-    p->accel = a23;
-    p->speed = v2;
-    p->coord = x2;
-    m->Times[STAGE_DECEL] = m->Times[STAGE_MAXSPEED] + dt12;
-    p = &m->Params[STAGE_STOPPED]; // 3 - stop at target
-    p->accel = p->speed = 0.;
-    p->coord = x->coord;
-    m->Times[STAGE_STOPPED] = m->Times[STAGE_DECEL] + dt23;
+    double A, J;
+    getAJ(m, &A, &J);
+    kin_t k = {.t = t, .x = m->curparams.coord, .v = m->curparams.speed, .a = m->curparams.accel};
+    vtrans(&k, 0., A, J, NULL, NULL);
+    build(m, t, 0., 0., k.x);
+ret:
+    pthread_mutex_unlock(&m->mutex);
 }
 
 /**
@@ -189,12 +205,33 @@ static int calc(movemodel_t *m, moveparam_t *x, double t) {
         goto ret;
     }
     ret = TRUE; // now there's no chanses to make error
-    unlockedcalc(m, x, t);
-    // Debug output
-    /*for(int i = 0; i < STAGE_AMOUNT; i++){
-        DBG("Stage %d: t=%.6f, coord=%.6f, speed=%.6f, accel=%.6f",
-            i, m->Times[i], m->Params[i].coord, m->Params[i].speed, m->Params[i].accel);
-    }*/
+    setcur(m, t);
+    double D = x->coord - m->curparams.coord, A, J;
+    if(m->state == ST_STOP && fabs(D) < coord_tolerance){
+        DBG("Movement too small -> stay at place");
+        goto ret;
+    }
+    getAJ(m, &A, &J);
+    kin_t k0 = {.t = t, .x = m->curparams.coord, .v = m->curparams.speed, .a = m->curparams.accel};
+    double rest = D - path(&k0, 0., A, J); // path left after stop
+    if(fabs(rest) <= coord_tolerance){ // simplest case: just stop
+        build(m, t, 0., 0., x->coord);
+        goto ret;
+    }
+    double s = (rest < 0.) ? -1. : 1., vp = s * x->speed, tc = D - path(&k0, vp, A, J);
+    if(s * tc >= 0.) tc /= vp; // have constant speed part
+    else{ // can't reach target speed: find max speed by bisection
+        double lo = 0., hi = x->speed;
+        for(int i = 0; i < 100 && hi - lo > 1e-15 * x->speed; ++i){
+            double mid = (lo + hi) / 2.;
+            if(s * (D - path(&k0, s * mid, A, J)) > 0.) lo = mid;
+            else hi = mid;
+        }
+        DBG("Can't reach target speed %g, take %g instead", x->speed, lo);
+        vp = s * lo;
+        tc = 0.;
+    }
+    build(m, t, vp, tc, x->coord);
 ret:
     pthread_mutex_unlock(&m->mutex);
     return ret;
@@ -202,32 +239,7 @@ ret:
 
 static movestate_t proc(movemodel_t *m, moveparam_t *next, double t){
     pthread_mutex_lock(&m->mutex);
-    if(m->state == ST_STOP) goto ret;
-    for(movingstage_t s = STAGE_STOPPED; s >= 0; --s){
-        if(m->Times[s] <= t){ // check time for current stage
-            m->movingstage = s;
-            break;
-        }
-    }
-    if(m->movingstage == STAGE_STOPPED){
-        m->curparams.coord = m->Params[STAGE_STOPPED].coord;
-        pthread_mutex_unlock(&m->mutex);
-       /* DBG("REACHED STOPping stage @ t=%g", t);
-        for(int s = STAGE_STOPPED; s >= 0; --s){
-            DBG("T[%d]=%g, ", s, m->Times[s]);
-        }*/
-        emstop(m, t);
-        goto ret;
-    }
-    // calculate current parameters
-    double dt = t - m->Times[m->movingstage];
-    double a = m->Params[m->movingstage].accel;
-    double v0 = m->Params[m->movingstage].speed;
-    double x0 = m->Params[m->movingstage].coord;
-    m->curparams.accel = a;
-    m->curparams.speed = v0 + a * dt;
-    m->curparams.coord = x0 + v0 * dt + a * dt * dt / 2.;
-ret:
+    setcur(m, t);
     if(next) *next = m->curparams;
     movestate_t st = m->state;
     pthread_mutex_unlock(&m->mutex);
@@ -244,16 +256,44 @@ static movestate_t getst(movemodel_t *m, moveparam_t *cur){
 
 static double gettstop(movemodel_t *m){
     pthread_mutex_lock(&m->mutex);
-    double r = m->Times[STAGE_STOPPED];
+    double r = (m->state == ST_MOVE && m->nseg > 0) ? m->seg[m->nseg - 1].t0 : 0.;
     pthread_mutex_unlock(&m->mutex);
     return r;
 }
 
-movemodel_t trapez = {
+/**
+ * @brief eval - calculate model points for array of times (model state isn't changed)
+ * @param m - model
+ * @param t - times (fastest for sorted array)
+ * @param n - amount of points
+ * @param out (o) - points
+ * @return amount of points calculated
+ */
+static size_t eval(movemodel_t *m, const double *t, size_t n, moveparam_t *out){
+    if(!m || !t || !out) return 0;
+    pthread_mutex_lock(&m->mutex);
+    if(m->state != ST_MOVE || m->nseg < 1){
+        for(size_t i = 0; i < n; ++i) out[i] = m->curparams;
+    }else{
+        int s = m->curseg;
+        for(size_t i = 0; i < n; ++i){
+            s = segfind(m, s, t[i]);
+            if(s == m->nseg - 1){
+                out[i].coord = m->seg[s].x0;
+                out[i].speed = out[i].accel = 0.;
+            }else segeval(&m->seg[s], t[i], &out[i]);
+        }
+    }
+    pthread_mutex_unlock(&m->mutex);
+    return n;
+}
+
+const movemodel_t rampmodel = {
     .stop = stop,
     .emergency_stop = emstop,
     .get_state = getst,
     .calculate = calc,
     .proc_move = proc,
     .stoppedtime = gettstop,
+    .eval = eval,
 };
@@ -20,4 +20,4 @@
 
 #include "movingmodel.h"
 
-extern movemodel_t trapez;
+extern const movemodel_t rampmodel;
@@ -0,0 +1,177 @@
+/*
+ * This file is part of the libsidservo project.
+ * Copyright 2026 Edward V. Emelianov <edward.emelianoff@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Replay of recorded telemetry log as fake device: mount thread gives recorded mountdata_t at the same times from
+ * init() (timestamps are shifted by difference of init() times, so with virtual clock started at the time of record
+ * they are bit-exact), transactions with mount are answered by recorded answers to the same commands.
+ */
+
+#include <pthread.h>
+#include <string.h>
+
+#include "main.h"
+#include "replay.h"
+#include "telelog.h"
+
+// add `d` to `t`
+static void tsadd(struct timespec *t, const struct timespec *d){
+    t->tv_sec += d->tv_sec;
+    t->tv_nsec += d->tv_nsec;
+    if(t->tv_nsec > 999999999L){
+        ++t->tv_sec;
+        t->tv_nsec -= 1000000000L;
+    }
+}
+
+/**
+ * @brief replay_open - open log for replay
+ * @param path - file name
+ * @return FALSE if failed
+ */
+int replay_open(const char *path){
+    replay_close();
+    pthread_mutex_lock(&Inst->rp.mutex);
+    int ret = FALSE;
+    if(!tlog_map(path, &Inst->rp.map)){
+        DBG("Can't map %s", path);
+        goto ret;
+    }
+    Inst->rp.ioidx = calloc(Inst->rp.map.nrec + 1, sizeof(size_t));
+    if(!Inst->rp.ioidx){
+        tlog_unmap(&Inst->rp.map);
+        goto ret;
+    }
+    Inst->rp.nio = 0;
+    for(size_t i = 0; i < Inst->rp.map.nrec; ++i)
+        if(Inst->rp.map.rec[i].type == TLOG_MNTIO) Inst->rp.ioidx[Inst->rp.nio++] = i;
+    Inst->rp.mdcur = Inst->rp.iocur = Inst->rp.replayed = Inst->rp.matched = Inst->rp.mismatched = 0;
+    Inst->rp.position = 0.;
+    Inst->rp.finished = 0;
+    struct timespec t0;
+    inittime(&t0);
+    Inst->rp.shift.tv_sec = t0.tv_sec - Inst->rp.map.hdr->start.tv_sec;
+    Inst->rp.shift.tv_nsec = t0.tv_nsec - Inst->rp.map.hdr->start.tv_nsec;
+    if(Inst->rp.shift.tv_nsec < 0){
+        --Inst->rp.shift.tv_sec;
+        Inst->rp.shift.tv_nsec += 1000000000L;
+    }
+    DBG("Replay %zd records (%zd transactions), time shift %zd.%09ld", Inst->rp.map.nrec, Inst->rp.nio,
+        (ssize_t)Inst->rp.shift.tv_sec, Inst->rp.shift.tv_nsec);
+    ret = TRUE;
+ret:
+    pthread_mutex_unlock(&Inst->rp.mutex);
+    return ret;
+}
+
+void replay_close(){
+    pthread_mutex_lock(&Inst->rp.mutex);
+    tlog_unmap(&Inst->rp.map);
+    free(Inst->rp.ioidx);
+    Inst->rp.ioidx = NULL;
+    Inst->rp.nio = 0;
+    pthread_mutex_unlock(&Inst->rp.mutex);
+}
+
+/**
+ * @brief replay_next - get next telemetry record
+ * @param md (o) - mount data with shifted timestamps
+ * @param t (o) - time of record (from init())
+ * @return FALSE if there's no more records
+ */
+int replay_next(mountdata_t *md, double *t){
+    if(!md || !t) return FALSE;
+    pthread_mutex_lock(&Inst->rp.mutex);
+    int ret = FALSE;
+    size_t i = Inst->rp.mdcur;
+    while(i < Inst->rp.map.nrec && Inst->rp.map.rec[i].type != TLOG_MOUNTDATA) ++i;
+    if(i >= Inst->rp.map.nrec){
+        Inst->rp.finished = 1;
+        goto ret;
+    }
+    *md = Inst->rp.map.rec[i].md;
+    *t = Inst->rp.map.rec[i].t;
+    struct timespec *ts[] = {&md->motXposition.t, &md->motYposition.t, &md->encXposition.t, &md->encYposition.t,
+                             &md->encXspeed.t, &md->encYspeed.t, &md->encXspeedLS.t, &md->encYspeedLS.t,
+                             &md->encXspeedKF.t, &md->encYspeedKF.t};
+    for(size_t k = 0; k < sizeof(ts)/sizeof(ts[0]); ++k)
+        if(ts[k]->tv_sec || ts[k]->tv_nsec) tsadd(ts[k], &Inst->rp.shift); // zero means "no data"
+    Inst->rp.mdcur = i + 1;
+    ++Inst->rp.replayed;
+    Inst->rp.position = *t;
+    ret = TRUE;
+ret:
+    pthread_mutex_unlock(&Inst->rp.mutex);
+    return ret;
+}
+
+/**
+ * @brief replay_io - answer to transaction with mount by the next recorded transaction with the same output
+ *      (recorded transactions skipped are status requests and other ones not made now)
+ * @param out - data to send
+ * @param eol - ==1 if "\r" should be added
+ * @param in (o) - answer
+ * @return recorded result or FALSE if there's no such transaction
+ */
+int replay_io(const data_t *out, int eol, data_t *in){
+    size_t lo = out ? out->len : 0;
+    pthread_mutex_lock(&Inst->rp.mutex);
+    int ret = FALSE;
+    if(in) in->len = 0;
+    for(size_t k = Inst->rp.iocur; k < Inst->rp.nio; ++k){
+        const tlog_io_t *io = &Inst->rp.map.rec[Inst->rp.ioidx[k]].io;
+        if(io->outlen != lo || io->eol != (eol ? 1 : 0) || (lo && memcmp(io->buf, out->buf, lo))) continue;
+        if(in && in->maxlen){
+            size_t li = (io->inlen < in->maxlen) ? io->inlen : in->maxlen;
+            memcpy(in->buf, io->buf + lo, li);
+            in->len = li;
+        }
+        ret = io->ret;
+        Inst->rp.iocur = k + 1;
+        ++Inst->rp.matched;
+        goto ret;
+    }
+    DBG("Transaction not found in log");
+    ++Inst->rp.mismatched;
+ret:
+    pthread_mutex_unlock(&Inst->rp.mutex);
+    return ret;
+}
+
+/**
+ * @brief replay_state - get state of replay
+ * @param s (o) - state
+ * @return errcode
+ */
+mcc_errcodes_t replay_state(mcc_replay_t *s){
+    if(!s) return MCC_E_BADFORMAT;
+    pthread_mutex_lock(&Inst->rp.mutex);
+    mcc_errcodes_t ret = MCC_E_FAILED;
+    if(Inst->rp.map.addr){
+        s->duration = Inst->rp.map.nrec ? Inst->rp.map.rec[Inst->rp.map.nrec - 1].t : 0.;
+        s->position = Inst->rp.position;
+        s->nrec = Inst->rp.map.nrec;
+        s->replayed = Inst->rp.replayed;
+        s->cmdmatched = Inst->rp.matched;
+        s->cmdmismatched = Inst->rp.mismatched;
+        s->finished = Inst->rp.finished;
+        ret = MCC_E_OK;
+    }
+    pthread_mutex_unlock(&Inst->rp.mutex);
+    return ret;
+}
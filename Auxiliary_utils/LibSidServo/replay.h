@@ -0,0 +1,46 @@
+/*
+ * This file is part of the libsidservo project.
+ * Copyright 2026 Edward V. Emelianov <edward.emelianoff@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <pthread.h>
+
+#include "sidservo.h"
+#include "telelog.h"
+
+// max interval of replay thread sleeping (to check exit flag), s
+#define REPLAY_MAXSLEEP     (0.1)
+
+// replayed log
+typedef struct{
+    tlog_map_t map;
+    size_t *ioidx;          // indexes of transactions' records
+    size_t nio;             // their amount
+    size_t mdcur, iocur;    // next telemetry record and next transaction (in `ioidx`)
+    struct timespec shift;  // shift of timestamps
+    size_t replayed, matched, mismatched;
+    double position;        // time of last replayed telemetry record
+    int finished;
+    pthread_mutex_t mutex;
+} replay_state_t;
+
+int replay_open(const char *path);
+void replay_close();
+int replay_next(mountdata_t *md, double *t);
+int replay_io(const data_t *out, int eol, data_t *in);
+mcc_errcodes_t replay_state(mcc_replay_t *s);
@@ -16,46 +16,54 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+// for pthread_setaffinity_np()
+#define _GNU_SOURCE
 #include <asm-generic/termbits.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <math.h>
 #include <poll.h>
 #include <pthread.h>
+#include <sched.h>
 #include <signal.h>
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/epoll.h>
 #include <sys/ioctl.h>
 #include <sys/stat.h>
+#include <sys/timerfd.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#include "enchist.h"
 #include "kalman.h"
 #include "main.h"
 #include "movingmodel.h"
+#include "pec.h"
+#include "replay.h"
 #include "serial.h"
 #include "ssii.h"
+#include "stats.h"
+#include "telelog.h"
+#include "vclock.h"
 
-// serial devices FD
-static int encfd[2] = {-1, -1}, mntfd = -1;
-// main mount data
-static mountdata_t mountdata = {0};
-// last encoders time and last encoders data - for speed measurement
-//static coordval_t lastXenc = {0}, lastYenc = {0};
-
-// mutexes for RW operations with mount device and data
-static pthread_mutex_t  mntmutex = PTHREAD_MUTEX_INITIALIZER,
-                        datamutex = PTHREAD_MUTEX_INITIALIZER;
-// encoders thread and mount thread
-static pthread_t encthread, mntthread;
-// max timeout for 1.5 bytes of encoder and 2 bytes of mount - for `select`
+// max timeout for mount answer - for `select`
 // this values will be modified later
-static struct timeval encRtmout = {.tv_sec = 0, .tv_usec = 100}, // encoder reading timeout
-    mnt1Rtmout = {.tv_sec = 0, .tv_usec = 200000}, // first reading
+static struct timeval mnt1Rtmout = {.tv_sec = 0, .tv_usec = 200000}, // first reading
     mntRtmout =  {.tv_sec = 0, .tv_usec = 50000}; // next readings
 
-static volatile int GlobExit = 0;
+static int wr(const data_t *out, data_t *in, int needeol);
+
+// constant text commands (shared by all instances: never changed)
+#define CONSTCMD(name, cmd)  static const data_t name = {.buf = (uint8_t*)cmd, .len = sizeof(cmd) - 1, .maxlen = sizeof(cmd)}
+CONSTCMD(dscmd, CMD_SHORTCMD);
+CONSTCMD(dlcmd, CMD_LONGCMD);
+CONSTCMD(wcmd, CMD_PROGFLASH);
+CONSTCMD(rcmd, CMD_DUMPFLASH);
+CONSTCMD(dgetstat, CMD_GETSTAT);
 
 // encoders raw data
 typedef struct __attribute__((packed)){
@@ -65,41 +73,129 @@ typedef struct __attribute__((packed)){
     uint8_t CRC[4];
 } enc_t;
 
+/*
+ * Writers of `Inst->ser.mountdata` are serialized by `Inst->ser.datamutex` and increment `Inst->ser.mdseq` before and after changes;
+ * readers (getMD) never lock: they copy data and retry if `Inst->ser.mdseq` was odd or changed while copying.
+ * Each change is recorded into telemetry log (if it's opened).
+ */
+static void md_wrlock(){
+    pthread_mutex_lock(&Inst->ser.datamutex);
+    atomic_fetch_add_explicit(&Inst->ser.mdseq, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+static void md_wrunlock(){
+    tlog_md(&Inst->ser.mountdata);
+    atomic_fetch_add_explicit(&Inst->ser.mdseq, 1, memory_order_release);
+    pthread_mutex_unlock(&Inst->ser.datamutex);
+}
+
 // calculate current X/Y speeds
 void getXspeed(){
-    static less_square_t *ls = NULL;
+    less_square_t *ls = Inst->ser.ls[0];
     if(!ls){
-        ls = LS_init(Conf.EncoderSpeedInterval / Conf.EncoderReqInterval);
+        ls = Inst->ser.ls[0] = LS_init(Inst->Conf.EncoderSpeedInterval / Inst->Conf.EncoderReqInterval);
         if(!ls) return;
     }
-    double dt = timediff0(&mountdata.encXposition.t);
-    double speed = LS_calc_slope(ls, mountdata.encXposition.val, dt);
-    if(fabs(speed) < 1.5 * Xlimits.max.speed){
-        mountdata.encXspeed.val = speed;
-        mountdata.encXspeed.t = mountdata.encXposition.t;
+    double dt = timediff0(&Inst->ser.mountdata.encXposition.t);
+    double speed = LS_calc_slope(ls, Inst->ser.mountdata.encXposition.val, dt);
+    if(fabs(speed) < 1.5 * Inst->Xlimits.max.speed){
+        Inst->ser.mountdata.encXspeedLS.val = speed;
+        Inst->ser.mountdata.encXspeedLS.t = Inst->ser.mountdata.encXposition.t;
+        Inst->ser.mountdata.encXspeed = Inst->ser.mountdata.encXspeedLS;
     }
 }
 void getYspeed(){
-    static less_square_t *ls = NULL;
+    less_square_t *ls = Inst->ser.ls[1];
     if(!ls){
-        ls = LS_init(Conf.EncoderSpeedInterval / Conf.EncoderReqInterval);
+        ls = Inst->ser.ls[1] = LS_init(Inst->Conf.EncoderSpeedInterval / Inst->Conf.EncoderReqInterval);
         if(!ls) return;
     }
-    double dt = timediff0(&mountdata.encYposition.t);
-    double speed = LS_calc_slope(ls, mountdata.encYposition.val, dt);
-    if(fabs(speed) < 1.5 * Ylimits.max.speed){
-        mountdata.encYspeed.val = speed;
-        mountdata.encYspeed.t = mountdata.encYposition.t;
+    double dt = timediff0(&Inst->ser.mountdata.encYposition.t);
+    double speed = LS_calc_slope(ls, Inst->ser.mountdata.encYposition.val, dt);
+    if(fabs(speed) < 1.5 * Inst->Ylimits.max.speed){
+        Inst->ser.mountdata.encYspeedLS.val = speed;
+        Inst->ser.mountdata.encYspeedLS.t = Inst->ser.mountdata.encYposition.t;
+        Inst->ser.mountdata.encYspeed = Inst->ser.mountdata.encYspeedLS;
     }
 }
 
+/**
+ * @brief enc_reconf - forget speeds calculated by old encoders' constants (after hardware configuration read):
+ *          LS are created again by getXspeed()/getYspeed(), Kalman filter restarts by new `encgen`
+ */
+void enc_reconf(){
+    pthread_mutex_lock(&Inst->ser.datamutex);
+    LS_delete(&Inst->ser.ls[0]);
+    LS_delete(&Inst->ser.ls[1]);
+    atomic_fetch_add_explicit(&Inst->ser.encgen, 1, memory_order_release);
+    pthread_mutex_unlock(&Inst->ser.datamutex);
+}
+
+/**
+ * @brief kfspeed - store Kalman speed of axis and select speed by Conf.SpeedSource
+ *          (should be run under md_wrlock after getXspeed()/getYspeed())
+ * @param axis - 0 for X, 1 for Y
+ * @param kf - Kalman filter
+ */
+static void kfspeed(int axis, const kalman_t *kf){
+    coordval_t *speed = &Inst->ser.mountdata.encXspeed, *ls = &Inst->ser.mountdata.encXspeedLS, *kfs = &Inst->ser.mountdata.encXspeedKF;
+    const coordval_t *pos = &Inst->ser.mountdata.encXposition;
+    double maxspeed = Inst->Xlimits.max.speed;
+    if(axis){
+        speed = &Inst->ser.mountdata.encYspeed; ls = &Inst->ser.mountdata.encYspeedLS; kfs = &Inst->ser.mountdata.encYspeedKF;
+        pos = &Inst->ser.mountdata.encYposition;
+        maxspeed = Inst->Ylimits.max.speed;
+    }
+    double v = kalman_val(kf, 1, axis);
+    if(fabs(v) > 1.5 * maxspeed) return; // filter isn't converged yet
+    kfs->val = v;
+    kfs->t = pos->t;
+    switch(Inst->Conf.SpeedSource){
+        case SPEED_SRC_KALMAN:
+            *speed = *kfs;
+            break;
+        case SPEED_SRC_BOTH:{
+            // LS gives speed at the middle of its window, so compare with Kalman speed at that moment
+            double dv = v - kalman_val(kf, 2, axis) * Inst->Conf.EncoderSpeedInterval / 2. - ls->val;
+            if(Inst->Conf.SpeedDisagreement <= 0. || fabs(dv) < Inst->Conf.SpeedDisagreement) *speed = *kfs;
+            else{
+                DBG("Axis %d: Kalman and LS speeds disagree by %g", axis, dv);
+                *speed = *ls;
+            }
+            break;
+        }
+        default: // LS is already selected
+            break;
+    }
+}
+
+/**
+ * @brief enchist_add - put last encoder's data into history (should be run under md_wrlock)
+ * @param axis - 0 for X, 1 for Y
+ * @param raw - raw encoder's counts
+ * @param accel - acceleration (if known) or 0
+ */
+static void enchist_add(int axis, int32_t raw, double accel){
+    struct timespec *tlast = Inst->ser.enctlast;
+    encsample_t s = {.raw = raw};
+    const coordval_t *pos = axis ? &Inst->ser.mountdata.encYposition : &Inst->ser.mountdata.encXposition;
+    if(tlast[axis].tv_sec) hist_add(&Inst->Stats.encInterval, timediff(&pos->t, &tlast[axis]));
+    tlast[axis] = pos->t;
+    s.t = pos->t;
+    s.pos = pos->val;
+    s.speed = axis ? Inst->ser.mountdata.encYspeed.val : Inst->ser.mountdata.encXspeed.val;
+    s.accel = accel;
+    enchist_push(axis, &s);
+}
+
 /**
  * @brief parse_encbuf - check encoder buffer (for encoder data based on SSII proto) and fill fresh data
  * @param databuf - input buffer with 13 bytes of data
  * @param t - time when databuf[0] got
+ * @return FALSE if packet is broken
  */
-static void parse_encbuf(uint8_t databuf[ENC_DATALEN], struct timespec *t){
-    if(!t) return;
+static int parse_encbuf(uint8_t databuf[ENC_DATALEN], struct timespec *t){
+    if(!t) return FALSE;
     enc_t *edata = (enc_t*) databuf;
 /*
 #ifdef EBUG
@@ -110,62 +206,44 @@ static void parse_encbuf(uint8_t databuf[ENC_DATALEN], struct timespec *t){
 */
     if(edata->magick != ENC_MAGICK){
         DBG("No magick");
-        return;
+        return FALSE;
     }
     if(edata->CRC[3]){
         DBG("No 0 @ end: 0x%02x", edata->CRC[3]);
-        return;
+        return FALSE;
     }
     uint32_t POS_SUM = 0;
     for(int i = 1; i < 9; ++i) POS_SUM += databuf[i];
     uint8_t x = POS_SUM >> 8;
     if(edata->CRC[0] != x){
         DBG("CRC[0] = 0x%02x, need 0x%02x", edata->CRC[0], x);
-        return;
+        return FALSE;
     }
     uint8_t y = ((0xFFFF - POS_SUM) & 0xFF) - x;
     if(edata->CRC[1] != y){
         DBG("CRC[1] = 0x%02x, need 0x%02x", edata->CRC[1], y);
-        return;
+        return FALSE;
     }
     y = (0xFFFF - POS_SUM) >> 8;
     if(edata->CRC[2] != y){
         DBG("CRC[2] = 0x%02x, need 0x%02x", edata->CRC[2], y);
-        return;
+        return FALSE;
     }
-    pthread_mutex_lock(&datamutex);
-    mountdata.encXposition.val = Xenc2rad(edata->encX);
-    mountdata.encYposition.val = Yenc2rad(edata->encY);
-    DBG("Got positions X/Y= %.6g / %.6g", mountdata.encXposition.val, mountdata.encYposition.val);
-    mountdata.encXposition.t = *t;
-    mountdata.encYposition.t = *t;
+    const int32_t cnt[2] = {edata->encX, edata->encY};
+    double pos[2];
+    SScnt2rad(&Inst->ss, SS_XENC, 2, cnt, pos, 1);
+    md_wrlock();
+    Inst->ser.mountdata.encXposition.val = pos[0];
+    Inst->ser.mountdata.encYposition.val = pos[1];
+    DBG("Got positions X/Y= %.6g / %.6g", Inst->ser.mountdata.encXposition.val, Inst->ser.mountdata.encYposition.val);
+    Inst->ser.mountdata.encXposition.t = *t;
+    Inst->ser.mountdata.encYposition.t = *t;
     getXspeed(); getYspeed();
-    pthread_mutex_unlock(&datamutex);
-    //DBG("time = %zd+%zd/1e6, X=%g deg, Y=%g deg", tv->tv_sec, tv->tv_usec, mountdata.encposition.X*180./M_PI, mountdata.encposition.Y*180./M_PI);
-}
-
-// try to read 1 byte from encoder; return -1 if nothing to read or -2 if device seems to be disconnected
-static int getencbyte(){
-    if(encfd[0] < 0) return -1;
-    uint8_t byte = 0;
-    fd_set rfds;
-    do{
-        FD_ZERO(&rfds);
-        FD_SET(encfd[0], &rfds);
-        struct timeval tv = encRtmout;
-        int retval = select(encfd[0] + 1, &rfds, NULL, NULL, &tv);
-        if(!retval) break;
-        if(retval < 0){
-            if(errno == EINTR) continue;
-            return -1;
-        }
-        if(FD_ISSET(encfd[0], &rfds)){
-            ssize_t l = read(encfd[0], &byte, 1);
-            if(l != 1) return -2; // disconnected ??
-            break;
-        } else return -1;
-    }while(1);
-    return (int)byte;
+    enchist_add(0, edata->encX, 0.);
+    enchist_add(1, edata->encY, 0.);
+    md_wrunlock();
+    //DBG("time = %zd+%zd/1e6, X=%g deg, Y=%g deg", tv->tv_sec, tv->tv_usec, Inst->ser.mountdata.encposition.X*180./M_PI, Inst->ser.mountdata.encposition.Y*180./M_PI);
+    return TRUE;
 }
 
 /**
@@ -175,7 +253,7 @@ static int getencbyte(){
  * @return amount of bytes read or -1 in case of error
  */
 static int readmntdata(uint8_t *buffer, int maxlen){
-    if(mntfd < 0){
+    if(Inst->ser.mntfd < 0){
         DBG("mntfd non opened");
         return -1;
     }
@@ -186,17 +264,17 @@ static int readmntdata(uint8_t *buffer, int maxlen){
     struct timeval tv = mnt1Rtmout;
     do{
         FD_ZERO(&rfds);
-        FD_SET(mntfd, &rfds);
+        FD_SET(Inst->ser.mntfd, &rfds);
         //DBG("select");
-        int retval = select(mntfd + 1, &rfds, NULL, NULL, &tv);
+        int retval = select(Inst->ser.mntfd + 1, &rfds, NULL, NULL, &tv);
         //DBG("returned %d", retval);
         if(retval < 0){
             if(errno == EINTR) continue;
             DBG("Error in select()");
             return -1;
         }
-        if(FD_ISSET(mntfd, &rfds)){
-            ssize_t l = read(mntfd, buffer, maxlen);
+        if(FD_ISSET(Inst->ser.mntfd, &rfds)){
+            ssize_t l = read(Inst->ser.mntfd, buffer, maxlen);
             if(l == 0){
                 DBG("read ZERO");
                 continue;
@@ -219,56 +297,105 @@ static int readmntdata(uint8_t *buffer, int maxlen){
 
 // clear data from input buffer
 static void clrmntbuf(){
-    if(mntfd < 0) return;
+    if(Inst->ser.mntfd < 0) return;
     uint8_t bytes[256];
     fd_set rfds;
     do{
         FD_ZERO(&rfds);
-        FD_SET(mntfd, &rfds);
+        FD_SET(Inst->ser.mntfd, &rfds);
         struct timeval tv = {.tv_sec=0, .tv_usec=10};
-        int retval = select(mntfd + 1, &rfds, NULL, NULL, &tv);
+        int retval = select(Inst->ser.mntfd + 1, &rfds, NULL, NULL, &tv);
         if(retval < 0){
             if(errno == EINTR) continue;
             DBG("Error in select()");
             break;
         }
-        if(FD_ISSET(mntfd, &rfds)){
-            ssize_t l = read(mntfd, &bytes, 256);
+        if(FD_ISSET(Inst->ser.mntfd, &rfds)){
+            ssize_t l = read(Inst->ser.mntfd, &bytes, 256);
             if(l < 1) break;
             DBG("clr got %zd bytes: %s", l, bytes);
         }else break;
     }while(1);
 }
 
-// main encoder thread (for separate encoder): read next data and make parsing
-static void *encoderthread1(void _U_ *u){
-    if(Conf.SepEncoder != 1) return NULL;
+/**
+ * @brief setrt - set real-time priority and CPU affinity of current thread by Conf.RTPriority and Conf.CPUMask
+ *          (errors aren't fatal: e.g. SCHED_FIFO needs CAP_SYS_NICE)
+ */
+void setrt(){
+    if(Inst->Conf.RTPriority > 0){
+        struct sched_param sp = {.sched_priority = Inst->Conf.RTPriority};
+        int e = pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp);
+        if(e){DBG("Can't set SCHED_FIFO priority %d: %s", Inst->Conf.RTPriority, strerror(e));}
+    }
+    if(Inst->Conf.CPUMask){
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for(int i = 0; i < (int)(8 * sizeof(Inst->Conf.CPUMask)); ++i)
+            if(Inst->Conf.CPUMask & (1u << i)) CPU_SET(i, &set);
+        int e = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if(e){DBG("Can't set CPU affinity 0x%x: %s", Inst->Conf.CPUMask, strerror(e));}
+    }
+}
+
+// size of read buffer for encoderthread1 (~20 packets)
+#define ENCRBUFSZ   (256)
+
+/**
+ * @brief encoderthread1 - main encoder thread (for separate encoder): read next data and make parsing
+ * All data available is read by one `read()` into local buffer, packets are framed inside it by ENC_MAGICK.
+ * Each packet stamped with time of poll() wakeup minus transmission time of bytes got after its end.
+ */
+static void *encoderthread1(void *inst){
+    Inst = (mntinst_t*)inst;
+    if(Inst->Conf.SepEncoder != 1) return NULL;
+    setrt();
+    uint8_t rbuf[ENCRBUFSZ];
     uint8_t databuf[ENC_DATALEN];
     int wridx = 0, errctr = 0;
-    struct timespec tcur;
-    while(encfd[0] > -1 && errctr < MAX_ERR_CTR && !GlobExit){
-        int b = getencbyte();
-        if(b == -2) ++errctr;
-        if(b < 0) continue;
+    // transmission time of one byte (start + 8 data + stop bits)
+    double bytetime = (Inst->Conf.EncoderDevSpeed > 0) ? 10. / (double)Inst->Conf.EncoderDevSpeed : 0.;
+    struct pollfd pfd = {.fd = Inst->ser.encfd[0], .events = POLLIN};
+    while(Inst->ser.encfd[0] > -1 && errctr < MAX_ERR_CTR && !Inst->ser.GlobExit){
+        int p = poll(&pfd, 1, 100);
+        if(p < 0){
+            if(errno == EINTR) continue;
+            DBG("poll()");
+            ++errctr;
+            continue;
+        }
+        if(p == 0 || !(pfd.revents & POLLIN)) continue;
+        struct timespec trecv;
+        if(!curtime(&trecv)) continue;
+        ssize_t l = read(Inst->ser.encfd[0], rbuf, ENCRBUFSZ);
+        if(l < 1){ // disconnected ??
+            ++errctr;
+            continue;
+        }
         errctr = 0;
-//        DBG("Got byte from Encoder: 0x%02X", b);
-        if(wridx == 0){
-            if((uint8_t)b == ENC_MAGICK){
-//                DBG("Got magic -> start filling packet");
-                databuf[wridx++] = (uint8_t) b;
+        for(ssize_t i = 0; i < l; ++i){
+            if(wridx == 0){
+                if(rbuf[i] == ENC_MAGICK) databuf[wridx++] = rbuf[i];
+                continue;
             }
-            continue;
-        }else databuf[wridx++] = (uint8_t) b;
-        if(wridx == ENC_DATALEN){
-            if(curtime(&tcur)){
-                parse_encbuf(databuf, &tcur);
+            databuf[wridx++] = rbuf[i];
+            if(wridx < ENC_DATALEN) continue;
+            struct timespec tpkt = trecv;
+            tsshift(&tpkt, -bytetime * (double)(l - 1 - i));
+            if(parse_encbuf(databuf, &tpkt)){
                 wridx = 0;
+                continue;
             }
+            // broken packet: try to resync by next magick inside it
+            int start = 1;
+            for(; start < ENC_DATALEN; ++start) if(databuf[start] == ENC_MAGICK) break;
+            wridx = ENC_DATALEN - start;
+            if(wridx) memmove(databuf, &databuf[start], wridx);
         }
     }
-    if(encfd[0] > -1){
-        close(encfd[0]);
-        encfd[0] = -1;
+    if(Inst->ser.encfd[0] > -1){
+        close(Inst->ser.encfd[0]);
+        Inst->ser.encfd[0] = -1;
     }
     return NULL;
 }
@@ -351,119 +478,189 @@ static int asknext(int fd){
     return FALSE;
 }
 
-// main encoder thread for separate encoders as USB devices /dev/encoder_X0 and /dev/encoder_Y0
-static void *encoderthread2(void _U_ *u){
-    if(Conf.SepEncoder != 2) return NULL;
+/**
+ * @brief encupdate - process last got data of both axes: Kalman filtering and speed calculation
+ * @param kf - filter
+ * @param mask - bit mask of axes having new data (bit 0 - X, bit 1 - Y)
+ * @param msr - raw encoders' data
+ * @param t - time of each measurement
+ * @param dt - time from previous measurement of each axis
+ */
+static void encupdate(kalman_t *kf, unsigned mask, const long msr[2], const struct timespec t[2], const double dt[2]){
+    const int32_t cnt[2] = {(int32_t)msr[0], (int32_t)msr[1]};
+    double pos[2];
+    SScnt2rad(&Inst->ss, SS_XENC, 2, cnt, pos, 1);
+    kalman_predict(kf, dt);
+    kalman_update(kf, pos, mask);
+    md_wrlock();
+    if(mask & 1){
+        Inst->ser.mountdata.encXposition.val = kalman_val(kf, 0, 0);
+        Inst->ser.mountdata.encXposition.t = t[0];
+        getXspeed();
+        kfspeed(0, kf);
+        enchist_add(0, (int32_t)msr[0], kalman_val(kf, 2, 0));
+    }
+    if(mask & 2){
+        Inst->ser.mountdata.encYposition.val = kalman_val(kf, 0, 1);
+        Inst->ser.mountdata.encYposition.t = t[1];
+        getYspeed();
+        kfspeed(1, kf);
+        enchist_add(1, (int32_t)msr[1], kalman_val(kf, 2, 1));
+    }
+    md_wrunlock();
+}
+
+// convert time interval in seconds into timespec
+static void dbl2ts(double t, struct timespec *ts){
+    ts->tv_sec = (time_t) t;
+    ts->tv_nsec = (long)((t - (double)ts->tv_sec) * 1e9);
+    if(ts->tv_nsec > 999999999L){ ++ts->tv_sec; ts->tv_nsec -= 1000000000L; }
+}
+
+// epoll data for encoders' thread: 0 and 1 - encoders, ENC_TIMER_ID - timer
+#define ENC_TIMER_ID    (2)
+
+/**
+ * @brief encoderthread2 - main encoder thread for separate encoders as USB devices /dev/encoder_X0 and /dev/encoder_Y0
+ * Thread sleeps in epoll_wait() until new data from any encoder came or periodic timer (timerfd with
+ * period Conf.EncoderReqInterval) fires. Each timer tick last fresh data (not older than 1.5 periods)
+ * of both axis is processed and new data portion requested.
+ */
+static void *encoderthread2(void *inst){
+    Inst = (mntinst_t*)inst;
+    if(Inst->Conf.SepEncoder != 2) return NULL;
     DBG("Thread started");
-    struct pollfd pfds[2];
-    pfds[0].fd = encfd[0]; pfds[0].events = POLLIN;
-    pfds[1].fd = encfd[1]; pfds[1].events = POLLIN;
-    double t0[2], tstart;
+    setrt();
+    int epfd = -1, tfd = -1;
     buf_t strbuf[2] = {0};
-    long msrlast[2]; // last encoder data
-    double mtlast[2]; // last measurement time
-    asknext(encfd[0]); asknext(encfd[1]);
-    t0[0] = t0[1] = tstart = timefromstart();
+    long msrlast[2] = {0}; // last encoder data
+    double mtlast[2] = {-1., -1.}; // last measurement time
     int errctr = 0;
-
     // init Kalman for both axes
-    Kalman3 kf[2];
-    double dt = Conf.EncoderReqInterval; // 1ms encoders step
-    double sigma_jx = 1e-6, sigma_jy = 1e-6; // "jerk" sigma
-    double xnoice = encoder_noise(X_ENC_STEPSPERREV);
-    double ynoice = encoder_noise(Y_ENC_STEPSPERREV);
-    kalman3_init(&kf[0], dt, xnoice);
-    kalman3_init(&kf[1], dt, ynoice);
-    kalman3_set_jerk_noise(&kf[0], sigma_jx);
-    kalman3_set_jerk_noise(&kf[1], sigma_jy);
-
+    kalman_t kf;
+    double sigma_j[2] = {1e-6, 1e-6}; // "jerk" sigma
+    double R[2] = {encoder_noise(X_ENC_STEPSPERREV), encoder_noise(Y_ENC_STEPSPERREV)};
+    unsigned encgen = atomic_load_explicit(&Inst->ser.encgen, memory_order_acquire);
+    if(!kalman_init(&kf, KF_MODEL_CA, Inst->Conf.EncoderReqInterval, R, sigma_j)){
+        DBG("Can't init Kalman filter");
+        goto ret;
+    }
+    struct timespec mts[2], kft[2]; // time of last measurement and of last data given to filter
+    int kfstarted[2] = {0};
+    // periodic timer and epoll
+    tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if(tfd < 0){
+        DBG("timerfd_create(): %s", strerror(errno));
+        goto ret;
+    }
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    if(epfd < 0){
+        DBG("epoll_create1(): %s", strerror(errno));
+        goto ret;
+    }
+    struct epoll_event ev = {.events = EPOLLIN};
+    for(int i = 0; i < 2; ++i){
+        ev.data.u32 = i;
+        if(epoll_ctl(epfd, EPOLL_CTL_ADD, Inst->ser.encfd[i], &ev)){
+            DBG("epoll_ctl(): %s", strerror(errno));
+            goto ret;
+        }
+    }
+    ev.data.u32 = ENC_TIMER_ID;
+    if(epoll_ctl(epfd, EPOLL_CTL_ADD, tfd, &ev)){
+        DBG("epoll_ctl(): %s", strerror(errno));
+        goto ret;
+    }
+    struct itimerspec its;
+    dbl2ts(Inst->Conf.EncoderReqInterval, &its.it_interval);
+    its.it_value = its.it_interval;
+    asknext(Inst->ser.encfd[0]); asknext(Inst->ser.encfd[1]);
+    if(timerfd_settime(tfd, 0, &its, NULL)){
+        DBG("timerfd_settime(): %s", strerror(errno));
+        goto ret;
+    }
+    struct epoll_event events[3];
     do{ // main cycle
-        if(poll(pfds, 2, 0) < 0){
-            DBG("poll()");
+        // timer fires each EncoderReqInterval, so 1s timeout is just for the case of hanged timer
+        int n = epoll_wait(epfd, events, 3, 1000);
+        if(n < 0){
+            if(errno == EINTR) continue;
+            DBG("epoll_wait()");
             break;
         }
+        if(n == 0){
+            DBG("Timer hangs?");
+            ++errctr;
+            continue;
+        }
+        int tick = 0;
+        for(int e = 0; e < n; ++e){
+            uint32_t id = events[e].data.u32;
+            if(id == ENC_TIMER_ID){
+                uint64_t expirations;
+                if(read(tfd, &expirations, sizeof(expirations)) > 0) tick = 1;
+                continue;
+            }
+            if(events[e].events & (EPOLLERR | EPOLLHUP)){
+                DBG("Encoder %u disconnected?", id);
+                ++errctr;
+                continue;
+            }
+            if(!readstrings(&strbuf[id], Inst->ser.encfd[id])){
+                DBG("ERR");
+                ++errctr;
+                continue;
+            }
+            if(getdata(&strbuf[id], &msrlast[id])){
+                mtlast[id] = timefromstart();
+                curtime(&mts[id]);
+            }
+        }
+        if(!tick) continue;
+        // encoders' constants changed: start filter again
+        unsigned g = atomic_load_explicit(&Inst->ser.encgen, memory_order_acquire);
+        if(g != encgen){
+            DBG("New encoders' constants");
+            encgen = g;
+            R[0] = encoder_noise(X_ENC_STEPSPERREV); R[1] = encoder_noise(Y_ENC_STEPSPERREV);
+            kalman_init(&kf, KF_MODEL_CA, Inst->Conf.EncoderReqInterval, R, sigma_j);
+            kfstarted[0] = kfstarted[1] = 0;
+        }
+        // time to process last records and ask next
+        double curt = timefromstart();
         int got = 0;
+        unsigned mask = 0;
+        double dt[2] = {0., 0.}; // real time from previous sample, so late samples are predicted correctly
         for(int i = 0; i < 2; ++i){
-            if(pfds[i].revents && POLLIN){
-                if(!readstrings(&strbuf[i], encfd[i])){
-                    DBG("ERR");
-                    ++errctr;
-                    break;
-                }
+            if(mtlast[i] >= 0. && curt - mtlast[i] < 1.5*Inst->Conf.EncoderReqInterval){
+                if(!kfstarted[i]){ // first sample: no prediction
+                    kfstarted[i] = 1;
+                    mask |= 1u << i;
+                }else if((dt[i] = timediff(&mts[i], &kft[i])) > 0.) mask |= 1u << i;
+                kft[i] = mts[i];
             }
-            double curt = timefromstart();
-            if(getdata(&strbuf[i], &msrlast[i])) mtlast[i] = curt;
-            if(curt - t0[i] >= Conf.EncoderReqInterval){ // get last records
-                //DBG("last rec %d, curt=%g, t0=%g, mtlast=%g", i, curt, t0[i], mtlast[i]);
-                if(curt - mtlast[i] < 1.5*Conf.EncoderReqInterval){
-                    //DBG("time OK");
-                    pthread_mutex_lock(&datamutex);
-                    double pos = (double)msrlast[i];
-                    if(i == 0){
-                        pos = Xenc2rad(pos);
-                        // Kalman filtering
-                        kalman3_predict(&kf[i]);
-                        kalman3_update(&kf[i], pos);
-                        //DBG("Got pos=%g, kalman: angle=%g, vel=%g, acc=%g",
-                        //    pos, kf[i].x[0], kf[i].x[1], kf[i].x[2]);
-                        mountdata.encXposition.val = kf[i].x[0];
-                        curtime(&mountdata.encXposition.t);
-                        /*DBG("msrlast=%ld, Xpos.val=%g, t=%zd; XEzero=%d, SPR=%g",
-                            msrlast[i], mountdata.encXposition.val, mountdata.encXposition.t.tv_sec,
-                            X_ENC_ZERO, X_ENC_STEPSPERREV);*/
-                        getXspeed();
-                        //mountdata.encXspeed.val = kf[i].x[1];
-                        //mountdata.encXspeed.t = mountdata.encXposition.t;
-                    }else{
-                        pos = Yenc2rad(pos);
-                        kalman3_predict(&kf[i]);
-                        kalman3_update(&kf[i], pos);
-                        //DBG("Got pos=%g, kalman: angle=%g, vel=%g, acc=%g",
-                        //    pos, kf[i].x[0], kf[i].x[1], kf[i].x[2]);
-                        mountdata.encYposition.val = kf[i].x[0];
-                        curtime(&mountdata.encYposition.t);
-                        getYspeed();
-                        //mountdata.encYspeed.val = kf[i].x[1];
-                        //mountdata.encYspeed.t = mountdata.encYposition.t;
-                    }
-                    pthread_mutex_unlock(&datamutex);
-                }
-                if(!asknext(encfd[i])){
-                    ++errctr;
-                    break;
-                }
-                t0[i] = (curt - t0[i] < 2.*Conf.EncoderReqInterval) ? t0[i] + Conf.EncoderReqInterval : curt;
-                ++got;
+            if(!asknext(Inst->ser.encfd[i])){
+                ++errctr;
+                continue;
             }
+            ++got;
         }
+        if(mask) encupdate(&kf, mask, msrlast, mts, dt);
         if(got == 2) errctr = 0;
-    }while(encfd[0] > -1 && encfd[1] > -1 && errctr < MAX_ERR_CTR && !GlobExit);
+    }while(Inst->ser.encfd[0] > -1 && Inst->ser.encfd[1] > -1 && errctr < MAX_ERR_CTR && !Inst->ser.GlobExit);
+ret:
     DBG("\n\nEXIT: ERRCTR=%d", errctr);
+    if(epfd > -1) close(epfd);
+    if(tfd > -1) close(tfd);
     for(int i = 0; i < 2; ++i){
-        if(encfd[i] > -1){
-            close(encfd[i]);
-            encfd[i] = -1;
+        if(Inst->ser.encfd[i] > -1){
+            close(Inst->ser.encfd[i]);
+            Inst->ser.encfd[i] = -1;
         }
     }
     return NULL;
 }
 
-data_t *cmd2dat(const char *cmd){
-    if(!cmd) return  NULL;
-    data_t *d = calloc(1, sizeof(data_t));
-    if(!d) return NULL;
-    d->buf = (uint8_t*)strdup(cmd);
-    d->len = strlen(cmd);
-    d->maxlen = d->len + 1;
-    return d;
-}
-void data_free(data_t **x){
-    if(!x || !*x) return;
-    free((*x)->buf);
-    free(*x);
-    *x = NULL;
-}
-
 static void chkModStopped(double *prev, double cur, int *nstopped, axis_status_t *stat){
     if(!prev || !nstopped || !stat) return;
     if(isnan(*prev)){
@@ -504,74 +701,115 @@ static axis_status_t chkstopstat(int32_t *prev, int32_t cur, int32_t tag, int *n
 
 // check for stopped/pointing states
 static void ChkStopped(const SSstat *s, mountdata_t *m){
-    static int32_t Xmot_prev = INT32_MAX, Ymot_prev = INT32_MAX; // previous coordinates
-    static int Xnstopped = 0, Ynstopped = 0; // counters to get STOPPED state
+    serial_state_t *S = &Inst->ser;
     axis_status_t Xstat, Ystat;
-    Xstat = chkstopstat(&Xmot_prev, s->Xmot, m->Xtarget, &Xnstopped, m->Xstate);
-    Ystat = chkstopstat(&Ymot_prev, s->Ymot, m->Ytarget, &Ynstopped, m->Ystate);
+    Xstat = chkstopstat(&S->Xmot_prev, s->Xmot, m->Xtarget, &S->Xnstopped, m->Xstate);
+    Ystat = chkstopstat(&S->Ymot_prev, s->Ymot, m->Ytarget, &S->Ynstopped, m->Ystate);
     if(Xstat != m->Xstate || Ystat != m->Ystate){
         DBG("Status changed");
-        mountdata.Xstate = Xstat;
-        mountdata.Ystate = Ystat;
+        Inst->ser.mountdata.Xstate = Xstat;
+        Inst->ser.mountdata.Ystate = Ystat;
     }
 }
 
+// status request: time of request is stored too
+typedef struct{
+    const data_t *cmd;
+    data_t *ans;
+    struct timespec t;
+} statjob_t;
+static int statjob(void *arg){
+    statjob_t *j = (statjob_t*)arg;
+    if(!curtime(&j->t)) return FALSE;
+    return wr(j->cmd, j->ans, 1);
+}
+
 // main mount thread
-static void *mountthread(void _U_ *u){
+static void *mountthread(void *inst){
+    Inst = (mntinst_t*)inst;
     int errctr = 0;
     uint8_t buf[sizeof(SSstat)];
     SSstat *status = (SSstat*) buf;
-    bzero(&mountdata, sizeof(mountdata));
-    double t0 = timefromstart(), tstart = t0, tcur = t0;
+    setrt();
+    md_wrlock();
+    bzero(&Inst->ser.mountdata, sizeof(Inst->ser.mountdata));
+    md_wrunlock();
+    double tstart = timefromstart(), tcur = tstart;
+    struct timespec deadline; // end of current loop period
+    vclock_attach(Inst->ser.mntslot);
+    vclock_now(&deadline);
     double oldmt = -100.; // old `millis measurement` time
-    static uint32_t oldmillis = 0;
-    if(Conf.RunModel){
+    if(Inst->Conf.ReplayPath){ // give recorded data at the same times
+        mountdata_t md;
+        double t;
+        while(!Inst->ser.GlobExit && replay_next(&md, &t)){
+            double dt = t - timefromstart();
+            if(dt > 0.){ // sleep by parts till absolute deadline (rounding of relative ones could stop clock)
+                struct timespec until, next;
+                vclock_now(&until);
+                tsshift(&until, dt);
+                do{
+                    vclock_now(&next);
+                    tsshift(&next, REPLAY_MAXSLEEP);
+                    if(timediff(&until, &next) < 0.) next = until;
+                }while(vclock_sleepuntil(&next) && !Inst->ser.GlobExit && timediff(&until, &next) > 0.);
+            }
+            md_wrlock();
+            Inst->ser.mountdata = md;
+            pec_learn(&md);
+            md_wrunlock();
+        }
+        DBG("Replay ends");
+        vclock_release();
+        return NULL;
+    }
+    if(Inst->Conf.RunModel){
         double Xprev = NAN, Yprev = NAN; // previous coordinates
         int xcnt = 0, ycnt = 0;
-        while(!GlobExit){
+        uint32_t seed = vclock_seed();
+        unsigned short xsubi[3] = {0x330e, (unsigned short)seed, (unsigned short)(seed >> 16)};
+        while(!Inst->ser.GlobExit){
             coordpair_t c;
             movestate_t xst, yst;
             // now change data
             getModData(&c, &xst, &yst);
             struct timespec tnow;
             if(!curtime(&tnow) || (tcur = timefromstart()) < 0.) continue;
-            pthread_mutex_lock(&datamutex);
-            mountdata.encXposition.t = mountdata.encYposition.t = tnow;
-            mountdata.encXposition.val = c.X + (drand48() - 0.5)*1e-6; // .2arcsec error
-            mountdata.encYposition.val = c.Y + (drand48() - 0.5)*1e-6;
+            md_wrlock();
+            Inst->ser.mountdata.encXposition.t = Inst->ser.mountdata.encYposition.t = tnow;
+            Inst->ser.mountdata.encXposition.val = c.X + (erand48(xsubi) - 0.5)*1e-6; // .2arcsec error
+            Inst->ser.mountdata.encYposition.val = c.Y + (erand48(xsubi) - 0.5)*1e-6;
             //DBG("t=%g, X=%g, Y=%g", tnow, c.X.val, c.Y.val);
-            if(tcur - oldmt > Conf.MountReqInterval){
-                oldmillis = mountdata.millis = (uint32_t)((tcur - tstart) * 1e3);
-                mountdata.motYposition.t = mountdata.motXposition.t = tnow;
+            if(tcur - oldmt > Inst->Conf.MountReqInterval){
+                Inst->ser.oldmillis = Inst->ser.mountdata.millis = (uint32_t)((tcur - tstart) * 1e3);
+                Inst->ser.mountdata.motYposition.t = Inst->ser.mountdata.motXposition.t = tnow;
                 if(xst == ST_MOVE)
-                    mountdata.motXposition.val = c.X + (c.X - mountdata.motXposition.val)*(drand48() - 0.5)/100.;
+                    Inst->ser.mountdata.motXposition.val = c.X + (c.X - Inst->ser.mountdata.motXposition.val)*(erand48(xsubi) - 0.5)/100.;
                 //else
-                //    mountdata.motXposition.val = c.X;
+                //    Inst->ser.mountdata.motXposition.val = c.X;
                 if(yst == ST_MOVE)
-                    mountdata.motYposition.val = c.Y + (c.Y - mountdata.motYposition.val)*(drand48() - 0.5)/100.;
+                    Inst->ser.mountdata.motYposition.val = c.Y + (c.Y - Inst->ser.mountdata.motYposition.val)*(erand48(xsubi) - 0.5)/100.;
                 //else
-                //    mountdata.motYposition.val = c.Y;
+                //    Inst->ser.mountdata.motYposition.val = c.Y;
                 oldmt = tcur;
-            }else mountdata.millis = oldmillis;
-            chkModStopped(&Xprev, c.X, &xcnt, &mountdata.Xstate);
-            chkModStopped(&Yprev, c.Y, &ycnt, &mountdata.Ystate);
+            }else Inst->ser.mountdata.millis = Inst->ser.oldmillis;
+            chkModStopped(&Xprev, c.X, &xcnt, &Inst->ser.mountdata.Xstate);
+            chkModStopped(&Yprev, c.Y, &ycnt, &Inst->ser.mountdata.Ystate);
             getXspeed(); getYspeed();
-            pthread_mutex_unlock(&datamutex);
-            while(timefromstart() - t0 < Conf.EncoderReqInterval) usleep(50);
-            t0 = timefromstart();
+            enchist_add(0, 0, 0.);
+            enchist_add(1, 0, 0.);
+            md_wrunlock();
+            period_wait(&deadline, Inst->Conf.EncoderReqInterval, &Inst->Stats.mountJitter);
         }
+        vclock_release();
+        return NULL;
     }
     // data to get
     data_t d = {.buf = buf, .maxlen = sizeof(buf)};
-    // cmd to send
-    data_t *cmd_getstat = cmd2dat(CMD_GETSTAT);
-    if(!cmd_getstat) goto failed;
-    while(mntfd > -1 && errctr < MAX_ERR_CTR && !GlobExit){
-        // read data to status
-        struct timespec tcur;
-        if(!curtime(&tcur)) continue;
-        // 80 milliseconds to get answer on GETSTAT
-        if(!MountWriteRead(cmd_getstat, &d) || d.len != sizeof(SSstat)){
+    while(Inst->ser.mntfd > -1 && errctr < MAX_ERR_CTR && !Inst->ser.GlobExit){
+        // read data to status; 80 milliseconds to get answer on GETSTAT
+        statjob_t sj = {.cmd = &dgetstat, .ans = &d};
+        if(!mntjob_run(MCC_CMD_STATUS, statjob, &sj) || d.len != sizeof(SSstat)){
 #ifdef EBUG
             DBG("Can't read SSstat, need %zd got %zd bytes", sizeof(SSstat), d.len);
             for(size_t i = 0; i < d.len; ++i) printf("%02X ", d.buf[i]);
@@ -584,26 +822,246 @@ static void *mountthread(void _U_ *u){
             ++errctr; continue;
         }
         errctr = 0;
-        pthread_mutex_lock(&datamutex);
+        md_wrlock();
         // now change data
-        SSconvstat(status, &mountdata, &tcur);
-        ChkStopped(status, &mountdata);
-        pthread_mutex_unlock(&datamutex);
-        // allow writing & getters
-        do{
-            usleep(500);
-        }while(timefromstart() - t0 < Conf.MountReqInterval);
-        t0 = timefromstart();
-    }
-    data_free(&cmd_getstat);
-failed:
-    if(mntfd > -1){
-        close(mntfd);
-        mntfd = -1;
+        SSconvstat(status, &Inst->ser.mountdata, &sj.t);
+        if(!Inst->Conf.SepEncoder){ // encoders' data got from SSII
+            enchist_add(0, status->Xenc, 0.);
+            enchist_add(1, status->Yenc, 0.);
+        }
+        ChkStopped(status, &Inst->ser.mountdata);
+        pec_learn(&Inst->ser.mountdata);
+        md_wrunlock();
+        if(!period_wait(&deadline, Inst->Conf.MountReqInterval, &Inst->Stats.mountJitter)){DBG("Mount status request is late");}
+    }
+    if(Inst->ser.mntfd > -1){
+        close(Inst->ser.mntfd);
+        Inst->ser.mntfd = -1;
+    }
+    return NULL;
+}
+
+// get asynchronous job from pool; @return NULL if pool is empty (queue is full: caller should retry later)
+static mntjob_t *jobget(){
+    pthread_mutex_lock(&Inst->ser.qmutex);
+    if(!Inst->ser.poolready){
+        for(int i = 0; i < MNTJOB_POOLSZ; ++i)
+            Inst->ser.jobpool[i].next = (i < MNTJOB_POOLSZ - 1) ? &Inst->ser.jobpool[i + 1] : NULL;
+        Inst->ser.freejobs = Inst->ser.jobpool;
+        Inst->ser.poolready = 1;
+    }
+    mntjob_t *j = Inst->ser.freejobs;
+    if(j) Inst->ser.freejobs = j->next;
+    pthread_mutex_unlock(&Inst->ser.qmutex);
+    if(!j){
+        DBG("Pool of jobs is empty");
+        atomic_fetch_add_explicit(&Inst->Stats.asyncRejected, 1, memory_order_relaxed);
+    }
+    return j;
+}
+
+// return asynchronous job into pool
+static void jobput(mntjob_t *j){
+    pthread_mutex_lock(&Inst->ser.qmutex);
+    j->next = Inst->ser.freejobs;
+    Inst->ser.freejobs = j;
+    pthread_mutex_unlock(&Inst->ser.qmutex);
+}
+
+/**
+ * @brief jobdone - finish job: store result, call callback and wake waiters
+ * @param j - job
+ * @param ret - value returned by job function
+ */
+static void jobdone(mntjob_t *j, int ret){
+    hist_add(&Inst->Stats.cmdLatency[j->cls], timefromstart() - j->tsubmit);
+    if(j->cb) j->cb(ret ? MCC_E_OK : MCC_E_FAILED, j->cbarg);
+    if(j->detached){
+        jobput(j);
+        return;
+    }
+    pthread_mutex_lock(&Inst->ser.qmutex);
+    j->ret = ret;
+    j->done = 1;
+    pthread_cond_broadcast(&Inst->ser.donecond);
+    pthread_mutex_unlock(&Inst->ser.qmutex);
+}
+
+// put job into queue; if I/O thread isn't running, job is finished as failed
+static void enqueue(mntjob_t *j){
+    j->tsubmit = timefromstart();
+    j->next = NULL;
+    pthread_mutex_lock(&Inst->ser.qmutex);
+    if(!Inst->ser.ioq.running){
+        pthread_mutex_unlock(&Inst->ser.qmutex);
+        DBG("I/O thread isn't running");
+        jobdone(j, FALSE);
+        return;
+    }
+    if(Inst->ser.ioq.tail[j->cls]) Inst->ser.ioq.tail[j->cls]->next = j;
+    else Inst->ser.ioq.head[j->cls] = j;
+    Inst->ser.ioq.tail[j->cls] = j;
+    pthread_cond_signal(&Inst->ser.qcond);
+    pthread_mutex_unlock(&Inst->ser.qmutex);
+}
+
+/**
+ * @brief mntiothread - the only thread working with mount device: runs jobs in order of priority;
+ *      after stop all jobs left in queue are finished as failed
+ */
+static void *mntiothread(void *inst){
+    Inst = (mntinst_t*)inst;
+    setrt();
+    pthread_mutex_lock(&Inst->ser.qmutex);
+    while(1){
+        mntjob_t *j = NULL;
+        for(int c = 0; c < MCC_CMD_AMOUNT && !j; ++c){
+            if((j = Inst->ser.ioq.head[c])){
+                Inst->ser.ioq.head[c] = j->next;
+                if(!Inst->ser.ioq.head[c]) Inst->ser.ioq.tail[c] = NULL;
+            }
+        }
+        if(!j){
+            if(!Inst->ser.ioq.running) break;
+            pthread_cond_wait(&Inst->ser.qcond, &Inst->ser.qmutex);
+            continue;
+        }
+        int run = Inst->ser.ioq.running;
+        pthread_mutex_unlock(&Inst->ser.qmutex);
+        int ret = FALSE;
+        if(run){
+            pthread_mutex_lock(&Inst->ser.mntmutex);
+            double t0 = timefromstart();
+            ret = j->fn(j->arg);
+            hist_add(&Inst->Stats.cmdRTT[j->cls], timefromstart() - t0);
+            pthread_mutex_unlock(&Inst->ser.mntmutex);
+        }
+        jobdone(j, ret);
+        pthread_mutex_lock(&Inst->ser.qmutex);
     }
+    pthread_mutex_unlock(&Inst->ser.qmutex);
+    DBG("I/O thread exit");
     return NULL;
 }
 
+// start I/O thread (if not started yet); @return FALSE if failed
+static int mntio_start(){
+    pthread_mutex_lock(&Inst->ser.qmutex);
+    int ret = TRUE;
+    if(!Inst->ser.ioq.running){
+        Inst->ser.ioq.running = 1;
+        if(pthread_create(&Inst->ser.iothread, NULL, mntiothread, Inst)){
+            DBG("Can't create I/O thread");
+            Inst->ser.ioq.running = 0;
+            ret = FALSE;
+        }
+    }
+    pthread_mutex_unlock(&Inst->ser.qmutex);
+    return ret;
+}
+
+// stop I/O thread and wait until all jobs done
+static void mntio_stop(){
+    pthread_mutex_lock(&Inst->ser.qmutex);
+    int running = Inst->ser.ioq.running;
+    Inst->ser.ioq.running = 0;
+    pthread_cond_signal(&Inst->ser.qcond);
+    pthread_mutex_unlock(&Inst->ser.qmutex);
+    if(running) pthread_join(Inst->ser.iothread, NULL);
+}
+
+/**
+ * @brief mntjob_run - run job in I/O thread and wait for its end
+ * @param cls - class (priority) of job
+ * @param fn - function to run
+ * @param arg - its argument
+ * @return value returned by `fn` or FALSE if I/O thread isn't running
+ */
+int mntjob_run(mcc_cmdclass_t cls, mntjobfn_t fn, void *arg){
+    if(!fn || cls >= MCC_CMD_AMOUNT) return FALSE;
+    mntjob_t j = {.fn = fn, .arg = arg, .cls = cls};
+    enqueue(&j);
+    pthread_mutex_lock(&Inst->ser.qmutex);
+    while(!j.done) pthread_cond_wait(&Inst->ser.donecond, &Inst->ser.qmutex);
+    pthread_mutex_unlock(&Inst->ser.qmutex);
+    return j.ret;
+}
+
+/**
+ * @brief mntjob_submit - put job into I/O queue and return immediately
+ * @param cls - class (priority) of job
+ * @param fn - function to run
+ * @param data - data for `fn` (copied into job, so caller can free it at once)
+ * @param len - length of `data` (not more than MNTJOB_DATASZ)
+ * @param cb - callback to run after job done (or NULL)
+ * @param cbarg - its argument
+ * @return FALSE if arguments are wrong or queue is full (MNTJOB_POOLSZ jobs waiting)
+ */
+int mntjob_submit(mcc_cmdclass_t cls, mntjobfn_t fn, const void *data, size_t len, mcc_cmdcb_t cb, void *cbarg){
+    if(!fn || cls >= MCC_CMD_AMOUNT || len > MNTJOB_DATASZ || (len && !data)) return FALSE;
+    mntjob_t *j = jobget();
+    if(!j) return FALSE;
+    j->fn = fn; j->cb = cb; j->cbarg = cbarg;
+    j->cls = cls;
+    j->detached = 1;
+    j->done = j->ret = 0;
+    if(len) memcpy(j->data, data, len);
+    j->arg = j->data;
+    enqueue(j);
+    return TRUE;
+}
+
+/**
+ * @brief getCmdLatency - get latency histogram of given class of commands
+ * @param cls - class
+ * @param h (o) - histogram
+ * @return errcode
+ */
+mcc_errcodes_t getCmdLatency(mcc_cmdclass_t cls, mcc_hist_t *h){
+    if(!h || cls >= MCC_CMD_AMOUNT) return MCC_E_BADFORMAT;
+    hist_get(&Inst->Stats.cmdLatency[cls], h);
+    return MCC_E_OK;
+}
+
+// data for simple write-read job
+typedef struct{
+    const data_t *out;
+    data_t *in;
+    int needeol;
+} wrjob_t;
+static int wrjob(void *arg){
+    wrjob_t *j = (wrjob_t*)arg;
+    return wr(j->out, j->in, j->needeol);
+}
+
+/**
+ * @brief MountWriteReadCls - write and read @ once (or only read/write) with given priority
+ * @param out (o) - data to write or NULL if not need
+ * @param in  (i) - data to read or NULL if not need
+ * @param needeol - ==1 to add EOL after `out`
+ * @param cls - class (priority) of command
+ * @return FALSE if failed
+ */
+int MountWriteReadCls(const data_t *out, data_t *in, int needeol, mcc_cmdclass_t cls){
+    if(Inst->Conf.RunModel) return FALSE;
+    wrjob_t j = {.out = out, .in = in, .needeol = needeol};
+    return mntjob_run(cls, wrjob, &j);
+}
+
+/**
+ * @brief MountWriteRead - write and read @ once (or only read/write)
+ * @param out (o) - data to write or NULL if not need
+ * @param in  (i) - data to read or NULL if not need
+ * @return FALSE if failed
+ */
+int MountWriteRead(const data_t *out, data_t *in){
+    return MountWriteReadCls(out, in, 1, MCC_CMD_OTHER);
+}
+// send binary data - without EOL
+int MountWriteReadRaw(const data_t *out, data_t *in){
+    return MountWriteReadCls(out, in, 0, MCC_CMD_OTHER);
+}
+
 // open device and return its FD or -1
 static int ttyopen(const char *path, speed_t speed){
     int fd = -1;
@@ -642,34 +1100,30 @@ static int ttyopen(const char *path, speed_t speed){
 // return FALSE if failed
 int openEncoder(){
     // TODO: open real devices in "model" mode too!
-    if(Conf.RunModel) return TRUE;
-    if(!Conf.SepEncoder) return FALSE; // try to open separate encoder when it's absent
-    /*
-    encRtmout.tv_sec = 0;
-    encRtmout.tv_usec = 100000000 / Conf.EncoderDevSpeed; // 10 bytes
-*/
-    if(Conf.SepEncoder == 1){ // only one device
+    if(Inst->Conf.RunModel || Inst->Conf.ReplayPath) return TRUE;
+    if(!Inst->Conf.SepEncoder) return FALSE; // try to open separate encoder when it's absent
+    if(Inst->Conf.SepEncoder == 1){ // only one device
         DBG("One device");
-        if(encfd[0] > -1) close(encfd[0]);
-        encfd[0] = ttyopen(Conf.EncoderDevPath, (speed_t) Conf.EncoderDevSpeed);
-        if(encfd[0] < 0) return FALSE;
-        if(pthread_create(&encthread, NULL, encoderthread1, NULL)){
-            close(encfd[0]);
-            encfd[0] = -1;
+        if(Inst->ser.encfd[0] > -1) close(Inst->ser.encfd[0]);
+        Inst->ser.encfd[0] = ttyopen(Inst->Conf.EncoderDevPath, (speed_t) Inst->Conf.EncoderDevSpeed);
+        if(Inst->ser.encfd[0] < 0) return FALSE;
+        if(pthread_create(&Inst->ser.encthread, NULL, encoderthread1, Inst)){
+            close(Inst->ser.encfd[0]);
+            Inst->ser.encfd[0] = -1;
             return FALSE;
         }
-    }else if(Conf.SepEncoder == 2){
+    }else if(Inst->Conf.SepEncoder == 2){
         DBG("Two devices!");
-        const char* paths[2] = {Conf.EncoderXDevPath, Conf.EncoderYDevPath};
+        const char* paths[2] = {Inst->Conf.EncoderXDevPath, Inst->Conf.EncoderYDevPath};
         for(int i = 0; i < 2; ++i){
-            if(encfd[i] > -1) close(encfd[i]);
-            encfd[i] = ttyopen(paths[i], (speed_t) Conf.EncoderDevSpeed);
-            if(encfd[i] < 0) return FALSE;
+            if(Inst->ser.encfd[i] > -1) close(Inst->ser.encfd[i]);
+            Inst->ser.encfd[i] = ttyopen(paths[i], (speed_t) Inst->Conf.EncoderDevSpeed);
+            if(Inst->ser.encfd[i] < 0) return FALSE;
         }
-        if(pthread_create(&encthread, NULL, encoderthread2, NULL)){
+        if(pthread_create(&Inst->ser.encthread, NULL, encoderthread2, Inst)){
             for(int i = 0; i < 2; ++i){
-                close(encfd[i]);
-                encfd[i] = -1;
+                close(Inst->ser.encfd[i]);
+                Inst->ser.encfd[i] = -1;
             }
             return FALSE;
         }
@@ -681,14 +1135,27 @@ int openEncoder(){
 // return FALSE if failed
 int openMount(){
     // TODO: open real devices in "model" mode too!
-    if(Conf.RunModel) goto create_thread;
-    if(mntfd > -1) close(mntfd);
-    DBG("Open mount %s @ %d", Conf.MountDevPath, Conf.MountDevSpeed);
-    mntfd = ttyopen(Conf.MountDevPath, (speed_t) Conf.MountDevSpeed);
-    if(mntfd < 0) return FALSE;
-    DBG("mntfd=%d", mntfd);
+    if(Inst->Conf.RunModel) goto create_thread;
+    if(Inst->Conf.ReplayPath){ // transactions are answered by log, so I/O thread works without device
+        if(!replay_open(Inst->Conf.ReplayPath)) return FALSE;
+        if(!mntio_start()){
+            replay_close();
+            return FALSE;
+        }
+        goto create_thread;
+    }
+    if(Inst->ser.mntfd > -1) close(Inst->ser.mntfd);
+    DBG("Open mount %s @ %d", Inst->Conf.MountDevPath, Inst->Conf.MountDevSpeed);
+    Inst->ser.mntfd = ttyopen(Inst->Conf.MountDevPath, (speed_t) Inst->Conf.MountDevSpeed);
+    if(Inst->ser.mntfd < 0) return FALSE;
+    DBG("mntfd=%d", Inst->ser.mntfd);
     // clear buffer
     clrmntbuf();
+    if(!mntio_start()){
+        close(Inst->ser.mntfd);
+        Inst->ser.mntfd = -1;
+        return FALSE;
+    }
     /*
     mnt1Rtmout.tv_sec = 0;
     mnt1Rtmout.tv_usec = 500000000 / Conf.MountDevSpeed; // 50 bytes * 10bits / speed
@@ -696,56 +1163,87 @@ int openMount(){
     mntRtmout.tv_usec = mnt1Rtmout.tv_usec / 50;
 */
 create_thread:
-    if(pthread_create(&mntthread, NULL, mountthread, NULL)){
+    if(Inst->Conf.RunModel || Inst->Conf.ReplayPath) Inst->ser.mntslot = vclock_register(); // they work by virtual clock if it's active
+    if(pthread_create(&Inst->ser.mntthread, NULL, mountthread, Inst)){
         DBG("Can't create mount thread");
-        if(!Conf.RunModel){
-            close(mntfd);
-            mntfd = -1;
+        vclock_unregister(Inst->ser.mntslot);
+        Inst->ser.mntslot = -1;
+        if(!Inst->Conf.RunModel){
+            close(Inst->ser.mntfd);
+            Inst->ser.mntfd = -1;
         }
         return FALSE;
     }
+    Inst->ser.mntstarted = 1;
     DBG("Mount opened, thread started");
     return TRUE;
 }
 
 // close all opened serial devices and quit threads
 void closeSerial(){
-    GlobExit = 1;
-    pthread_mutex_unlock(&datamutex);
+    Inst->ser.GlobExit = 1;
     DBG("Give 100ms to proper close");
     usleep(100000);
+    DBG("Stop I/O thread");
+    mntio_stop();
     DBG("Force closed all devices");
-    if(mntfd > -1){
-        DBG("Cancel mount thread");
-        pthread_cancel(mntthread);
+    if(Inst->ser.mntstarted){
+        if(Inst->Conf.RunModel || Inst->Conf.ReplayPath){ // model and replay threads exit by GlobExit
+            DBG("Stop model or replay");
+            vclock_interrupt(Inst->ser.mntslot);
+        }else{
+            DBG("Cancel mount thread");
+            pthread_cancel(Inst->ser.mntthread);
+        }
         DBG("join mount thread");
-        pthread_join(mntthread, NULL);
+        pthread_join(Inst->ser.mntthread, NULL);
+        Inst->ser.mntstarted = 0;
+        Inst->ser.mntslot = -1;
+    }
+    if(Inst->Conf.ReplayPath) replay_close();
+    if(Inst->ser.mntfd > -1){
         DBG("close mount fd");
-        if(mntfd > -1) close(mntfd);
-        mntfd = -1;
+        close(Inst->ser.mntfd);
+        Inst->ser.mntfd = -1;
     }
-    if(encfd[0] > -1){
+    if(Inst->ser.encfd[0] > -1){
         DBG("Cancel encoder thread");
-        pthread_cancel(encthread);
+        pthread_cancel(Inst->ser.encthread);
         DBG("join encoder thread");
-        pthread_join(encthread, NULL);
+        pthread_join(Inst->ser.encthread, NULL);
         DBG("close encoder's fd");
-        if(encfd[0] > -1) close(encfd[0]);
-        encfd[0] = -1;
-        if(Conf.SepEncoder == 2 && encfd[1] > -1){
-            close(encfd[1]);
-            encfd[1] = -1;
+        if(Inst->ser.encfd[0] > -1) close(Inst->ser.encfd[0]);
+        Inst->ser.encfd[0] = -1;
+        if(Inst->Conf.SepEncoder == 2 && Inst->ser.encfd[1] > -1){
+            close(Inst->ser.encfd[1]);
+            Inst->ser.encfd[1] = -1;
         }
     }
-    GlobExit = 0;
+    // forget data of this session
+    enchist_clear();
+    LS_delete(&Inst->ser.ls[0]);
+    LS_delete(&Inst->ser.ls[1]);
+    bzero(Inst->ser.enctlast, sizeof(Inst->ser.enctlast));
+    Inst->ser.Xmot_prev = Inst->ser.Ymot_prev = INT32_MAX;
+    Inst->ser.GlobExit = 0;
 }
 
 // get fresh encoder information
 mcc_errcodes_t getMD(mountdata_t  *d){
     if(!d) return MCC_E_BADFORMAT;
-    pthread_mutex_lock(&datamutex);
-    *d = mountdata;
-    pthread_mutex_unlock(&datamutex);
+    unsigned s0, s1;
+    int ntries = 0;
+    do{
+        s0 = atomic_load_explicit(&Inst->ser.mdseq, memory_order_acquire);
+        if(s0 & 1){ // writer is working now
+            if(++ntries > 100) sched_yield();
+            s1 = s0 + 1;
+            continue;
+        }
+        memcpy(d, &Inst->ser.mountdata, sizeof(mountdata_t));
+        atomic_thread_fence(memory_order_acquire);
+        s1 = atomic_load_explicit(&Inst->ser.mdseq, memory_order_relaxed);
+    }while(s0 != s1);
     //DBG("ENCpos: %.10g/%.10g", d->encXposition.val, d->encYposition.val);
     //DBG("millis: %u, encxt: %zd (time: %zd)", d->millis, d->encXposition.t.tv_sec, time(NULL));
     return MCC_E_OK;
@@ -753,31 +1251,34 @@ mcc_errcodes_t getMD(mountdata_t  *d){
 
 void setStat(axis_status_t Xstate, axis_status_t Ystate){
     DBG("set x/y state to %d/%d", Xstate, Ystate);
-    pthread_mutex_lock(&datamutex);
-    mountdata.Xstate = Xstate;
-    mountdata.Ystate = Ystate;
-    pthread_mutex_unlock(&datamutex);
+    md_wrlock();
+    Inst->ser.mountdata.Xstate = Xstate;
+    Inst->ser.mountdata.Ystate = Ystate;
+    md_wrunlock();
 }
 
-// write-read without locking mutex (to be used inside other functions)
-static int wr(const data_t *out, data_t *in, int needeol){
-    if((!out && !in) || mntfd < 0){
+/**
+ * @brief wrdev - write-read with device: all parts of output are written by one writev(), then answer is read
+ * @param iov - parts of output
+ * @param niov - their amount (0 if only read needed)
+ * @param in (o) - answer or NULL
+ * @return FALSE if failed
+ */
+static int wrdev(const struct iovec *iov, int niov, data_t *in){
+    if(in) in->len = 0;
+    if((!niov && !in) || Inst->ser.mntfd < 0){
         DBG("Wrong arguments or no mount fd");
         return FALSE;
     }
     //DBG("clrbuf");
     clrmntbuf();
-    if(out){
-        //DBG("write %zd bytes (%s)", out->len, out->buf);
-        if(out->len != (size_t)write(mntfd, out->buf, out->len)){
+    if(niov){
+        ssize_t need = 0;
+        for(int i = 0; i < niov; ++i) need += (ssize_t)iov[i].iov_len;
+        if(need != writev(Inst->ser.mntfd, iov, niov)){
             DBG("written bytes not equal to need");
             return FALSE;
         }
-        //DBG("eol, mntfd=%d", mntfd);
-        if(needeol){
-            int g = write(mntfd, "\r", 1); // add EOL
-            (void) g;
-        }
         //usleep(50000); // add little pause so that the idiot has time to swallow
     }
     if(!in || in->maxlen < 1) return TRUE;
@@ -791,27 +1292,49 @@ static int wr(const data_t *out, data_t *in, int needeol){
     return TRUE;
 }
 
+// part of output with EOL
+#define IOVDATA(d)  ((struct iovec){.iov_base = (d)->buf, .iov_len = (d)->len})
+#define IOVEOL      ((struct iovec){.iov_base = "\r", .iov_len = 1})
+
+// write-read without locking mutex (to be used inside other functions); in replay mode answers are taken from log
+static int wr(const data_t *out, data_t *in, int needeol){
+    if(!out && !in) return FALSE;
+    int ret;
+    if(Inst->Conf.ReplayPath) ret = replay_io(out, needeol, in);
+    else{
+        struct iovec iov[2];
+        int n = 0;
+        if(out){
+            iov[n++] = IOVDATA(out);
+            if(needeol) iov[n++] = IOVEOL;
+        }
+        ret = wrdev(iov, n, in);
+    }
+    tlog_io(out, needeol, in, ret);
+    return ret;
+}
+
 /**
- * @brief MountWriteRead - write and read @ once (or only read/write)
- * @param out (o) - data to write or NULL if not need
- * @param in  (i) - data to read or NULL if not need
+ * @brief wrframe - send text command with EOL and binary data following it by one write, then read answer;
+ *      in log and replay these are two transactions as for separate writing
+ * @param cmd - text command
+ * @param bin - binary data
+ * @param in (o) - answer or NULL
  * @return FALSE if failed
  */
-int MountWriteRead(const data_t *out, data_t *in){
-    if(Conf.RunModel) return FALSE;
-    //double t0 = timefromstart();
-    pthread_mutex_lock(&mntmutex);
-    int ret = wr(out, in, 1);
-    pthread_mutex_unlock(&mntmutex);
-    //DBG("Got %gus", (timefromstart()-t0)*1e6);
-    return ret;
-}
-// send binary data - without EOL
-int MountWriteReadRaw(const data_t *out, data_t *in){
-    if(Conf.RunModel) return FALSE;
-    pthread_mutex_lock(&mntmutex);
-    int ret = wr(out, in, 0);
-    pthread_mutex_unlock(&mntmutex);
+static int wrframe(const data_t *cmd, const data_t *bin, data_t *in){
+    int ret;
+    if(Inst->Conf.ReplayPath){
+        ret = replay_io(cmd, 1, NULL);
+        tlog_io(cmd, 1, NULL, ret);
+        if(!ret) return FALSE;
+        ret = replay_io(bin, 0, in);
+    }else{
+        struct iovec iov[3] = {IOVDATA(cmd), IOVEOL, IOVDATA(bin)};
+        ret = wrdev(iov, 3, in);
+        tlog_io(cmd, 1, NULL, ret);
+    }
+    tlog_io(bin, 0, in, ret);
     return ret;
 }
 
@@ -830,50 +1353,70 @@ static void loglcmd(SSlcmd *c){
 }
 #endif
 
-// send short/long binary command; return FALSE if failed
-static int bincmd(uint8_t *cmd, int len){
-    if(Conf.RunModel) return FALSE;
-    static data_t *dscmd = NULL, *dlcmd = NULL;
-    if(!dscmd) dscmd = cmd2dat(CMD_SHORTCMD);
-    if(!dlcmd) dlcmd = cmd2dat(CMD_LONGCMD);
-    int ret = FALSE;
-    pthread_mutex_lock(&mntmutex);
+
+// send short/long binary command (runs in I/O thread), its checksum is patched in place; return FALSE if failed
+static int bincmd_io(uint8_t *cmd, int len){
+    const data_t *hdr;
     if(len == sizeof(SSscmd)){
         ((SSscmd*)cmd)->checksum = SScalcChecksum(cmd, len-2);
         //DBG("Short command");
 #if 0
         logscmd((SSscmd*)cmd);
 #endif
-        if(!wr(dscmd, NULL, 1)) goto rtn;
+        hdr = &dscmd;
     }else if(len == sizeof(SSlcmd)){
         ((SSlcmd*)cmd)->checksum = SScalcChecksum(cmd, len-2);
        // DBG("Long command");
 #if 0
         loglcmd((SSlcmd*)cmd);
 #endif
-        if(!wr(dlcmd, NULL, 1)) goto rtn;
-    }else{
-        goto rtn;
-    }
+        hdr = &dlcmd;
+    }else return FALSE;
     SSstat ans;
-    data_t d, in;
-    d.buf = cmd;
-    d.len = d.maxlen = len;
-    in.buf = (uint8_t*)&ans; in.maxlen = sizeof(SSstat);
-    ret = wr(&d, &in, 0);
+    data_t d = {.buf = cmd, .len = len, .maxlen = len};
+    data_t in = {.buf = (uint8_t*)&ans, .maxlen = sizeof(SSstat)};
+    int ret = wrframe(hdr, &d, &in);
     DBG("%s", ret ? "SUCCESS" : "FAIL");
     if(ret){
         SSscmd *sc = (SSscmd*)cmd;
-        mountdata.Xtarget = sc->Xmot;
-        mountdata.Ytarget = sc->Ymot;
+        md_wrlock();
+        Inst->ser.mountdata.Xtarget = sc->Xmot;
+        Inst->ser.mountdata.Ytarget = sc->Ymot;
+        md_wrunlock();
         DBG("ANS: Xmot/Ymot: %d/%d, Ylast/Ylast: %d/%d; Xtag/Ytag: %d/%d",
-            ans.Xmot, ans.Ymot, ans.XLast, ans.YLast, mountdata.Xtarget, mountdata.Ytarget);
+            ans.Xmot, ans.Ymot, ans.XLast, ans.YLast, Inst->ser.mountdata.Xtarget, Inst->ser.mountdata.Ytarget);
     }
-rtn:
-    pthread_mutex_unlock(&mntmutex);
     return ret;
 }
 
+// binary command job: synchronous one works with command of caller, asynchronous - with its copy in `buf`
+typedef struct{
+    uint8_t *cmd;
+    uint8_t buf[sizeof(SSlcmd)];
+    int len;
+} binjob_t;
+static int binjob(void *arg){
+    binjob_t *j = (binjob_t*)arg;
+    return bincmd_io(j->cmd ? j->cmd : j->buf, j->len);
+}
+
+static int bincmd(uint8_t *cmd, int len){
+    if(Inst->Conf.RunModel) return FALSE;
+    if(len > (int)sizeof(SSlcmd)) return FALSE;
+    binjob_t j = {.cmd = cmd, .len = len};
+    return mntjob_run(MCC_CMD_MOTION, binjob, &j);
+}
+
+// put binary command into queue; `cb` will be called after it done
+static int bincmd_async(const uint8_t *cmd, int len, mcc_cmdcb_t cb, void *cbarg){
+    if(Inst->Conf.RunModel) return FALSE;
+    binjob_t j = {.len = len};
+    if(len > (int)sizeof(j.buf)) return FALSE;
+    memcpy(j.buf, cmd, len);
+    return mntjob_submit(MCC_CMD_MOTION, binjob, &j, sizeof(j), cb, cbarg);
+}
+
+
 // short, long and config text-binary commands
 // return TRUE if OK
 int cmdS(SSscmd *cmd){
@@ -882,30 +1425,36 @@ int cmdS(SSscmd *cmd){
 int cmdL(SSlcmd *cmd){
     return bincmd((uint8_t *)cmd, sizeof(SSlcmd));
 }
-// rw == 1 to write, 0 to read
-int cmdC(SSconfig *conf, int rw){
-    if(Conf.RunModel) return FALSE;
-    static data_t *wcmd = NULL, *rcmd = NULL;
+int cmdSasync(const SSscmd *cmd, mcc_cmdcb_t cb, void *cbarg){
+    return bincmd_async((const uint8_t *)cmd, sizeof(SSscmd), cb, cbarg);
+}
+int cmdLasync(const SSlcmd *cmd, mcc_cmdcb_t cb, void *cbarg){
+    return bincmd_async((const uint8_t *)cmd, sizeof(SSlcmd), cb, cbarg);
+}
+// rw == 1 to write, 0 to read (runs in I/O thread)
+static int cmdC_io(SSconfig *conf, int rw){
     int ret = FALSE;
     // dummy buffer to clear trash in input
     char ans[300];
     data_t a = {.buf = (uint8_t*)ans, .maxlen=299};
-    if(!wcmd) wcmd = cmd2dat(CMD_PROGFLASH);
-    if(!rcmd) rcmd = cmd2dat(CMD_DUMPFLASH);
-    pthread_mutex_lock(&mntmutex);
-    if(rw){ // write
-        if(!wr(wcmd, &a, 1)) goto rtn;
+    if(rw){ // write: command, then configuration with its checksum
+        uint16_t sum = 0;
+        for(uint32_t i = 0; i < sizeof(SSconfig)-2; ++i) sum += ((uint8_t*)conf)[i];
+        conf->checksum = sum;
+        data_t d = {.buf = (uint8_t*)conf, .len = sizeof(SSconfig), .maxlen = sizeof(SSconfig)};
+        ret = wrframe(&wcmd, &d, &a);
+        DBG("write config: %s", ret ? "TRUE" : "FALSE");
     }else{ // read
         data_t d;
         d.buf = (uint8_t *) conf;
         d.len = 0; d.maxlen = 0;
-        ret = wr(rcmd, &d, 1);
+        ret = wr(&rcmd, &d, 1);
         DBG("write command: %s", ret ? "TRUE" : "FALSE");
         if(!ret) goto rtn;
         // make a huge pause for stupid SSII
         usleep(100000);
         d.len = 0;  d.maxlen = sizeof(SSconfig);
-        ret = wr(rcmd, &d, 1);
+        ret = wr(&rcmd, &d, 1);
         DBG("wr returned %s; got %zd bytes of %zd", ret ? "TRUE" : "FALSE", d.len, d.maxlen);
         if(d.len != d.maxlen){ ret = FALSE; goto rtn; }
         // simplest checksum
@@ -918,6 +1467,19 @@ int cmdC(SSconfig *conf, int rw){
         }
     }
 rtn:
-    pthread_mutex_unlock(&mntmutex);
     return ret;
 }
+
+typedef struct{
+    SSconfig *conf;
+    int rw;
+} confjob_t;
+static int confjob(void *arg){
+    confjob_t *j = (confjob_t*)arg;
+    return cmdC_io(j->conf, j->rw);
+}
+int cmdC(SSconfig *conf, int rw){
+    if(Inst->Conf.RunModel) return FALSE;
+    confjob_t j = {.conf = conf, .rw = rw};
+    return mntjob_run(MCC_CMD_OTHER, confjob, &j);
+}
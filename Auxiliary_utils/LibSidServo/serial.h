@@ -18,6 +18,9 @@
 
 #pragma once
 
+#include <pthread.h>
+#include <stdatomic.h>
+
 #include "sidservo.h"
 #include "ssii.h"
 
@@ -28,17 +31,76 @@
 // max error counter (when read() returns -1)
 #define MAX_ERR_CTR (100)
 
-data_t *cmd2dat(const char *cmd);
-void data_free(data_t **x);
+// size of data buffer for asynchronous jobs
+#define MNTJOB_DATASZ   (64)
+// preallocated asynchronous jobs of each instance (more are allocated if pool is empty)
+#define MNTJOB_POOLSZ   (256)
+
+// function running in mount I/O thread; should return FALSE if failed
+typedef int (*mntjobfn_t)(void *arg);
+
+// job for mount I/O thread
+typedef struct mntjob{
+    mntjobfn_t fn;          // function to run
+    void *arg;              // its argument
+    mcc_cmdcb_t cb;         // callback or NULL
+    void *cbarg;            // callback argument
+    mcc_cmdclass_t cls;     // priority
+    int detached;           // !=0 for asynchronous jobs (returned into pool or freed by I/O thread)
+    int done;               // ==1 when job is done
+    int ret;                // value returned by `fn`
+    double tsubmit;         // time of queueing (for latency statistics)
+    struct mntjob *next;
+    uint8_t data[MNTJOB_DATASZ]; // copy of data for asynchronous job
+} mntjob_t;
+
+struct less_square;
+// serial devices, their threads and data got from them
+typedef struct{
+    int encfd[2], mntfd;    // serial devices FD
+    mountdata_t mountdata;  // main mount data
+    pthread_mutex_t mntmutex, datamutex; // mutexes for RW operations with mount device and data
+    atomic_uint mdseq;      // seqlock counter for `mountdata`: odd while writer changes it
+    pthread_t encthread, mntthread;
+    int mntstarted;         // ==1 if mount thread should be joined
+    int mntslot;            // slot of model thread in virtual clock
+    volatile int GlobExit;
+    struct{                 // mount I/O queue: one FIFO per priority
+        mntjob_t *head[MCC_CMD_AMOUNT];
+        mntjob_t *tail[MCC_CMD_AMOUNT];
+        int running;        // ==1 while I/O thread works
+    } ioq;
+    mntjob_t jobpool[MNTJOB_POOLSZ]; // asynchronous jobs without allocation in hot path
+    mntjob_t *freejobs;     // list of free jobs of pool (protected by `qmutex`)
+    int poolready;          // ==1 when `freejobs` is filled
+    pthread_mutex_t qmutex;
+    pthread_cond_t qcond, donecond; // new job in queue and some job is done
+    pthread_t iothread;
+    struct less_square *ls[2]; // speed calculation of both axes
+    atomic_uint encgen;     // generation of encoders' constants: filters are restarted when it changes
+    struct timespec enctlast[2]; // time of previous encoders' samples
+    int32_t Xmot_prev, Ymot_prev; // previous motors' coordinates
+    int Xnstopped, Ynstopped; // counters to get STOPPED state
+    uint32_t oldmillis;     // model's `millis`
+} serial_state_t;
+
 int openEncoder();
 int openMount();
 void closeSerial();
+void setrt();
 mcc_errcodes_t getMD(mountdata_t  *d);
 void setStat(axis_status_t Xstate, axis_status_t Ystate);
+int mntjob_run(mcc_cmdclass_t cls, mntjobfn_t fn, void *arg);
+int mntjob_submit(mcc_cmdclass_t cls, mntjobfn_t fn, const void *data, size_t len, mcc_cmdcb_t cb, void *cbarg);
+mcc_errcodes_t getCmdLatency(mcc_cmdclass_t cls, mcc_hist_t *h);
+int MountWriteReadCls(const data_t *out, data_t *in, int needeol, mcc_cmdclass_t cls);
 int MountWriteRead(const data_t *out, data_t *in);
 int MountWriteReadRaw(const data_t *out, data_t *in);
 int cmdS(SSscmd *cmd);
 int cmdL(SSlcmd *cmd);
+int cmdSasync(const SSscmd *cmd, mcc_cmdcb_t cb, void *cbarg);
+int cmdLasync(const SSlcmd *cmd, mcc_cmdcb_t cb, void *cbarg);
 int cmdC(SSconfig *conf, int rw);
 void getXspeed();
 void getYspeed();
+void enc_reconf();
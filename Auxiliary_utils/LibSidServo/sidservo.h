@@ -38,6 +38,10 @@ extern "C"
 #define MCC_CONF_MAX_SPEEDINT   (2.)
 // minimal speed interval in parts of EncoderReqInterval
 #define MCC_CONF_MIN_SPEEDC     (3.)
+// max amount of mounts served by one process (including `Mount`)
+#define MCC_MAXMOUNTS           (8)
+// max amount of bins of periodic error table by worm phase
+#define MCC_PEC_MAXBINS         (256)
 
 
 // error codes
@@ -55,6 +59,13 @@ typedef struct{
     double P, I, D;
 } PIDpar_t;
 
+// source of encoders' speed in mountdata_t.encXspeed/encYspeed
+typedef enum{
+    SPEED_SRC_LS,       // less squares by EncoderSpeedInterval (lags by half of interval)
+    SPEED_SRC_KALMAN,   // Kalman filter (only if SepEncoder == 2, else LS used)
+    SPEED_SRC_BOTH,     // Kalman, but LS if they disagree more than SpeedDisagreement
+} speedsrc_t;
+
 typedef struct{
     char*   MountDevPath;           // path to mount device
     int     MountDevSpeed;          // serial speed
@@ -80,6 +91,18 @@ typedef struct{
     double  MaxGuidingErr;          // if error less than this value we suppose that target is captured and guiding is good (true guiding): 0.1''
     int     XEncZero;               // encoders' zero position
     int     YEncZero;
+    int     SpeedSource;            // source of encXspeed/encYspeed (speedsrc_t)
+    double  SpeedDisagreement;      // acceptable disagreement between Kalman and LS speeds for SPEED_SRC_BOTH, rad/s
+    int     RTPriority;             // SCHED_FIFO priority of mount and encoders' threads (0 - don't change)
+    int     CPUMask;                // bitmask of CPUs for these threads (0 - don't change)
+    char*   RecordPath;             // binary log of telemetry and transactions with mount (NULL - don't record)
+    char*   ReplayPath;             // replay recorded log instead of real devices (NULL - work with devices)
+    int     XWormTeeth;             // teeth of worm wheels (one worm turn - 2pi/teeth of axis); 0 - no PEC on axis
+    int     YWormTeeth;
+    int     PECBins;                // bins of periodic error table by worm phase (0 - 128, max MCC_PEC_MAXBINS)
+    char*   PECPath;                // learned periodic error: loaded by init(), saved by quit() (NULL - don't keep)
+    char*   HWConfPath;             // cache of hardware configuration: used by init() if serial number of controller
+                                    // is the same, refreshed by reading/writing (NULL - always read from controller)
 } conf_t;
 
 // coordinates/speeds in degrees or d/s: X, Y
@@ -98,6 +121,19 @@ typedef struct{
     coordval_t Y;
 } coordval_pair_t;
 
+// target position with its speed and acceleration at moment `t` (for feed-forward correction)
+typedef struct{
+    double val;         // position, rad
+    double speed;       // speed, rad/s (NAN if unknown: it will be calculated by subsequent positions)
+    double accel;       // acceleration, rad/s^2 (NAN if unknown)
+    struct timespec t;
+} targval_t;
+
+typedef struct{
+    targval_t X;
+    targval_t Y;
+} targval_pair_t;
+
 // data to read/write
 typedef struct{
     uint8_t *buf;   // data buffer
@@ -151,8 +187,12 @@ typedef struct{
     coordval_t motYposition;
     coordval_t encXposition;
     coordval_t encYposition;
-    coordval_t encXspeed; // once per <config> s
+    coordval_t encXspeed; // selected by Conf.SpeedSource
     coordval_t encYspeed;
+    coordval_t encXspeedLS; // by less squares
+    coordval_t encYspeedLS;
+    coordval_t encXspeedKF; // by Kalman filter (zero if there's no filter)
+    coordval_t encYspeedKF;
     uint8_t keypad;
     extradata_t extradata;
     uint32_t millis;
@@ -163,6 +203,15 @@ typedef struct{
     int32_t Ytarget; // -//-
 } mountdata_t;
 
+// one sample of encoders' history
+typedef struct{
+    struct timespec t;  // measurement time
+    int32_t raw;        // raw encoder's counts (0 in model mode)
+    double pos;         // position (Kalman filtered if Kalman used), rad
+    double speed;       // speed, rad/s
+    double accel;       // acceleration by Kalman filter (or 0 if Kalman isn't used), rad/s^2
+} encsample_t;
+
 typedef struct{
     double Xmot;        // 0  X motor position (rad)
     double Xspeed;      // 4  X speed (rad/s)
@@ -227,19 +276,195 @@ typedef struct{
     double backlspd;    // Backlash speed (rad/s)
 } hardware_configuration_t;
 
-/* flags for slew function
+// classes of commands to mount in order of their priority in I/O queue
+typedef enum{
+    MCC_CMD_MOTION,     // short/long binary commands and stop
+    MCC_CMD_OTHER,      // other text commands
+    MCC_CMD_STATUS,     // periodic status requests
+    MCC_CMD_AMOUNT
+} mcc_cmdclass_t;
+
+// callback of asynchronous command (runs in mount I/O thread, so it shouldn't block)
+typedef void (*mcc_cmdcb_t)(mcc_errcodes_t ret, void *arg);
+
+// amount of bins in histograms
+#define MCC_HIST_NBINS  (24)
+
+// histogram of time intervals: bins[0] - less than 1us, bins[i] - [2^(i-1), 2^i) us, last bin - all larger
+typedef struct{
+    uint64_t bins[MCC_HIST_NBINS];
+    uint64_t n;         // amount of values
+    double mean;        // mean value, s
+    double max;         // max value, s
+} mcc_hist_t;
+
+// timing statistics of library loops
+typedef struct{
+    mcc_hist_t mountJitter;     // lateness of mount (or model) loop wakeups relative to their deadlines
+    mcc_hist_t encInterval;     // intervals between subsequent samples of each axis encoder
+    mcc_hist_t enc2cmd;         // from encoders' sample used by correctTo() to command sent
+    mcc_hist_t pidPeriod;       // intervals between correctTo() calls
+    mcc_hist_t trackPeriod;     // intervals between long commands of tracking engine
+    mcc_hist_t cmdRTT[MCC_CMD_AMOUNT];      // serial transaction time by class of command
+    mcc_hist_t cmdLatency[MCC_CMD_AMOUNT];  // from command queueing to its end (queue waiting + transaction)
+    uint64_t encHistDropped[2]; // X/Y samples lost by overflow of encoders' history (not read in time)
+    uint64_t asyncRejected;     // asynchronous commands refused because I/O queue was full
+} mcc_stats_t;
+
+// target trajectory for tracking engine: fill positions (rad) of both axes for time `t` (seconds, by timeFromStart());
+// should return FALSE to end tracking (e.g. after last point)
+typedef int (*mcc_traject_t)(double t, coordpair_t *pos, void *arg);
+
+// sampled trajectory for Mount.trajSpline() (times should increase)
+typedef struct{
+    const double *t;            // times of samples, s (by timeFromStart())
+    const coordpair_t *pos;     // positions, rad
+    size_t n;                   // amount of samples (>1)
+} mcc_trajsamples_t;
+
+// parameters of tracking engine
+typedef struct{
+    mcc_traject_t traject;      // target trajectory
+    void *arg;                  // its argument
+    double interval;            // interval between long commands, s (0 - MountReqInterval)
+    double lookahead;           // adders time: controller moves target by itself during it after each command, s (0 - 3*interval)
+} mcc_track_t;
+
+// parameters of offline PID tuning by model (runs faster than real time); zero values mean defaults
+typedef struct{
+    int axis;                   // 0 - X, 1 - Y
+    int feedforward;            // ==1 to tune correctToFF() (target speed known), else correctTo()
+    const mcc_traject_t *traject; // trajectories to test (time from simulation start), NULL - built-in set:
+                                // sidereal, slow sine and satellite-like pass
+    void * const *args;         // their arguments (may be NULL)
+    size_t ntraject;            // amount of trajectories
+    double duration;            // duration of each simulation, s (120)
+    double skip;                // errors in first `skip` seconds aren't counted in RMS/peak (10)
+    double dt;                  // errors' sampling step, s (PIDRefreshDt/10)
+    double latency;             // delay between encoders' measurement and command, s (0)
+    double noise;               // RMS of encoders' noise, rad (0)
+    double offset;              // initial offset of mount from trajectory, rad (0)
+    double tolerance;           // error for settling time calculation, rad (1'')
+    PIDpar_t min;               // lower limits of gains (0)
+    PIDpar_t max;               // upper limits of gains (all zeros - P=10, I=5, D=1)
+    int gridN;                  // amount of grid points by each gain (5)
+    int NMiter;                 // max amount of Nelder-Mead iterations after grid search (200)
+    int nthreads;               // amount of threads (all CPUs)
+    unsigned short seed;        // seed of noise generator
+} mcc_pidtune_t;
+
+// result of PID tuning
 typedef struct{
-    uint32_t slewNguide : 1; // ==1 to guide after slewing
-} slewflags_t;
-*/
+    PIDpar_t gain;              // best gains
+    double rms;                 // RMS error over all trajectories, rad (cost function)
+    double peak;                // max error, rad
+    double settle;              // worst settling time (error stays less than tolerance after it), s
+    size_t nsim;                // amount of simulations made
+} mcc_pidtune_res_t;
+
+// parameters of slew planning
+typedef struct{
+    coordpair_t target;         // target axes' (encoders') position, rad
+    const coordpair_t *from;    // starting position, rad (NULL - current position and speed of mount)
+    uint8_t wrap;               // ==1 to try target +-2pi by each axis (if it's inside axis limits)
+    uint8_t flip;               // ==1 to try flipped position: X' = flipX - X, Y' = Y + pi
+    double flipX;               // X of flip (pi if zero of X is on equator/horizon, 0 if it's on pole/zenith)
+} mcc_slewplan_t;
+
+// result of slew planning
+typedef struct{
+    coordpair_t target;         // fastest legal position of target
+    double duration;            // predicted time of synchronized slew, s
+    int flipped;                // ==1 if target is flipped
+    int ncand;                  // amount of legal candidates checked
+} mcc_slewplan_res_t;
+
+// state of replay of recorded log (conf_t.ReplayPath)
+typedef struct{
+    double duration;            // time of last record (from init()), s
+    double position;            // time of last replayed telemetry record, s
+    size_t nrec;                // amount of records in log
+    size_t replayed;            // amount of replayed telemetry records
+    size_t cmdmatched;          // transactions with mount answered by recorded answers
+    size_t cmdmismatched;       // transactions absent in log (failed)
+    int finished;               // ==1 when all telemetry is replayed
+} mcc_replay_t;
+
+// modes of periodic error correction (PEC)
+typedef struct{
+    int learn;                  // ==1 to learn error of axes relatively to motors by worm phase while axes move slowly
+    int apply;                  // ==1 to correct commands of tracking engine by learned error (feed-forward)
+    int reset;                  // ==1 to forget learned tables
+} mcc_pecmode_t;
+
+// periodic error of one axis
+typedef struct{
+    int teeth;                  // teeth of worm wheel (0 - no PEC)
+    int nbins;                  // amount of bins
+    double phase;               // current worm phase, [0, 1)
+    double coverage;            // part of bins with enough samples (correction is applied only if all covered)
+    double ptp;                 // peak-to-peak of learned error, rad
+    double rms;                 // its RMS, rad
+    uint64_t nsamples;          // amount of samples learned
+    double table[MCC_PEC_MAXBINS]; // error of axis (axis - motor) by worm phase (zero mean), rad
+} mcc_pecaxis_t;
+
+// state of PEC
+typedef struct{
+    int learn;                  // modes
+    int apply;
+    mcc_pecaxis_t X, Y;
+} mcc_pec_t;
+
+// source of all library times (data timestamps, timeFromStart(), PID and model)
+typedef enum{
+    MCC_CLOCK_REAL,             // system clocks
+    MCC_CLOCK_VIRTUAL,          // virtual clock for model mode: time goes only by advanceClock()
+} mcc_clocksrc_t;
+
+// clock settings
+typedef struct{
+    mcc_clocksrc_t source;
+    struct timespec start;      // UNIX time of virtual clock start (zero - current time)
+    uint32_t seed;              // seed of model's encoders noise
+} mcc_clock_t;
+
+// stage of mount initialization
+typedef enum{
+    MCC_INIT_IDLE,              // init wasn't called or quit() done
+    MCC_INIT_BUSY,              // devices are bringing up
+    MCC_INIT_READY,             // all done
+    MCC_INIT_FAILED,            // bring-up failed (see `err`), call quit() before next init
+} mcc_initstage_t;
+
+// steps of initialization done (bits of `mcc_initstate_t.done`)
+#define MCC_INIT_MOUNTDEV   (1<<0)  // mount device opened, status is polling
+#define MCC_INIT_HWCONF     (1<<1)  // hardware configuration read, constants updated
+#define MCC_INIT_ENCODERS   (1<<2)  // encoders' devices opened
+#define MCC_INIT_ENCDATA    (1<<3)  // first encoders' data by new constants got
+#define MCC_INIT_SYNC       (1<<4)  // motors' positions synced with encoders
+#define MCC_INIT_HWCACHE    (1<<5)  // hardware configuration was taken from cache (HWConfPath)
+
+// state of initialization
+typedef struct{
+    mcc_initstage_t stage;
+    unsigned done;              // steps done
+    mcc_errcodes_t err;         // result (MCC_E_OK while busy)
+    double elapsed;             // time from init start (till the end if it's finished), s
+} mcc_initstate_t;
+
+// callback of asynchronous init: called once when bring-up finished (READY or FAILED) from library thread
+// (in model mode - from initAsync() itself), it can call methods of mount, except init() and quit()
+typedef void (*mcc_initcb_t)(const mcc_initstate_t *st, void *arg);
+
 // mount class
 typedef struct{
     // TODO: on init/quit clear all XY-bits to default`
     mcc_errcodes_t  (*init)(conf_t *c); // init device
     void            (*quit)(); // deinit
     mcc_errcodes_t  (*getMountData)(mountdata_t *d); // get last data
-//    mcc_errcodes_t  (*slewTo)(const coordpair_t *target, slewflags_t flags);
     mcc_errcodes_t  (*correctTo)(const coordval_pair_t *target);
+    mcc_errcodes_t  (*correctToFF)(const targval_pair_t *target); // the same with target's speed feed-forward
     mcc_errcodes_t  (*moveTo)(const coordpair_t *target); // move to given position and stop
     mcc_errcodes_t  (*moveWspeed)(const coordpair_t *target, const  coordpair_t *speed); // move with given max speed
     mcc_errcodes_t  (*setSpeed)(const coordpair_t *tagspeed); // set speed
@@ -256,10 +481,58 @@ typedef struct{
     mcc_errcodes_t  (*getMaxSpeed)(coordpair_t *v); // maximal speed by both axis
     mcc_errcodes_t  (*getMinSpeed)(coordpair_t *v); // minimal -//-
     mcc_errcodes_t  (*getAcceleration)(coordpair_t *a); // acceleration/deceleration
+    // drain encoders' history (should be called from one thread): nX/nY - size of X/Y arrays on input and amount of samples got on output;
+    // samples lost when history wasn't read in time are counted in encHistDropped of getStats()
+    mcc_errcodes_t  (*readEncoderHistory)(encsample_t *X, size_t *nX, encsample_t *Y, size_t *nY);
+    // put short/long command into I/O queue and return at once; `cb` (if not NULL) will be called after command done;
+    // MCC_E_FAILED if queue is full (counted in asyncRejected of getStats()), `cb` isn't called then
+    mcc_errcodes_t  (*shortCmdAsync)(const short_command_t *cmd, mcc_cmdcb_t cb, void *arg);
+    mcc_errcodes_t  (*longCmdAsync)(const long_command_t *cmd, mcc_cmdcb_t cb, void *arg);
+    // histogram of time from command queueing to its end for given class of commands
+    mcc_errcodes_t  (*getCmdLatency)(mcc_cmdclass_t cls, mcc_hist_t *h);
+    // get all timing statistics or clear them
+    mcc_errcodes_t  (*getStats)(mcc_stats_t *s);
+    void            (*resetStats)();
+    // start tracking engine streaming long commands with adders by trajectory `t` (tracking stops if it returns FALSE)
+    mcc_errcodes_t  (*track)(const mcc_track_t *t);
+    // stop tracking engine (mount continues moving till the end of last adders time)
+    mcc_errcodes_t  (*trackStop)();
+    // cubic Hermite spline by samples (`samples` is mcc_trajsamples_t*) to use as trajectory of tracking engine
+    int             (*trajSpline)(double t, coordpair_t *pos, void *samples);
+    // offline search of PID gains by model (grid search + Nelder-Mead); needs init() for configuration only
+    mcc_errcodes_t  (*tunePID)(const mcc_pidtune_t *par, mcc_pidtune_res_t *res);
+    // set clock source (before first init() only); with virtual clock model mode is deterministic and runs
+    // as fast as advanceClock() called
+    mcc_errcodes_t  (*setClock)(const mcc_clock_t *c);
+    // advance virtual clock by `dt` seconds: all library threads run till this time; for real clock just sleeps
+    mcc_errcodes_t  (*advanceClock)(double dt);
+    // slew to axes' (encoders') position by jerk-limited profiles of both axes finishing together; profiles are
+    // executed by tracking engine (trackStop() or stop() breaks slew); `duration` (if not NULL) - planned time, s
+    mcc_errcodes_t  (*slewTo)(const coordpair_t *target, double *duration);
+    // find the fastest legal position of target by axes' limits, wrap and flip and predict duration of slewTo() to it
+    // (without mount access if `from` given, so schedulers can order targets by slew cost)
+    mcc_errcodes_t  (*planSlew)(const mcc_slewplan_t *p, mcc_slewplan_res_t *r);
+    // state of replay of recorded log (MCC_E_FAILED if there's no replay)
+    mcc_errcodes_t  (*replayState)(mcc_replay_t *s);
+    // periodic error correction of worm gears: set modes, get learned tables and save them (NULL - to Conf.PECPath)
+    mcc_errcodes_t  (*setPEC)(const mcc_pecmode_t *m);
+    mcc_errcodes_t  (*getPEC)(mcc_pec_t *s);
+    mcc_errcodes_t  (*savePEC)(const char *path);
+    // init without waiting: configuration is checked and mount device opened at once, then hardware configuration
+    // is read while encoders are opening; getMountData() works during bring-up, its end is reported by `cb`
+    // (if not NULL) and initState(); init() is initAsync() waiting for the end
+    mcc_errcodes_t  (*initAsync)(conf_t *c, mcc_initcb_t cb, void *arg);
+    mcc_errcodes_t  (*initState)(mcc_initstate_t *st);
 } mount_t;
 
 extern mount_t Mount;
 
+// open one more mount (each has its own configuration, devices, threads and state; clock is common for all):
+// returns class with the same methods as `Mount` or NULL if there's no free slots or init() failed
+mount_t *mount_open(conf_t *c);
+// quit() and free slot of mount got by mount_open()
+void mount_close(mount_t *m);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,254 @@
+/*
+ * This file is part of the libsidservo project.
+ * Copyright 2026 Edward V. Emelianov <edward.emelianoff@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * S-curve slew: minimum-time jerk-limited profiles of both axes from current position and speed to target; faster
+ * axis is slowed down to finish together with slower. Profiles are executed by tracking engine (long commands with
+ * adders each SLEW_INTERVAL), so controller's own trapezoid ramps work only on small steps between commands.
+ * Planner checks all legal positions of target (by axes' limits, +-2pi wraps and flip) by the same profiles.
+ */
+
+#include <math.h>
+#include <pthread.h>
+
+#include "main.h"
+#include "serial.h"
+#include "slew.h"
+#include "tracking.h"
+
+/**
+ * @brief planaxis - plan profile of one axis
+ * @param m - model
+ * @param start - starting position and speed
+ * @param x - target
+ * @param vmax - max speed
+ * @param t - time of start
+ * @return time of profile end or -1 if failed
+ */
+static double planaxis(movemodel_t *m, const moveparam_t *start, double x, double vmax, double t){
+    m->state = ST_STOP;
+    m->nseg = 0;
+    m->curparams = *start;
+    m->curparams.accel = 0.;
+    moveparam_t tag = {.coord = x, .speed = vmax};
+    if(!model_move2(m, &tag, t)) return -1.;
+    if(m->state == ST_STOP) return t;
+    return m->stoppedtime(m);
+}
+
+/**
+ * @brief syncaxis - slow down axis to finish its profile at time `tend`
+ * @return FALSE if failed
+ */
+static int syncaxis(movemodel_t *m, const moveparam_t *start, double x, double t, double tend){
+    double lo = m->Min.speed, hi = m->Max.speed;
+    if(planaxis(m, start, x, lo, t) <= tend) return TRUE; // can't go slower
+    for(int i = 0; i < SLEW_SYNC_ITER && hi - lo > 1e-9 * hi; ++i){
+        double mid = (lo + hi) / 2.;
+        if(planaxis(m, start, x, mid, t) > tend) lo = mid;
+        else hi = mid;
+    }
+    return planaxis(m, start, x, hi, t) >= 0.;
+}
+
+/**
+ * @brief startstate - current encoders' positions and speeds extrapolated to time of slew start
+ * @param X0, Y0 (o) - starting state of axes
+ * @param t (o) - time of start (command will be applied after queueing and transmission)
+ * @return FALSE if no data
+ */
+static int startstate(moveparam_t *X0, moveparam_t *Y0, double *t){
+    mountdata_t d;
+    if(MCC_E_OK != getMD(&d) || d.encXposition.t.tv_sec == 0) return FALSE;
+    mcc_hist_t lat;
+    hist_get(&Inst->Stats.cmdLatency[MCC_CMD_MOTION], &lat);
+    *t = timefromstart() + lat.mean;
+    X0->speed = d.encXspeed.val;
+    Y0->speed = d.encYspeed.val;
+    X0->coord = d.encXposition.val + X0->speed * (*t - timediff0(&d.encXposition.t));
+    Y0->coord = d.encYposition.val + Y0->speed * (*t - timediff0(&d.encYposition.t));
+    X0->accel = Y0->accel = 0.;
+    return TRUE;
+}
+
+/**
+ * @brief candidates - legal positions of axis for coordinate `x`
+ * @param x - coordinate
+ * @param l - axis limits
+ * @param wrap - ==1 to check x+-2pi too
+ * @param c (o) - candidates (SLEW_MAXWRAP)
+ * @return amount of candidates
+ */
+static int candidates(double x, const limits_t *l, int wrap, double *c){
+    int n = 0;
+    if(!wrap){
+        if(x >= l->min.coord && x <= l->max.coord) c[n++] = x;
+        return n;
+    }
+    x = remainder(x, 2.*M_PI);
+    for(int k = -(SLEW_MAXWRAP/2); k <= SLEW_MAXWRAP/2; ++k){
+        double v = x + 2.*M_PI*k;
+        if(v >= l->min.coord && v <= l->max.coord) c[n++] = v;
+    }
+    return n;
+}
+
+/**
+ * @brief fastest - find candidate with minimal time of moving
+ * @param m - model
+ * @param start - starting state
+ * @param c - candidates
+ * @param n - their amount
+ * @param t - time of start
+ * @param best (o) - best candidate
+ * @return minimal time or -1 if all failed
+ */
+static double fastest(movemodel_t *m, const moveparam_t *start, const double *c, int n, double t, double *best){
+    double tmin = -1.;
+    for(int i = 0; i < n; ++i){
+        double T = planaxis(m, start, c[i], m->Max.speed, t);
+        if(T < 0.) continue;
+        T -= t;
+        if(tmin < 0. || T < tmin){
+            tmin = T;
+            *best = c[i];
+        }
+    }
+    return tmin;
+}
+
+// slew_plan() body (called with locked `slew.mutex`)
+static mcc_errcodes_t plan(const mcc_slewplan_t *p, mcc_slewplan_res_t *r){
+    moveparam_t X0 = {0}, Y0 = {0};
+    double t = 0.;
+    if(p->from){
+        X0.coord = p->from->X;
+        Y0.coord = p->from->Y;
+    }else if(!startstate(&X0, &Y0, &t)) return MCC_E_FAILED;
+    movemodel_t mX, mY;
+    if(!model_init(&mX, RAMP_S, &Inst->Xlimits)) return MCC_E_FAILED;
+    if(!model_init(&mY, RAMP_S, &Inst->Ylimits)){
+        model_free(&mX);
+        return MCC_E_FAILED;
+    }
+    r->duration = -1.;
+    r->ncand = 0;
+    for(int flip = 0; flip <= (p->flip ? 1 : 0); ++flip){
+        double x = p->target.X, y = p->target.Y, cX[SLEW_MAXWRAP], cY[SLEW_MAXWRAP];
+        if(flip){
+            x = p->flipX - x;
+            y = remainder(y + M_PI, 2.*M_PI);
+        }
+        int nX = candidates(x, &Inst->Xlimits, p->wrap, cX), nY = candidates(y, &Inst->Ylimits, p->wrap, cY);
+        r->ncand += nX * nY;
+        // axes are independent, so the fastest synchronized slew is by the fastest position of each axis
+        coordpair_t best;
+        double tX = fastest(&mX, &X0, cX, nX, t, &best.X), tY = fastest(&mY, &Y0, cY, nY, t, &best.Y);
+        if(tX < 0. || tY < 0.) continue;
+        double T = (tX > tY) ? tX : tY;
+        if(r->duration < 0. || T < r->duration){
+            r->duration = T;
+            r->target = best;
+            r->flipped = flip;
+        }
+    }
+    model_free(&mX);
+    model_free(&mY);
+    DBG("Best of %d candidates: X=%g, Y=%g (flip=%d), T=%g", r->ncand, r->target.X, r->target.Y, r->flipped, r->duration);
+    return (r->duration < 0.) ? MCC_E_BADFORMAT : MCC_E_OK;
+}
+
+/**
+ * @brief slew_plan - find the fastest legal position of target and predict duration of synchronized slew to it
+ * @param p - parameters
+ * @param r (o) - result
+ * @return MCC_E_BADFORMAT if there's no legal positions
+ */
+mcc_errcodes_t slew_plan(const mcc_slewplan_t *p, mcc_slewplan_res_t *r){
+    if(!p || !r) return MCC_E_BADFORMAT;
+    // starting state is taken in the same critical section as slew_to() does
+    pthread_mutex_lock(&Inst->slew.mutex);
+    mcc_errcodes_t ret = plan(p, r);
+    pthread_mutex_unlock(&Inst->slew.mutex);
+    return ret;
+}
+
+/**
+ * @brief slewtraj - trajectory of tracking engine by planned profiles
+ * @param t - time
+ * @param pos (o) - position
+ * @return FALSE after target holding time
+ */
+static int slewtraj(double t, coordpair_t *pos, void _U_ *arg){
+    if(t > Inst->slew.tend + SLEW_HOLD) return FALSE;
+    if(t < Inst->slew.tstart) t = Inst->slew.tstart;
+    moveparam_t X, Y;
+    Inst->slew.X.eval(&Inst->slew.X, &t, 1, &X);
+    Inst->slew.Y.eval(&Inst->slew.Y, &t, 1, &Y);
+    pos->X = X.coord;
+    pos->Y = Y.coord;
+    return TRUE;
+}
+
+/**
+ * @brief slew_to - slew to target by synchronized jerk-limited profiles (previous tracking or slew is stopped)
+ * @param target - axes' (encoders') coordinates, rad
+ * @param duration (o) - planned time of profile, s (or NULL)
+ * @return errcode
+ */
+mcc_errcodes_t slew_to(const coordpair_t *target, double *duration){
+    if(!target) return MCC_E_BADFORMAT;
+    if(target->X > Inst->Xlimits.max.coord || target->X < Inst->Xlimits.min.coord ||
+       target->Y > Inst->Ylimits.max.coord || target->Y < Inst->Ylimits.min.coord) return MCC_E_BADFORMAT;
+    moveparam_t X0, Y0;
+    double t;
+    mcc_errcodes_t ret = MCC_E_FAILED;
+    pthread_mutex_lock(&Inst->slew.mutex);
+    if(!startstate(&X0, &Y0, &t)) goto ret;
+    // profiles shouldn't change while tracking thread uses them: stop it inside critical section, so concurrent
+    // slew_to() can't start tracking by profiles between stop and their change (slewtraj() doesn't lock mutex)
+    track_stop();
+    if(Inst->slew.inited){
+        model_free(&Inst->slew.X);
+        model_free(&Inst->slew.Y);
+        Inst->slew.inited = 0;
+    }
+    if(!model_init(&Inst->slew.X, RAMP_S, &Inst->Xlimits)) goto ret;
+    if(!model_init(&Inst->slew.Y, RAMP_S, &Inst->Ylimits)){
+        model_free(&Inst->slew.X);
+        goto ret;
+    }
+    Inst->slew.inited = 1;
+    double tX = planaxis(&Inst->slew.X, &X0, target->X, Inst->Xlimits.max.speed, t);
+    double tY = planaxis(&Inst->slew.Y, &Y0, target->Y, Inst->Ylimits.max.speed, t);
+    if(tX < 0. || tY < 0.){
+        DBG("Can't plan profile");
+        goto ret;
+    }
+    DBG("Minimal times: X - %g, Y - %g", tX - t, tY - t);
+    if(tX < tY){ if(!syncaxis(&Inst->slew.X, &X0, target->X, t, tY)) goto ret; }
+    else if(tY < tX){ if(!syncaxis(&Inst->slew.Y, &Y0, target->Y, t, tX)) goto ret; }
+    Inst->slew.tstart = t;
+    Inst->slew.tend = (tX > tY) ? tX : tY;
+    if(duration) *duration = Inst->slew.tend - t;
+    mcc_track_t tr = {.traject = slewtraj, .interval = SLEW_INTERVAL, .lookahead = SLEW_LOOKAHEAD};
+    ret = track_start(&tr);
+ret:
+    pthread_mutex_unlock(&Inst->slew.mutex);
+    return ret;
+}
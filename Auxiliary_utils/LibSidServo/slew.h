@@ -0,0 +1,46 @@
+/*
+ * This file is part of the libsidservo project.
+ * Copyright 2026 Edward V. Emelianov <edward.emelianoff@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <pthread.h>
+
+#include "movingmodel.h"
+#include "sidservo.h"
+
+// interval between commands of slew, s
+#define SLEW_INTERVAL       (0.05)
+// adders' time of slew commands, s
+#define SLEW_LOOKAHEAD      (3. * SLEW_INTERVAL)
+// after profile end target is held for this time, then slew ends, s
+#define SLEW_HOLD           (2. * SLEW_LOOKAHEAD)
+// max amount of bisection iterations when synchronizing axes
+#define SLEW_SYNC_ITER      (60)
+// max amount of candidates by each axis (target and its +-2pi wraps)
+#define SLEW_MAXWRAP        (5)
+
+// current slew
+typedef struct{
+    movemodel_t X, Y;       // profiles
+    double tstart, tend;    // time of profiles' start and end (by timefromstart())
+    int inited;             // models are inited
+    pthread_mutex_t mutex;
+} slew_state_t;
+
+mcc_errcodes_t slew_to(const coordpair_t *target, double *duration);
+mcc_errcodes_t slew_plan(const mcc_slewplan_t *p, mcc_slewplan_res_t *r);
@@ -26,13 +26,6 @@
 #include "serial.h"
 #include "ssii.h"
 
-int X_ENC_ZERO = 0, Y_ENC_ZERO = 0; // will be filled later from config
-// defaults until read from controller
-double  X_MOT_STEPSPERREV = 13312000.,
-        Y_MOT_STEPSPERREV = 17578668.,
-        X_ENC_STEPSPERREV = 67108864.,
-        Y_ENC_STEPSPERREV = 67108864.;
-
 uint16_t SScalcChecksum(uint8_t *buf, int len){
     uint16_t checksum = 0;
     for(int i = 0; i < len; i++){
@@ -44,6 +37,44 @@ uint16_t SScalcChecksum(uint8_t *buf, int len){
     return checksum;
 }
 
+/**
+ * @brief SSsetconst - calculate derived conversion factors (should be called after any change of zeros or steps)
+ * @param c - constants of mount
+ */
+void SSsetconst(ssconst_t *c){
+    const double steps[SS_NCNT] = {c->Xmotsteps, c->Ymotsteps, c->Xencsteps, c->Yencsteps};
+    c->cnt0[SS_XMOT] = c->cnt0[SS_YMOT] = 0.;
+    c->cnt0[SS_XENC] = (double)c->Xenczero;
+    c->cnt0[SS_YENC] = (double)c->Yenczero;
+    for(int i = 0; i < SS_NCNT; ++i){
+        c->cnt2rad[i] = 2. * M_PI / steps[i];
+        c->rad2cnt[i] = steps[i] / (2. * M_PI);
+    }
+}
+
+/**
+ * @brief SScnt2rad - convert batch of counters' values into radians (-pi..pi)
+ * @param c - constants of mount
+ * @param first - type of first counter in each record
+ * @param nk - amount of counters in record (e.g. 4 for Xmot..Yenc of SSstat, 2 for X/Y encoders)
+ * @param cnt (i) - `n` records of counters
+ * @param rad (o) - `n` records of radians
+ * @param n - amount of records
+ */
+void SScnt2rad(const ssconst_t *c, sscnt_t first, int nk, const int32_t *cnt, double *rad, size_t n){
+    if(nk < 1 || first + nk > SS_NCNT) return;
+    double z[SS_NCNT], k[SS_NCNT];
+    for(int i = 0; i < nk; ++i){
+        z[i] = c->cnt0[first + i];
+        k[i] = c->cnt2rad[first + i];
+    }
+    size_t N = n * (size_t)nk;
+    // multiplication and wrapping are separated to let compiler vectorize the first loop
+    for(size_t r = 0; r < N; r += (size_t)nk)
+        for(int i = 0; i < nk; ++i) rad[r + i] = ((double)cnt[r + i] - z[i]) * k[i];
+    for(size_t i = 0; i < N; ++i) rad[i] = ang2half(rad[i]);
+}
+
 /**
  * @brief SSconvstat - convert stat from SSII format to human
  * @param s (i) - just read data
@@ -52,15 +83,21 @@ uint16_t SScalcChecksum(uint8_t *buf, int len){
  */
 void SSconvstat(const SSstat *s, mountdata_t *m, struct timespec *t){
     if(!s || !m || !t) return;
-    m->motXposition.val = X_MOT2RAD(s->Xmot);
-    m->motYposition.val = Y_MOT2RAD(s->Ymot);
+    // Xmot, Ymot, Xenc and Yenc are sequential in SSstat
+    int32_t cnt[SS_NCNT];
+    double rad[SS_NCNT];
+    memcpy(cnt, &s->Xmot, sizeof(cnt));
+    int nk = Inst->Conf.SepEncoder ? 2 : SS_NCNT;
+    SScnt2rad(&Inst->ss, SS_XMOT, nk, cnt, rad, 1);
+    m->motXposition.val = rad[SS_XMOT];
+    m->motYposition.val = rad[SS_YMOT];
     m->motXposition.t = m->motYposition.t = *t;
     // fill encoder data from here, as there's no separate enc thread
-    if(!Conf.SepEncoder){
+    if(!Inst->Conf.SepEncoder){
         DBG("ENCODER from SSII");
-        m->encXposition.val = Xenc2rad(s->Xenc);
+        m->encXposition.val = rad[SS_XENC];
         DBG("encx: %g", m->encXposition.val);
-        m->encYposition.val = Yenc2rad(s->Yenc);
+        m->encYposition.val = rad[SS_YENC];
         m->encXposition.t = m->encYposition.t = *t;
         getXspeed(); getYspeed();
     }
@@ -144,6 +181,14 @@ int SSsetterI(const char *cmd, int32_t ival){
     return SStextcmd(buf, NULL);
 }
 
+// send stop command with priority of motion commands
+static int stopcmd(const char *cmd){
+    data_t d;
+    d.buf = (uint8_t*) cmd;
+    d.len = d.maxlen = strlen(cmd);
+    return MountWriteReadCls(&d, NULL, 1, MCC_CMD_MOTION);
+}
+
 int SSstop(int emerg){
     FNAME();
     int i = 0;
@@ -151,8 +196,8 @@ int SSstop(int emerg){
     const char *cmdy = (emerg) ? CMD_EMSTOPY : CMD_STOPY;
     setStat(AXIS_GONNASTOP, AXIS_GONNASTOP);
     for(; i < 10; ++i){
-        if(!SStextcmd(cmdx, NULL)) continue;
-        if(SStextcmd(cmdy, NULL)) break;
+        if(!stopcmd(cmdx)) continue;
+        if(stopcmd(cmdy)) break;
     }
     if(i == 10) return FALSE;
     DBG("Stopped");
@@ -162,7 +207,9 @@ int SSstop(int emerg){
 // update motors' positions due to encoders'
 mcc_errcodes_t updateMotorPos(){
     mountdata_t md = {0};
-    if(Conf.RunModel) return MCC_E_OK;
+    if(Inst->Conf.RunModel) return MCC_E_OK;
+    // log has no answers to sync commands (they change nothing in recorded data)
+    if(Inst->Conf.ReplayPath) return MCC_E_OK;
     double t0 = timefromstart(), t = 0.;
     struct timespec curt;
     DBG("start @ %g", t0);
@@ -182,7 +229,7 @@ mcc_errcodes_t updateMotorPos(){
             if(md.Xstate != AXIS_STOPPED || md.Ystate != AXIS_STOPPED) return MCC_E_OK;
             DBG("got; t pos x/y: %ld/%ld; tnow: %ld", md.encXposition.t.tv_sec, md.encYposition.t.tv_sec, curt.tv_sec);
             mcc_errcodes_t OK = MCC_E_OK;
-            if(fabs(md.motXposition.val - md.encXposition.val) > Conf.EncodersDisagreement && md.Xstate == AXIS_STOPPED){
+            if(fabs(md.motXposition.val - md.encXposition.val) > Inst->Conf.EncodersDisagreement && md.Xstate == AXIS_STOPPED){
                 DBG("NEED to sync X: motors=%g, axis=%g", md.motXposition.val, md.encXposition.val);
                 DBG("new motsteps: %d", X_RAD2MOT(md.encXposition.val));
                 if(!SSsetterI(CMD_MOTXSET, X_RAD2MOT(md.encXposition.val))){
@@ -190,7 +237,7 @@ mcc_errcodes_t updateMotorPos(){
                     OK = MCC_E_FAILED;
                 }else DBG("Xpos sync OK, Dt=%g", t - t0);
             }
-            if(fabs(md.motYposition.val - md.encYposition.val) > Conf.EncodersDisagreement && md.Ystate == AXIS_STOPPED){
+            if(fabs(md.motYposition.val - md.encYposition.val) > Inst->Conf.EncodersDisagreement && md.Ystate == AXIS_STOPPED){
                 DBG("NEED to sync Y: motors=%g, axis=%g", md.motYposition.val, md.encYposition.val);
                 if(!SSsetterI(CMD_MOTYSET, Y_RAD2MOT(md.encYposition.val))){
                     DBG("Ypos sync failed!");
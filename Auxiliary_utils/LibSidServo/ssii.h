@@ -175,9 +175,35 @@
 // amount of consequent same coordinates to detect stop
 #define MOTOR_STOPPED_CNT       (19)
 
-// replace macros with global variables inited when config read
-extern int X_ENC_ZERO, Y_ENC_ZERO;
-extern double X_MOT_STEPSPERREV, Y_MOT_STEPSPERREV, X_ENC_STEPSPERREV, Y_ENC_STEPSPERREV;
+// counters of mount in order of SSstat fields
+typedef enum{
+    SS_XMOT,
+    SS_YMOT,
+    SS_XENC,
+    SS_YENC,
+    SS_NCNT
+} sscnt_t;
+
+// constants of mount inited when config read
+typedef struct{
+    int Xenczero, Yenczero;         // encoders' zero
+    double Xmotsteps, Ymotsteps;    // motors' steps per revolution
+    double Xencsteps, Yencsteps;    // axes' encoders steps per revolution (negative if reversed)
+    // derived by SSsetconst() to avoid divisions in conversions (indexes are sscnt_t)
+    double cnt0[SS_NCNT];           // zero of counter
+    double cnt2rad[SS_NCNT];        // counter tick to radians
+    double rad2cnt[SS_NCNT];        // radians to counter ticks
+} ssconst_t;
+// defaults until read from controller
+#define SS_DEFCONST     {.Xmotsteps = 13312000., .Ymotsteps = 17578668., .Xencsteps = 67108864., .Yencsteps = 67108864.}
+
+// replace macros with constants of current instance
+#define X_ENC_ZERO          (Inst->ss.Xenczero)
+#define Y_ENC_ZERO          (Inst->ss.Yenczero)
+#define X_MOT_STEPSPERREV   (Inst->ss.Xmotsteps)
+#define Y_MOT_STEPSPERREV   (Inst->ss.Ymotsteps)
+#define X_ENC_STEPSPERREV   (Inst->ss.Xencsteps)
+#define Y_ENC_STEPSPERREV   (Inst->ss.Yencsteps)
 
 // TODO: take it from settings?
 // steps per revolution (SSI - x4 - for SSI)
@@ -202,13 +228,14 @@ extern double X_MOT_STEPSPERREV, Y_MOT_STEPSPERREV, X_ENC_STEPSPERREV, Y_ENC_STE
 
 
 // encoder position to radians and back
-#define Xenc2rad(n)    ang2half(2.*M_PI * ((double)((n)-(X_ENC_ZERO))) / (X_ENC_STEPSPERREV))
-#define Yenc2rad(n)    ang2half(2.*M_PI * ((double)((n)-(Y_ENC_ZERO))) / (Y_ENC_STEPSPERREV))
-#define Xrad2enc(r)    ((uint32_t)((r) / 2./M_PI * (X_ENC_STEPSPERREV)))
-#define Yrad2enc(r)    ((uint32_t)((r) / 2./M_PI * (Y_ENC_STEPSPERREV)))
+#define Xenc2rad(n)    ang2half(((double)(n) - Inst->ss.cnt0[SS_XENC]) * Inst->ss.cnt2rad[SS_XENC])
+#define Yenc2rad(n)    ang2half(((double)(n) - Inst->ss.cnt0[SS_YENC]) * Inst->ss.cnt2rad[SS_YENC])
+#define Xrad2enc(r)    ((uint32_t)((r) * Inst->ss.rad2cnt[SS_XENC]))
+#define Yrad2enc(r)    ((uint32_t)((r) * Inst->ss.rad2cnt[SS_YENC]))
 
 // convert angle in radians to +-pi
 static inline __attribute__((always_inline)) double ang2half(double ang){
+    if(ang >= -M_PI && ang <= M_PI) return ang; // most of conversions: no need of slow fmod
     ang = fmod(ang, 2.*M_PI);
     if(ang < -M_PI) ang += 2.*M_PI;
     else if(ang > M_PI) ang -= 2.*M_PI;
@@ -223,10 +250,10 @@ static inline __attribute__((always_inline)) double ang2full(double ang){
 }
 
 // motor position to radians and back
-#define X_MOT2RAD(n)    ang2half(2. * M_PI * ((double)(n)) / (X_MOT_STEPSPERREV))
-#define Y_MOT2RAD(n)    ang2half(2. * M_PI * ((double)(n)) / (Y_MOT_STEPSPERREV))
-#define X_RAD2MOT(r)    ((int32_t)((r) / (2. * M_PI) * (X_MOT_STEPSPERREV)))
-#define Y_RAD2MOT(r)    ((int32_t)((r) / (2. * M_PI) * (Y_MOT_STEPSPERREV)))
+#define X_MOT2RAD(n)    ang2half((double)(n) * Inst->ss.cnt2rad[SS_XMOT])
+#define Y_MOT2RAD(n)    ang2half((double)(n) * Inst->ss.cnt2rad[SS_YMOT])
+#define X_RAD2MOT(r)    ((int32_t)((r) * Inst->ss.rad2cnt[SS_XMOT]))
+#define Y_RAD2MOT(r)    ((int32_t)((r) * Inst->ss.rad2cnt[SS_YMOT]))
 // motor speed in rad/s and back
 #define X_MOTSPD2RS(n)  (X_MOT2RAD(n) / 65536. * (SITECH_LOOP_FREQUENCY))
 #define Y_MOTSPD2RS(n)  (Y_MOT2RAD(n) / 65536. * (SITECH_LOOP_FREQUENCY))
@@ -341,6 +368,8 @@ typedef struct{
 } __attribute__((packed)) SSconfig;
 
 uint16_t SScalcChecksum(uint8_t *buf, int len);
+void SSsetconst(ssconst_t *c);
+void SScnt2rad(const ssconst_t *c, sscnt_t first, int nk, const int32_t *cnt, double *rad, size_t n);
 void SSconvstat(const SSstat *status, mountdata_t *mountdata, struct timespec *t);
 int SStextcmd(const char *cmd, data_t *answer);
 int SSrawcmd(const char *cmd, data_t *answer);
@@ -0,0 +1,103 @@
+/*
+ * This file is part of the libsidservo project.
+ * Copyright 2026 Edward V. Emelianov <edward.emelianoff@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Histograms of time intervals (latencies, periods etc): log2 of microseconds
+ */
+
+#include "main.h"
+#include "stats.h"
+
+/**
+ * @brief hist_add - add next value into histogram
+ * @param h - histogram
+ * @param dt - time interval, s (negative values counted as zero)
+ */
+void hist_add(hist_t *h, double dt){
+    if(!h) return;
+    uint_fast64_t ns = (dt > 0.) ? (uint_fast64_t)(dt * 1e9) : 0;
+    unsigned long long us = ns / 1000;
+    int bin = us ? 64 - __builtin_clzll(us) : 0;
+    if(bin >= MCC_HIST_NBINS) bin = MCC_HIST_NBINS - 1;
+    atomic_fetch_add_explicit(&h->bins[bin], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->sum, ns, memory_order_relaxed);
+    uint_fast64_t max = atomic_load_explicit(&h->max, memory_order_relaxed);
+    while(ns > max && !atomic_compare_exchange_weak_explicit(&h->max, &max, ns,
+                                                             memory_order_relaxed, memory_order_relaxed));
+    atomic_fetch_add_explicit(&h->n, 1, memory_order_release);
+}
+
+/**
+ * @brief hist_get - get current histogram state (values added while reading can be partially counted)
+ * @param h - histogram
+ * @param out (o) - its copy
+ */
+void hist_get(hist_t *h, mcc_hist_t *out){
+    if(!h || !out) return;
+    out->n = atomic_load_explicit(&h->n, memory_order_acquire);
+    for(int i = 0; i < MCC_HIST_NBINS; ++i)
+        out->bins[i] = atomic_load_explicit(&h->bins[i], memory_order_relaxed);
+    uint_fast64_t sum = atomic_load_explicit(&h->sum, memory_order_relaxed);
+    out->mean = out->n ? (double)sum / (double)out->n * 1e-9 : 0.;
+    out->max = (double)atomic_load_explicit(&h->max, memory_order_relaxed) * 1e-9;
+}
+
+// clear histogram
+void hist_clear(hist_t *h){
+    if(!h) return;
+    for(int i = 0; i < MCC_HIST_NBINS; ++i) atomic_store_explicit(&h->bins[i], 0, memory_order_relaxed);
+    atomic_store_explicit(&h->sum, 0, memory_order_relaxed);
+    atomic_store_explicit(&h->max, 0, memory_order_relaxed);
+    atomic_store_explicit(&h->n, 0, memory_order_release);
+}
+
+/**
+ * @brief getstats - get copy of all statistics
+ * @param s (o) - statistics
+ * @return errcode
+ */
+mcc_errcodes_t getstats(mcc_stats_t *s){
+    if(!s) return MCC_E_BADFORMAT;
+    hist_get(&Inst->Stats.mountJitter, &s->mountJitter);
+    hist_get(&Inst->Stats.encInterval, &s->encInterval);
+    hist_get(&Inst->Stats.enc2cmd, &s->enc2cmd);
+    hist_get(&Inst->Stats.pidPeriod, &s->pidPeriod);
+    hist_get(&Inst->Stats.trackPeriod, &s->trackPeriod);
+    for(int i = 0; i < MCC_CMD_AMOUNT; ++i){
+        hist_get(&Inst->Stats.cmdRTT[i], &s->cmdRTT[i]);
+        hist_get(&Inst->Stats.cmdLatency[i], &s->cmdLatency[i]);
+    }
+    for(int i = 0; i < 2; ++i) s->encHistDropped[i] = enchist_dropped(i);
+    s->asyncRejected = atomic_load_explicit(&Inst->Stats.asyncRejected, memory_order_relaxed);
+    return MCC_E_OK;
+}
+
+// clear all statistics
+void resetstats(){
+    hist_clear(&Inst->Stats.mountJitter);
+    hist_clear(&Inst->Stats.encInterval);
+    hist_clear(&Inst->Stats.enc2cmd);
+    hist_clear(&Inst->Stats.pidPeriod);
+    hist_clear(&Inst->Stats.trackPeriod);
+    for(int i = 0; i < MCC_CMD_AMOUNT; ++i){
+        hist_clear(&Inst->Stats.cmdRTT[i]);
+        hist_clear(&Inst->Stats.cmdLatency[i]);
+    }
+    enchist_resetdropped();
+    atomic_store_explicit(&Inst->Stats.asyncRejected, 0, memory_order_relaxed);
+}
@@ -0,0 +1,48 @@
+/*
+ * This file is part of the libsidservo project.
+ * Copyright 2026 Edward V. Emelianov <edward.emelianoff@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdatomic.h>
+
+#include "sidservo.h"
+
+// histogram of time intervals with lock-free counters (many writers, any readers)
+typedef struct{
+    atomic_uint_fast64_t bins[MCC_HIST_NBINS];
+    atomic_uint_fast64_t n;         // amount of values
+    atomic_uint_fast64_t sum;       // sum of values, ns
+    atomic_uint_fast64_t max;       // max value, ns
+} hist_t;
+
+// all statistics of library
+typedef struct{
+    hist_t mountJitter;
+    hist_t encInterval;
+    hist_t enc2cmd;
+    hist_t pidPeriod;
+    hist_t trackPeriod;
+    hist_t cmdRTT[MCC_CMD_AMOUNT];
+    hist_t cmdLatency[MCC_CMD_AMOUNT];
+    atomic_uint_fast64_t asyncRejected; // asynchronous commands refused by full queue
+} stats_t;
+
+void hist_add(hist_t *h, double dt);
+void hist_get(hist_t *h, mcc_hist_t *out);
+void hist_clear(hist_t *h);
+mcc_errcodes_t getstats(mcc_stats_t *s);
+void resetstats();
@@ -0,0 +1,250 @@
+/*
+ * This file is part of the libsidservo project.
+ * Copyright 2026 Edward V. Emelianov <edward.emelianoff@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Recording of binary telemetry log: library threads put records into ring buffer (time of record is set under its
+ * mutex, so records are sorted by time), writer thread saves them, so I/O never blocks mount and encoders' loops.
+ */
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "main.h"
+#include "telelog.h"
+
+// writer thread: saves all records from ring, exits after all saved and `running` cleared
+static void *writer(void *inst){
+    Inst = (mntinst_t*)inst;
+    pthread_mutex_lock(&Inst->tlog.mutex);
+    while(1){
+        if(Inst->tlog.head == Inst->tlog.tail){
+            if(!Inst->tlog.running) break;
+            pthread_cond_wait(&Inst->tlog.cond, &Inst->tlog.mutex);
+            continue;
+        }
+        // contiguous part of ring
+        size_t tail = Inst->tlog.tail, n = (Inst->tlog.head > tail) ? Inst->tlog.head - tail : TLOG_RINGSZ - tail;
+        pthread_mutex_unlock(&Inst->tlog.mutex);
+        size_t w = fwrite(&Inst->tlog.ring[tail], sizeof(tlog_rec_t), n, Inst->tlog.f);
+        pthread_mutex_lock(&Inst->tlog.mutex);
+        if(w != n) Inst->tlog.dropped += n - w;
+        Inst->tlog.nrec += w;
+        Inst->tlog.tail = (tail + n) % TLOG_RINGSZ;
+    }
+    pthread_mutex_unlock(&Inst->tlog.mutex);
+    fflush(Inst->tlog.f);
+    return NULL;
+}
+
+/**
+ * @brief tlog_open - start recording (previous record is closed)
+ * @param path - file name
+ * @return FALSE if failed
+ */
+int tlog_open(const char *path){
+    if(!path) return FALSE;
+    tlog_close();
+    FILE *f = fopen(path, "w+");
+    if(!f){
+        DBG("Can't open %s", path);
+        return FALSE;
+    }
+    tlog_rec_t *ring = calloc(TLOG_RINGSZ, sizeof(tlog_rec_t));
+    // header has size of record
+    tlog_rec_t h0 = {0};
+    tlog_hdr_t *hdr = (tlog_hdr_t*)&h0;
+    memcpy(hdr->magic, TLOG_MAGIC, sizeof(hdr->magic));
+    hdr->version = TLOG_VERSION;
+    hdr->recsize = sizeof(tlog_rec_t);
+    inittime(&hdr->start);
+    if(!ring || 1 != fwrite(&h0, sizeof(h0), 1, f)){
+        free(ring);
+        fclose(f);
+        return FALSE;
+    }
+    pthread_mutex_lock(&Inst->tlog.mutex);
+    Inst->tlog.f = f;
+    Inst->tlog.ring = ring;
+    Inst->tlog.head = Inst->tlog.tail = 0;
+    Inst->tlog.nrec = Inst->tlog.dropped = 0;
+    Inst->tlog.running = 1;
+    int ret = TRUE;
+    if(pthread_create(&Inst->tlog.thread, NULL, writer, Inst)){
+        DBG("Can't create writer thread");
+        Inst->tlog.running = 0;
+        Inst->tlog.f = NULL;
+        Inst->tlog.ring = NULL;
+        fclose(f);
+        free(ring);
+        ret = FALSE;
+    }else atomic_store(&Inst->tlog.recording, 1);
+    pthread_mutex_unlock(&Inst->tlog.mutex);
+    return ret;
+}
+
+// stop recording and save amount of records into header
+void tlog_close(){
+    pthread_mutex_lock(&Inst->tlog.mutex);
+    if(!Inst->tlog.running){
+        pthread_mutex_unlock(&Inst->tlog.mutex);
+        return;
+    }
+    atomic_store(&Inst->tlog.recording, 0);
+    Inst->tlog.running = 0;
+    pthread_cond_signal(&Inst->tlog.cond);
+    pthread_mutex_unlock(&Inst->tlog.mutex);
+    pthread_join(Inst->tlog.thread, NULL);
+    tlog_hdr_t hdr;
+    if(0 == fseek(Inst->tlog.f, 0, SEEK_SET) && 1 == fread(&hdr, sizeof(hdr), 1, Inst->tlog.f)){
+        hdr.nrec = Inst->tlog.nrec;
+        hdr.dropped = Inst->tlog.dropped;
+        if(0 == fseek(Inst->tlog.f, 0, SEEK_SET)) fwrite(&hdr, sizeof(hdr), 1, Inst->tlog.f);
+    }
+    DBG("Saved %zd records, %zd dropped", (size_t)Inst->tlog.nrec, (size_t)Inst->tlog.dropped);
+    fclose(Inst->tlog.f);
+    Inst->tlog.f = NULL;
+    free(Inst->tlog.ring);
+    Inst->tlog.ring = NULL;
+}
+
+// get next free record of ring (with locked mutex) or NULL if ring is full
+static tlog_rec_t *newrec(tlog_rectype_t type){
+    size_t next = (Inst->tlog.head + 1) % TLOG_RINGSZ;
+    if(!Inst->tlog.running || next == Inst->tlog.tail){
+        ++Inst->tlog.dropped;
+        return NULL;
+    }
+    tlog_rec_t *r = &Inst->tlog.ring[Inst->tlog.head];
+    memset(r, 0, sizeof(tlog_rec_t)); // the same data gives the same file
+    r->t = timefromstart();
+    r->type = type;
+    return r;
+}
+// put record into ring
+static void putrec(){
+    Inst->tlog.head = (Inst->tlog.head + 1) % TLOG_RINGSZ;
+    pthread_cond_signal(&Inst->tlog.cond);
+}
+
+/**
+ * @brief tlog_md - record new mount data
+ * @param md - data
+ */
+void tlog_md(const mountdata_t *md){
+    if(!atomic_load_explicit(&Inst->tlog.recording, memory_order_relaxed) || !md) return;
+    pthread_mutex_lock(&Inst->tlog.mutex);
+    tlog_rec_t *r = newrec(TLOG_MOUNTDATA);
+    if(r){
+        r->md = *md;
+        putrec();
+    }
+    pthread_mutex_unlock(&Inst->tlog.mutex);
+}
+
+/**
+ * @brief tlog_io - record transaction with mount
+ * @param out - data sent (or NULL)
+ * @param eol - ==1 if "\r" was sent after data
+ * @param in - data got (or NULL)
+ * @param ret - result of transaction
+ */
+void tlog_io(const data_t *out, int eol, const data_t *in, int ret){
+    if(!atomic_load_explicit(&Inst->tlog.recording, memory_order_relaxed)) return;
+    pthread_mutex_lock(&Inst->tlog.mutex);
+    tlog_rec_t *r = newrec(TLOG_MNTIO);
+    if(r){
+        tlog_io_t *io = &r->io;
+        size_t lo = out ? out->len : 0, li = in ? in->len : 0;
+        if(in && li > in->maxlen) li = in->maxlen;
+        if(lo > TLOG_IOBUFSZ) lo = TLOG_IOBUFSZ;
+        if(li > TLOG_IOBUFSZ - lo) li = TLOG_IOBUFSZ - lo;
+        io->truncated = (out && lo != out->len) || (in && li != in->len);
+        if(lo) memcpy(io->buf, out->buf, lo);
+        if(li) memcpy(io->buf + lo, in->buf, li);
+        io->outlen = (uint16_t)lo;
+        io->inlen = (uint16_t)li;
+        io->eol = eol ? 1 : 0;
+        io->ret = ret ? 1 : 0;
+        putrec();
+    }
+    pthread_mutex_unlock(&Inst->tlog.mutex);
+}
+
+/**
+ * @brief tlog_map - map log file into memory (read only)
+ * @param path - file name
+ * @param m (o) - mapped log
+ * @return FALSE if file can't be opened or has wrong format
+ */
+int tlog_map(const char *path, tlog_map_t *m){
+    if(!path || !m) return FALSE;
+    bzero(m, sizeof(tlog_map_t));
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) return FALSE;
+    struct stat st;
+    if(fstat(fd, &st) || (size_t)st.st_size < sizeof(tlog_rec_t)){
+        close(fd);
+        return FALSE;
+    }
+    void *addr = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(addr == MAP_FAILED) return FALSE;
+    const tlog_hdr_t *hdr = (const tlog_hdr_t*)addr;
+    if(memcmp(hdr->magic, TLOG_MAGIC, sizeof(hdr->magic)) || hdr->version != TLOG_VERSION ||
+       hdr->recsize != sizeof(tlog_rec_t)){
+        DBG("Wrong format of %s", path);
+        munmap(addr, st.st_size);
+        return FALSE;
+    }
+    m->addr = addr;
+    m->size = st.st_size;
+    m->hdr = hdr;
+    m->rec = (const tlog_rec_t*)addr + 1;
+    // amount of records by file size (log could be not closed)
+    m->nrec = st.st_size / sizeof(tlog_rec_t) - 1;
+    return TRUE;
+}
+
+void tlog_unmap(tlog_map_t *m){
+    if(!m || !m->addr) return;
+    munmap(m->addr, m->size);
+    bzero(m, sizeof(tlog_map_t));
+}
+
+/**
+ * @brief tlog_find - find first record with time not less than `t`
+ * @param m - mapped log
+ * @param t - time from init(), s
+ * @return index of record (m->nrec if all records are earlier)
+ */
+size_t tlog_find(const tlog_map_t *m, double t){
+    if(!m || !m->rec) return 0;
+    size_t l = 0, r = m->nrec;
+    while(l < r){
+        size_t mid = (l + r) / 2;
+        if(m->rec[mid].t < t) l = mid + 1;
+        else r = mid;
+    }
+    return l;
+}
@@ -0,0 +1,104 @@
+/*
+ * This file is part of the libsidservo project.
+ * Copyright 2026 Edward V. Emelianov <edward.emelianoff@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "sidservo.h"
+
+/*
+ * Binary telemetry log: header and records have the same size, so record `i` is at offset (i+1)*recsize and file
+ * can be used through mmap() as array. Records are sorted by time, so they are index by time themselves.
+ */
+
+#define TLOG_MAGIC      "SIDSTLOG"
+#define TLOG_VERSION    (1)
+// amount of records in writer's ring buffer
+#define TLOG_RINGSZ     (8192)
+// size of I/O data in record (output + input)
+#define TLOG_IOBUFSZ    (280)
+
+typedef enum{
+    TLOG_MOUNTDATA,     // new mountdata_t
+    TLOG_MNTIO,         // transaction with mount
+    TLOG_AMOUNT
+} tlog_rectype_t;
+
+// transaction with mount: `outlen` bytes sent, then `inlen` bytes got
+typedef struct{
+    uint16_t outlen;
+    uint16_t inlen;
+    uint8_t eol;        // ==1 if "\r" was added after output
+    uint8_t ret;        // result of transaction (TRUE/FALSE)
+    uint8_t truncated;  // ==1 if data didn't fit into buffer
+    uint8_t reserved;
+    uint8_t buf[TLOG_IOBUFSZ];
+} tlog_io_t;
+
+typedef struct{
+    double t;           // time from init(), s
+    uint32_t type;      // tlog_rectype_t
+    uint32_t reserved;
+    union{
+        mountdata_t md;
+        tlog_io_t io;
+    };
+} tlog_rec_t;
+
+typedef struct{
+    char magic[8];      // TLOG_MAGIC
+    uint32_t version;   // TLOG_VERSION
+    uint32_t recsize;   // sizeof(tlog_rec_t)
+    uint64_t nrec;      // amount of records (0 if log wasn't closed)
+    uint64_t dropped;   // amount of records dropped due to ring buffer overflow
+    struct timespec start; // time of init() (t=0 of records)
+} tlog_hdr_t;
+
+// log mapped into memory
+typedef struct{
+    void *addr;
+    size_t size;
+    const tlog_hdr_t *hdr;
+    const tlog_rec_t *rec;
+    size_t nrec;
+} tlog_map_t;
+
+// recording of log
+typedef struct{
+    FILE *f;
+    tlog_rec_t *ring;
+    size_t head, tail;      // write and read positions in ring
+    uint64_t nrec, dropped;
+    int running;            // ==1 while writer works
+    pthread_t thread;
+    atomic_int recording;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+} tlog_state_t;
+
+int tlog_open(const char *path);
+void tlog_close();
+void tlog_md(const mountdata_t *md);
+void tlog_io(const data_t *out, int eol, const data_t *in, int ret);
+int tlog_map(const char *path, tlog_map_t *m);
+void tlog_unmap(tlog_map_t *m);
+size_t tlog_find(const tlog_map_t *m, double t);
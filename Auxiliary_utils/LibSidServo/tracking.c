@@ -0,0 +1,193 @@
+/*
+ * This file is part of the libsidservo project.
+ * Copyright 2026 Edward V. Emelianov <edward.emelianoff@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Tracking engine: each `interval` seconds sends long command with target position at the moment of command
+ * arrival and adders equal to mean trajectory speed till the next command, so controller moves target by itself
+ * between commands (by chord of trajectory). Adders' time is `lookahead` > `interval`: if commands stop coming,
+ * mount continues moving with the same speed and stops after `lookahead` seconds.
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#include "main.h"
+#include "pec.h"
+#include "serial.h"
+#include "tracking.h"
+#include "vclock.h"
+
+/**
+ * @brief motofs - refresh filtered offset between motors' and axes' positions (commands are in motors' coordinates);
+ *      periodic error is excluded if it's corrected
+ * @param ofs (io) - offset
+ * @param first - ==1 for first call (then offset is set without filtering)
+ * @return FALSE if no data
+ */
+static int motofs(coordpair_t *ofs, int first){
+    mountdata_t m;
+    if(MCC_E_OK != getMD(&m) || m.motXposition.t.tv_sec == 0 || m.encXposition.t.tv_sec == 0) return FALSE;
+    // axes' positions at time of motors' measurement
+    double dX = m.motXposition.val - m.encXposition.val - m.encXspeed.val * timediff(&m.motXposition.t, &m.encXposition.t)
+        + pec_corr(0, m.motXposition.val);
+    double dY = m.motYposition.val - m.encYposition.val - m.encYspeed.val * timediff(&m.motYposition.t, &m.encYposition.t)
+        + pec_corr(1, m.motYposition.val);
+    if(first){
+        ofs->X = dX; ofs->Y = dY;
+    }else{
+        ofs->X += (dX - ofs->X) * TRACK_OFFSET_K;
+        ofs->Y += (dY - ofs->Y) * TRACK_OFFSET_K;
+    }
+    return TRUE;
+}
+
+// main tracking thread
+static void *trackthread(void *inst){
+    Inst = (mntinst_t*)inst;
+    setrt();
+    vclock_attach(Inst->trk.slot);
+    const mcc_track_t *p = &Inst->trk.par;
+    double T = p->interval, tprev = -1.;
+    coordpair_t ofs = {0};
+    int errctr = 0, ofsinited = 0;
+    struct timespec deadline;
+    vclock_now(&deadline);
+    while(atomic_load(&Inst->trk.running)){
+        // command will be applied after queueing and transmission
+        mcc_hist_t lat;
+        hist_get(&Inst->Stats.cmdLatency[MCC_CMD_MOTION], &lat);
+        double t = timefromstart() + lat.mean;
+        coordpair_t p0, p1;
+        if(!p->traject(t, &p0, p->arg) || !p->traject(t + T, &p1, p->arg)){
+            DBG("Trajectory ends");
+            break;
+        }
+        if(!Inst->Conf.RunModel){
+            if(motofs(&ofs, !ofsinited)) ofsinited = 1;
+        }
+        // motors' targets: periodic error of axes is compensated by motors (and its derivative - by adders)
+        p0.X += ofs.X; p0.Y += ofs.Y; p1.X += ofs.X; p1.Y += ofs.Y;
+        p0.X -= pec_corr(0, p0.X); p0.Y -= pec_corr(1, p0.Y);
+        p1.X -= pec_corr(0, p1.X); p1.Y -= pec_corr(1, p1.Y);
+        long_command_t c = {
+            .Xmot = p0.X, .Ymot = p0.Y,
+            .Xspeed = Inst->Xlimits.max.speed, .Yspeed = Inst->Ylimits.max.speed,
+            .Xadder = (p1.X - p0.X) / T, .Yadder = (p1.Y - p0.Y) / T,
+            .Xatime = p->lookahead, .Yatime = p->lookahead
+        };
+        if(fabs(c.Xadder) > Inst->Xlimits.max.speed || fabs(c.Yadder) > Inst->Ylimits.max.speed){
+            DBG("Trajectory is too fast: %g/%g rad/s", c.Xadder, c.Yadder);
+            break;
+        }
+        if(MCC_E_OK != longcmd(&c)){
+            DBG("Long command failed");
+            if(++errctr >= TRACK_MAX_ERRORS) break;
+        }else errctr = 0;
+        double tnow = timefromstart();
+        if(tprev >= 0.) hist_add(&Inst->Stats.trackPeriod, tnow - tprev);
+        tprev = tnow;
+        if(!period_wait(&deadline, p->interval, NULL)){DBG("Tracking command is late");}
+    }
+    atomic_store(&Inst->trk.running, 0);
+    vclock_release();
+    DBG("Tracking thread exit");
+    return NULL;
+}
+
+/**
+ * @brief track_stop - stop tracking engine
+ * @return errcode
+ */
+mcc_errcodes_t track_stop(){
+    pthread_mutex_lock(&Inst->trk.mutex);
+    atomic_store(&Inst->trk.running, 0);
+    if(Inst->trk.started){
+        vclock_interrupt(Inst->trk.slot); // don't wait for virtual time
+        pthread_join(Inst->trk.thread, NULL);
+        Inst->trk.started = 0;
+    }
+    pthread_mutex_unlock(&Inst->trk.mutex);
+    return MCC_E_OK;
+}
+
+/**
+ * @brief track_start - start tracking engine (previous tracking is stopped)
+ * @param t - parameters
+ * @return errcode
+ */
+mcc_errcodes_t track_start(const mcc_track_t *t){
+    if(!t || !t->traject || t->interval < 0. || t->lookahead < 0.) return MCC_E_BADFORMAT;
+    mcc_track_t par = *t;
+    if(par.interval == 0.) par.interval = Inst->Conf.MountReqInterval;
+    if(par.lookahead == 0.) par.lookahead = 3. * par.interval;
+    if(par.interval <= 0. || par.lookahead <= par.interval){
+        DBG("Adders time should be larger than commands' interval");
+        return MCC_E_BADFORMAT;
+    }
+    track_stop();
+    pthread_mutex_lock(&Inst->trk.mutex);
+    mcc_errcodes_t ret = MCC_E_OK;
+    Inst->trk.par = par;
+    atomic_store(&Inst->trk.running, 1);
+    Inst->trk.slot = vclock_register();
+    if(pthread_create(&Inst->trk.thread, NULL, trackthread, Inst)){
+        DBG("Can't create tracking thread");
+        vclock_unregister(Inst->trk.slot);
+        atomic_store(&Inst->trk.running, 0);
+        ret = MCC_E_FATAL;
+    }else Inst->trk.started = 1;
+    pthread_mutex_unlock(&Inst->trk.mutex);
+    return ret;
+}
+
+/**
+ * @brief traj_spline - cubic Hermite (Catmull-Rom) spline by samples; tangents by neighbours
+ * @param t - time
+ * @param pos (o) - position
+ * @param samples - mcc_trajsamples_t
+ * @return FALSE if `t` is out of samples' time range
+ */
+int traj_spline(double t, coordpair_t *pos, void *samples){
+    const mcc_trajsamples_t *s = (const mcc_trajsamples_t*)samples;
+    if(!s || !pos || s->n < 2 || t < s->t[0] || t > s->t[s->n - 1]) return FALSE;
+    // find interval [t[i], t[i+1]] containing `t`
+    size_t i = 0, r = s->n - 1;
+    while(r - i > 1){
+        size_t m = (i + r) / 2;
+        if(s->t[m] > t) r = m;
+        else i = m;
+    }
+    double h = s->t[i+1] - s->t[i];
+    if(h <= 0.) return FALSE;
+    // tangents
+    size_t i0 = i ? i - 1 : i, i2 = (i + 2 < s->n) ? i + 2 : i + 1;
+    double dt1 = s->t[i+1] - s->t[i0], dt2 = s->t[i2] - s->t[i];
+    coordpair_t m1, m2;
+    m1.X = (s->pos[i+1].X - s->pos[i0].X) / dt1;
+    m1.Y = (s->pos[i+1].Y - s->pos[i0].Y) / dt1;
+    m2.X = (s->pos[i2].X - s->pos[i].X) / dt2;
+    m2.Y = (s->pos[i2].Y - s->pos[i].Y) / dt2;
+    // Hermite basis
+    double x = (t - s->t[i]) / h, x2 = x * x, x3 = x2 * x;
+    double h00 = 2.*x3 - 3.*x2 + 1., h10 = (x3 - 2.*x2 + x) * h, h01 = 3.*x2 - 2.*x3, h11 = (x3 - x2) * h;
+    pos->X = h00 * s->pos[i].X + h10 * m1.X + h01 * s->pos[i+1].X + h11 * m2.X;
+    pos->Y = h00 * s->pos[i].Y + h10 * m1.Y + h01 * s->pos[i+1].Y + h11 * m2.Y;
+    return TRUE;
+}
@@ -0,0 +1,43 @@
+/*
+ * This file is part of the libsidservo project.
+ * Copyright 2026 Edward V. Emelianov <edward.emelianoff@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "sidservo.h"
+
+// max amount of subsequent failed commands before tracking stops
+#define TRACK_MAX_ERRORS    (5)
+// coefficient of exponential filter for motors' and axes' encoders offset
+#define TRACK_OFFSET_K      (0.1)
+
+// tracking engine
+typedef struct{
+    mcc_track_t par;
+    pthread_t thread;
+    int started;            // ==1 if thread should be joined
+    int slot;               // slot in virtual clock
+    atomic_int running;     // ==1 while thread works
+    pthread_mutex_t mutex;
+} track_state_t;
+
+mcc_errcodes_t track_start(const mcc_track_t *t);
+mcc_errcodes_t track_stop();
+int traj_spline(double t, coordpair_t *pos, void *samples);
@@ -0,0 +1,258 @@
+/*
+ * This file is part of the libsidservo project.
+ * Copyright 2026 Edward V. Emelianov <edward.emelianoff@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Clock source of library. Real clock is CLOCK_MONOTONIC/CLOCK_REALTIME. Virtual clock (model mode only) goes
+ * only when some thread, which isn't library's thread, sleeps or calls advanceClock(): time moves in steps to the
+ * nearest deadline of sleeping library threads, and next step begins only after all woken threads fall asleep
+ * again. So result of simulation doesn't depend on CPU load and it runs as fast as CPU can.
+ * Library threads working by virtual clock should be registered by their creator before pthread_create()
+ * (vclock_register()) and attach the slot at start (vclock_attach()).
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+
+#include "main.h"
+#include "vclock.h"
+
+// library thread working by virtual clock
+typedef struct{
+    int used;                   // slot is busy
+    int sleeping;               // thread sleeps till `deadline`
+    int interrupted;            // thread should exit: don't sleep anymore
+    struct timespec deadline;
+} vslot_t;
+
+static struct{
+    mcc_clock_t par;
+    struct timespec now;        // current virtual time (monotonic)
+    struct timespec start;      // `now` at clock start (for realtime calculation)
+    int running;                // amount of registered threads not sleeping
+    vslot_t slots[VCLOCK_MAXTHREADS];
+} vclk = {0};
+static pthread_mutex_t vmutex = PTHREAD_MUTEX_INITIALIZER,
+    advmutex = PTHREAD_MUTEX_INITIALIZER;       // only one thread can advance clock
+static pthread_cond_t tickcond = PTHREAD_COND_INITIALIZER, // time changed
+    idlecond = PTHREAD_COND_INITIALIZER;        // some thread fall asleep
+static __thread int myslot = -1;                // slot of current thread
+
+// TRUE if virtual clock used
+int vclock_active(){
+    return (vclk.par.source == MCC_CLOCK_VIRTUAL);
+}
+
+// seed of model's noise
+uint32_t vclock_seed(){
+    return vclk.par.seed;
+}
+
+// monotonic time (CLOCK_MONOTONIC or virtual)
+void vclock_now(struct timespec *t){
+    if(!t) return;
+    if(!vclock_active()){
+        clock_gettime(CLOCK_MONOTONIC, t);
+        return;
+    }
+    pthread_mutex_lock(&vmutex);
+    *t = vclk.now;
+    pthread_mutex_unlock(&vmutex);
+}
+
+// UNIX time (CLOCK_REALTIME or virtual)
+void vclock_realtime(struct timespec *t){
+    if(!t) return;
+    if(!vclock_active()){
+        clock_gettime(CLOCK_REALTIME, t);
+        return;
+    }
+    pthread_mutex_lock(&vmutex);
+    *t = vclk.par.start;
+    tsshift(t, timediff(&vclk.now, &vclk.start));
+    pthread_mutex_unlock(&vmutex);
+}
+
+static inline int tsless(const struct timespec *a, const struct timespec *b){
+    return (a->tv_sec < b->tv_sec || (a->tv_sec == b->tv_sec && a->tv_nsec < b->tv_nsec));
+}
+
+/**
+ * @brief advance_to - move virtual time to `target` by steps to nearest deadlines of library threads waking them
+ *          one by one (vmutex should be locked)
+ * @param target - end time
+ */
+static void advance_to(const struct timespec *target){
+    while(1){
+        // wait while all threads fall asleep
+        while(vclk.running > 0) pthread_cond_wait(&idlecond, &vmutex);
+        // thread with the earliest deadline (so threads run one by one in the same order each time)
+        int first = -1;
+        for(int i = 0; i < VCLOCK_MAXTHREADS; ++i){
+            vslot_t *s = &vclk.slots[i];
+            if(!s->used || !s->sleeping || tsless(target, &s->deadline)) continue;
+            if(first < 0 || tsless(&s->deadline, &vclk.slots[first].deadline)) first = i;
+        }
+        if(first < 0){
+            if(tsless(&vclk.now, target)) vclk.now = *target;
+            break;
+        }
+        vslot_t *s = &vclk.slots[first];
+        if(tsless(&vclk.now, &s->deadline)) vclk.now = s->deadline;
+        s->sleeping = 0;
+        ++vclk.running;
+        pthread_cond_broadcast(&tickcond);
+    }
+}
+
+/**
+ * @brief vclock_sleepuntil - sleep till given monotonic time; with virtual clock library threads wait for
+ *          the time while other threads move clock to it
+ * @param deadline - time to wake up
+ * @return FALSE if thread was interrupted (and should exit)
+ */
+int vclock_sleepuntil(const struct timespec *deadline){
+    if(!deadline) return FALSE;
+    if(!vclock_active()){
+        while(EINTR == clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, deadline, NULL));
+        return TRUE;
+    }
+    if(myslot < 0){ // not library's thread: move clock itself
+        pthread_mutex_lock(&advmutex);
+        pthread_mutex_lock(&vmutex);
+        advance_to(deadline);
+        pthread_mutex_unlock(&vmutex);
+        pthread_mutex_unlock(&advmutex);
+        return TRUE;
+    }
+    int ret = TRUE;
+    pthread_mutex_lock(&vmutex);
+    vslot_t *s = &vclk.slots[myslot];
+    if(s->interrupted) ret = FALSE;
+    else if(tsless(&vclk.now, deadline)){
+        s->deadline = *deadline;
+        s->sleeping = 1;
+        --vclk.running;
+        pthread_cond_signal(&idlecond);
+        while(s->sleeping && !s->interrupted) pthread_cond_wait(&tickcond, &vmutex);
+        if(s->sleeping){ // interrupted
+            s->sleeping = 0;
+            ++vclk.running;
+            ret = FALSE;
+        }
+    }
+    pthread_mutex_unlock(&vmutex);
+    return ret;
+}
+
+/**
+ * @brief vclock_register - reserve slot for new library thread (call before its creation)
+ * @return slot number or -1 for real clock (or if there's no free slots)
+ */
+int vclock_register(){
+    if(!vclock_active()) return -1;
+    int slot = -1;
+    pthread_mutex_lock(&vmutex);
+    for(int i = 0; i < VCLOCK_MAXTHREADS; ++i){
+        if(vclk.slots[i].used) continue;
+        bzero(&vclk.slots[i], sizeof(vslot_t));
+        vclk.slots[i].used = 1;
+        ++vclk.running; // thread runs till its first sleep
+        slot = i;
+        break;
+    }
+    pthread_mutex_unlock(&vmutex);
+    if(slot < 0){DBG("No free slots for thread");}
+    return slot;
+}
+
+// free slot (if thread wasn't created or exits)
+void vclock_unregister(int slot){
+    if(slot < 0 || slot >= VCLOCK_MAXTHREADS) return;
+    pthread_mutex_lock(&vmutex);
+    vslot_t *s = &vclk.slots[slot];
+    if(s->used){
+        if(!s->sleeping) --vclk.running;
+        s->used = 0;
+        pthread_cond_signal(&idlecond);
+    }
+    pthread_mutex_unlock(&vmutex);
+}
+
+// attach current thread to slot got by vclock_register()
+void vclock_attach(int slot){
+    myslot = slot;
+}
+
+// detach current thread from virtual clock (before exit)
+void vclock_release(){
+    vclock_unregister(myslot);
+    myslot = -1;
+}
+
+// wake up thread of given slot and don't let it sleep anymore (before pthread_join())
+void vclock_interrupt(int slot){
+    if(slot < 0 || slot >= VCLOCK_MAXTHREADS) return;
+    pthread_mutex_lock(&vmutex);
+    if(vclk.slots[slot].used){
+        vclk.slots[slot].interrupted = 1;
+        pthread_cond_broadcast(&tickcond);
+    }
+    pthread_mutex_unlock(&vmutex);
+}
+
+/**
+ * @brief vclock_set - set clock source (library threads shouldn't run)
+ * @param c - clock parameters
+ * @return errcode
+ */
+mcc_errcodes_t vclock_set(const mcc_clock_t *c){
+    if(!c || c->source < MCC_CLOCK_REAL || c->source > MCC_CLOCK_VIRTUAL) return MCC_E_BADFORMAT;
+    pthread_mutex_lock(&vmutex);
+    for(int i = 0; i < VCLOCK_MAXTHREADS; ++i){
+        if(vclk.slots[i].used){
+            pthread_mutex_unlock(&vmutex);
+            DBG("Library threads work by virtual clock");
+            return MCC_E_FAILED;
+        }
+    }
+    vclk.par = *c;
+    if(c->source == MCC_CLOCK_VIRTUAL){
+        // start from zero: the same times for the same simulations
+        vclk.now.tv_sec = 0; vclk.now.tv_nsec = 0;
+        vclk.start = vclk.now;
+        if(vclk.par.start.tv_sec == 0 && vclk.par.start.tv_nsec == 0) clock_gettime(CLOCK_REALTIME, &vclk.par.start);
+    }
+    pthread_mutex_unlock(&vmutex);
+    return MCC_E_OK;
+}
+
+/**
+ * @brief vclock_advance - advance virtual clock (or sleep if it's real)
+ * @param dt - time interval, s
+ * @return errcode
+ */
+mcc_errcodes_t vclock_advance(double dt){
+    if(dt < 0.) return MCC_E_BADFORMAT;
+    if(myslot > -1) return MCC_E_FAILED; // library thread can't move clock
+    struct timespec deadline;
+    vclock_now(&deadline);
+    tsshift(&deadline, dt);
+    vclock_sleepuntil(&deadline);
+    return MCC_E_OK;
+}
@@ -0,0 +1,39 @@
+/*
+ * This file is part of the libsidservo project.
+ * Copyright 2026 Edward V. Emelianov <edward.emelianoff@gmail.com>.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <time.h>
+
+#include "sidservo.h"
+
+// max amount of library threads working by virtual clock (mount and tracking threads of each mount)
+#define VCLOCK_MAXTHREADS   (2 * MCC_MAXMOUNTS)
+
+int vclock_active();
+void vclock_now(struct timespec *t);
+void vclock_realtime(struct timespec *t);
+uint32_t vclock_seed();
+int vclock_sleepuntil(const struct timespec *deadline);
+int vclock_register();
+void vclock_unregister(int slot);
+void vclock_attach(int slot);
+void vclock_release();
+void vclock_interrupt(int slot);
+mcc_errcodes_t vclock_set(const mcc_clock_t *c);
+mcc_errcodes_t vclock_advance(double dt);